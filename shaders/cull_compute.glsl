@@ -0,0 +1,126 @@
+#version 430 core
+
+// gpu-driven culling, see GpuCulling in src/gpu_culling.h. one invocation per object tests its
+// world bounds against the frustum, picks a lod by distance and appends the instance to that
+// lod's range of the output buffer. the instance count of each indirect draw is the cursor.
+
+layout (local_size_x = 64) in;
+
+// see InstanceData in src/instance.h
+struct Instance {
+    mat4 model;
+    vec4 tint;
+    vec4 anim; // x = animated, y = phase, z = speed multiplier
+};
+
+// DrawElementsIndirectCommand
+struct DrawCommand {
+    uint count;
+    uint instanceCount;
+    uint firstIndex;
+    int baseVertex;
+    uint baseInstance;
+};
+
+layout (std430, binding = 0) readonly buffer Instances {
+    Instance instances[];
+};
+
+// world aabb per object, min.xyz then max.xyz
+layout (std430, binding = 1) readonly buffer Bounds {
+    float bounds[];
+};
+
+layout (std430, binding = 2) writeonly buffer Visible {
+    Instance visible[];
+};
+
+layout (std430, binding = 3) buffer Commands {
+    DrawCommand commands[4];
+    uint visibleCount;
+};
+
+// per-frame state shared by every program, see FrameUniforms in src/frame_uniforms.h
+layout (std140) uniform Frame {
+    mat4 uView;
+    mat4 uProjection;
+    mat4 uViewProjection;
+    bool uRotateAnimX;
+    bool uRotateAnimY;
+    bool uRotateAnimZ;
+    float uTime;
+    float uAnimSpeed;
+};
+
+uniform int uObjectCount;
+uniform int uLodCount;
+uniform float uLodDistance; // distance covered by each lod, 0 keeps lod 0
+uniform vec3 uCameraPos;
+uniform bool uCull;
+uniform bool uAnimate; // compose the animation rotation like animateInstances() in src/instance.h
+
+bool outsideFrustum(vec3 c, vec3 e)
+{
+    vec4 row[4];
+    for (int i = 0; i < 4; i++) {
+        row[i] = vec4(uViewProjection[0][i], uViewProjection[1][i], uViewProjection[2][i], uViewProjection[3][i]);
+    }
+
+    vec4 planes[6] = vec4[6](row[3] + row[0], row[3] - row[0], row[3] + row[1], row[3] - row[1], row[3] + row[2], row[3] - row[2]);
+    for (int i = 0; i < 6; i++) {
+        vec4 p = planes[i] / length(planes[i].xyz);
+        if (dot(p.xyz, c) + p.w < -dot(abs(p.xyz), e)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// X first, then Y, then Z, the same matrices as the ROTATE_X/Y/Z variants of vertex.glsl
+mat4 animRotation(float angle)
+{
+    float s = sin(angle);
+    float c = cos(angle);
+
+    mat4 rot = mat4(1.0);
+    if (uRotateAnimZ) {
+        rot = rot * mat4(c, -s, 0.0, 0.0, s, c, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 0.0, 1.0);
+    }
+    if (uRotateAnimY) {
+        rot = rot * mat4(c, 0.0, s, 0.0, 0.0, 1.0, 0.0, 0.0, -s, 0.0, c, 0.0, 0.0, 0.0, 0.0, 1.0);
+    }
+    if (uRotateAnimX) {
+        rot = rot * mat4(1.0, 0.0, 0.0, 0.0, 0.0, c, -s, 0.0, 0.0, s, c, 0.0, 0.0, 0.0, 0.0, 1.0);
+    }
+    return rot;
+}
+
+void main()
+{
+    uint i = gl_GlobalInvocationID.x;
+    if (i >= uint(uObjectCount)) {
+        return;
+    }
+
+    vec3 lo = vec3(bounds[i * 6u + 0u], bounds[i * 6u + 1u], bounds[i * 6u + 2u]);
+    vec3 hi = vec3(bounds[i * 6u + 3u], bounds[i * 6u + 4u], bounds[i * 6u + 5u]);
+    vec3 center = (lo + hi) * 0.5;
+
+    if (uCull && outsideFrustum(center, (hi - lo) * 0.5)) {
+        return;
+    }
+
+    int lod = 0;
+    if (uLodDistance > 0.0) {
+        lod = min(uLodCount - 1, int(distance(uCameraPos, center) / uLodDistance));
+    }
+
+    Instance inst = instances[i];
+    if (uAnimate && inst.anim.x > 0.5) {
+        inst.model = inst.model * animRotation(uTime * uAnimSpeed * inst.anim.z + inst.anim.y);
+    }
+
+    uint slot = atomicAdd(commands[lod].instanceCount, 1u);
+    atomicAdd(visibleCount, 1u);
+    visible[commands[lod].baseInstance + slot] = inst;
+}
@@ -0,0 +1,67 @@
+#version 330 core
+
+layout(std140) uniform Frame {
+    mat4 uView;
+    mat4 uProjection;
+    mat4 uViewProjection;
+    bool uRotateAnimX;
+    bool uRotateAnimY;
+    bool uRotateAnimZ;
+    float uTime;
+    float uAnimSpeed;
+};
+
+uniform mat4 uGridModel;
+uniform vec4 uGridColor;
+
+in vec3 vNear;
+in vec3 vFar;
+flat in vec3 vCamera;
+flat in float vSpacing;
+flat in float vBlend;
+flat in float vFade;
+
+out vec4 fragColor;
+
+// anti-aliased line coverage for lines every `spacing` units, about one pixel wide. lines
+// closer together than a few pixels fade out instead of turning into moire.
+float lines(vec2 coord, float spacing)
+{
+    vec2 c = coord / spacing;
+    vec2 width = fwidth(c);
+    vec2 d = abs(fract(c - 0.5) - 0.5) / width;
+    float density = 1.0 - smoothstep(0.1, 0.3, max(width.x, width.y));
+    return (1.0 - min(min(d.x, d.y), 1.0)) * density;
+}
+
+void main()
+{
+    // intersect the view ray with the y = 0 plane, rays pointing away from it see no grid.
+    // rays parallel to it would divide by zero, and a NaN passes the range test below
+    vec3 ray = vFar - vNear;
+    if (abs(ray.y) < 1e-6) {
+        discard;
+    }
+    float t = -vNear.y / ray.y;
+    if (t < 0.0 || t > 1.0) {
+        discard;
+    }
+
+    vec3 local = vNear + t * ray;
+
+    // depth of the plane so the grid is occluded like regular geometry
+    vec4 clip = uViewProjection * uGridModel * vec4(local, 1.0);
+    gl_FragDepth = clip.z / clip.w * 0.5 + 0.5;
+
+    float coverage = max(lines(local.xz, vSpacing) * (1.0 - vBlend), lines(local.xz, vSpacing * 10.0));
+
+    // fade with distance from the camera
+    float distance = length(local.xz - vCamera.xz);
+    coverage *= 1.0 - smoothstep(vFade * 0.5, vFade, distance);
+
+    if (coverage <= 0.0) {
+        discard;
+    }
+
+    fragColor = vec4(uGridColor.rgb, uGridColor.a * coverage);
+}
@@ -0,0 +1,58 @@
+#version 330 core
+
+// procedural ground grid: one full-screen triangle, each pixel intersects its view ray with
+// the grid plane in grid_fragment.glsl
+
+layout(std140) uniform Frame {
+    mat4 uView;
+    mat4 uProjection;
+    mat4 uViewProjection;
+    bool uRotateAnimX;
+    bool uRotateAnimY;
+    bool uRotateAnimZ;
+    float uTime;
+    float uAnimSpeed;
+};
+
+uniform mat4 uGridModelInv;
+uniform float uGridSpacing;
+uniform float uFadeDistance;
+
+// view ray end points on the near and far plane, in grid space
+out vec3 vNear;
+out vec3 vFar;
+flat out vec3 vCamera;
+
+// per-frame constants, computed here instead of per pixel
+flat out float vSpacing;
+flat out float vBlend;
+flat out float vFade;
+
+vec3 unproject(mat4 toGrid, vec2 ndc, float z)
+{
+    vec4 p = toGrid * vec4(ndc, z, 1.0);
+    return p.xyz / p.w;
+}
+
+void main()
+{
+    // (-1,-1), (3,-1), (-1,3) covers the viewport
+    vec2 ndc = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2) * 2.0 - 1.0;
+
+    mat4 toGrid = uGridModelInv * inverse(uViewProjection);
+    vNear = unproject(toGrid, ndc, -1.0);
+    vFar = unproject(toGrid, ndc, 1.0);
+    vCamera = (uGridModelInv * vec4(inverse(uView)[3].xyz, 1.0)).xyz;
+
+    // level of detail: spacing grows by 10x per decade of camera height, the finer level
+    // fades out as the camera rises towards the next one
+    float height = max(abs(vCamera.y), uGridSpacing);
+    float level = max(log(height / (uGridSpacing * 10.0)) / log(10.0), 0.0);
+    vSpacing = uGridSpacing * pow(10.0, floor(level));
+    vBlend = fract(level);
+
+    // pushed out as the camera rises so the horizon stays covered
+    vFade = max(uFadeDistance, height * 4.0);
+
+    gl_Position = vec4(ndc, 0.0, 1.0);
+}
@@ -0,0 +1,35 @@
+#version 330 core
+
+// sampler unit 0, the default
+uniform sampler2D uScene;
+
+// xy: uv extent of the region the scene was drawn into, zw: size of one source texel in uv
+uniform vec4 uSource;
+uniform float uSharpness;
+
+in vec2 vUv;
+
+out vec4 fragColor;
+
+// bilinear upscale followed by a contrast adaptive sharpen over the 4 source neighbours.
+// flat areas get the full amount, edges that already have contrast get less so they do not
+// ring. taps stay inside the drawn region, the rest of the target holds stale pixels.
+void main()
+{
+    vec2 lo = uSource.zw * 0.5;
+    vec2 hi = uSource.xy - uSource.zw * 0.5;
+    vec2 uv = clamp(vUv * uSource.xy, lo, hi);
+
+    vec3 c = texture(uScene, uv).rgb;
+    vec3 n = texture(uScene, clamp(uv + vec2(0.0, uSource.w), lo, hi)).rgb;
+    vec3 s = texture(uScene, clamp(uv - vec2(0.0, uSource.w), lo, hi)).rgb;
+    vec3 e = texture(uScene, clamp(uv + vec2(uSource.z, 0.0), lo, hi)).rgb;
+    vec3 w = texture(uScene, clamp(uv - vec2(uSource.z, 0.0), lo, hi)).rgb;
+
+    vec3 mn = min(c, min(min(n, s), min(e, w)));
+    vec3 mx = max(c, max(max(n, s), max(e, w)));
+    vec3 amount = sqrt(clamp(min(mn, 1.0 - mx) / max(mx, vec3(1e-4)), 0.0, 1.0)) * uSharpness;
+
+    vec3 sharpened = c + (4.0 * c - n - s - e - w) * amount * 0.25;
+    fragColor = vec4(clamp(sharpened, 0.0, 1.0), 1.0);
+}
@@ -0,0 +1,14 @@
+#version 330 core
+
+// dynamic resolution upscale: one full-screen triangle, the fragment stage samples the scaled
+// scene region in upscale_fragment.glsl
+
+out vec2 vUv;
+
+void main()
+{
+    // (-1,-1), (3,-1), (-1,3) covers the viewport
+    vec2 ndc = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2) * 2.0 - 1.0;
+    vUv = ndc * 0.5 + 0.5;
+    gl_Position = vec4(ndc, 0.0, 1.0);
+}
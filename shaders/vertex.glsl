@@ -1,72 +1,85 @@
 #version 330 core
 
+// compile-time features, injected by ShaderVariants in src/shader_variants.h:
+//   ROTATE_X/Y/Z   rotate every vertex around that axis (reference path, the
+//                  default composes the rotation into the instance matrix on the cpu)
+//   INSTANCE_TINT  multiply vertex color by the per-instance tint
+//   QUANTIZED_POS  positions are snorm16/half in [-1, 1], scaled back by the mesh bounds
+
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec4 aColor;
 
-out vec4 vertexColor;
-
-uniform mat4 uMVP;
-uniform float uTime;
-uniform float uAnimSpeed;
-
-// per-object animation flags
-uniform bool uPyAnim;
-uniform bool uGridAnim;
+// per-instance data, see InstanceData in src/instance.h
+layout (location = 2) in mat4 aModel;
+layout (location = 6) in vec4 aTint;
+layout (location = 7) in vec4 aAnim; // x = animated, y = phase, z = speed multiplier
 
-// which object is this? 0 = pyramid, 1 = grid
-uniform int uObjectID;
+out vec4 vertexColor;
 
-// rotation toggles
-uniform bool uRotateAnimX;
-uniform bool uRotateAnimY;
-uniform bool uRotateAnimZ;
+// per-frame state shared by every program, see FrameUniforms in src/frame_uniforms.h
+layout (std140) uniform Frame {
+    mat4 uView;
+    mat4 uProjection;
+    mat4 uViewProjection;
+    bool uRotateAnimX;
+    bool uRotateAnimY;
+    bool uRotateAnimZ;
+    float uTime;
+    float uAnimSpeed;
+};
+
+#ifdef QUANTIZED_POS
+uniform vec4 uPosScale;
+uniform vec4 uPosOffset;
+#endif
 
 void main()
 {
-    float angle = uTime * uAnimSpeed;
-
-    mat4 rotationX = mat4(
-        1.0, 0.0,         0.0,         0.0,
-        0.0, cos(angle), -sin(angle),  0.0,
-        0.0, sin(angle),  cos(angle),  0.0,
-        0.0, 0.0,         0.0,         1.0
-    );
-
-    mat4 rotationY = mat4(
-        cos(angle),  0.0, sin(angle), 0.0,
-        0.0,         1.0, 0.0,        0.0,
-        -sin(angle), 0.0, cos(angle), 0.0,
-        0.0,         0.0, 0.0,        1.0
-    );
-
-    mat4 rotationZ = mat4(
-        cos(angle), -sin(angle), 0.0, 0.0,
-        sin(angle),  cos(angle), 0.0, 0.0,
-        0.0,         0.0,        1.0, 0.0,
-        0.0,         0.0,        0.0, 1.0
-    );
-
-    mat4 rot = mat4(1.0f);
-
-    bool anim = false;
-    if (uObjectID == 0) {
-        anim = uPyAnim;
-    } else if (uObjectID == 1) {
-        anim = uGridAnim;
-    }
-
-    if (anim && uRotateAnimX) {
-        rot = rotationX * rot;
-    }
-
-    if (anim && uRotateAnimY) {
-        rot = rotationY * rot;
-    }
-
-    if (anim && uRotateAnimZ) {
-        rot = rotationZ * rot;
-    }
-
-    gl_Position = uMVP * rot * vec4(aPos, 1.0);
+#ifdef QUANTIZED_POS
+    vec4 pos = vec4(aPos * uPosScale.xyz + uPosOffset.xyz, 1.0);
+#else
+    vec4 pos = vec4(aPos, 1.0);
+#endif
+
+#if defined(ROTATE_X) || defined(ROTATE_Y) || defined(ROTATE_Z)
+    // instances that are not animated get a zero angle
+    float angle = aAnim.x * (uTime * uAnimSpeed * aAnim.z + aAnim.y);
+    float s = sin(angle);
+    float c = cos(angle);
+#endif
+
+#ifdef ROTATE_X
+    pos = mat4(
+        1.0, 0.0, 0.0, 0.0,
+        0.0,   c,  -s, 0.0,
+        0.0,   s,   c, 0.0,
+        0.0, 0.0, 0.0, 1.0
+    ) * pos;
+#endif
+
+#ifdef ROTATE_Y
+    pos = mat4(
+          c, 0.0,   s, 0.0,
+        0.0, 1.0, 0.0, 0.0,
+         -s, 0.0,   c, 0.0,
+        0.0, 0.0, 0.0, 1.0
+    ) * pos;
+#endif
+
+#ifdef ROTATE_Z
+    pos = mat4(
+          c,  -s, 0.0, 0.0,
+          s,   c, 0.0, 0.0,
+        0.0, 0.0, 1.0, 0.0,
+        0.0, 0.0, 0.0, 1.0
+    ) * pos;
+#endif
+
+    gl_Position = uViewProjection * aModel * pos;
+
+#ifdef INSTANCE_TINT
+    vertexColor = aColor * aTint;
+#else
     vertexColor = aColor;
+#endif
 }
@@ -0,0 +1,182 @@
+#ifndef ASSET_PACK_H
+#define ASSET_PACK_H
+
+#define GLAD_IMPLEMENTATION
+#include "glad/glad.h"
+
+#include "mapped_file.h"
+#include "vertex.h"
+
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+
+// on-disk layout of a cooked asset pack, written by tools/cook.cpp:
+//
+//   PackHeader | blobs, each aligned to packAlignment | PackEntry[entryCount]
+//
+// mesh blobs start with a PackMesh header followed by the vertex and index data in the
+// exact layout uploaded to GL, so the mapped pages go straight into glBufferData.
+// all fields are little endian.
+
+inline constexpr uint32_t packMagic = 0x4b505950; // "PYPK"
+inline constexpr uint32_t packVersion = 1;
+inline constexpr uint64_t packAlignment = 64;
+
+enum PackEntryType : uint32_t {
+    PackEntryText = 1,
+    PackEntryMesh = 2,
+};
+
+struct PackHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t reserved;
+    uint64_t entriesOffset;
+};
+
+struct PackEntry {
+    char name[112];
+    uint32_t type;
+    uint32_t reserved;
+    uint64_t offset; // from the start of the pack
+    uint64_t size;
+};
+
+// vertices are `Vertex` (float position and color), indices use the narrowest GL type
+struct PackMesh {
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint32_t vertexStride;
+    uint32_t indexType;
+    float boundsMin[3];
+    float boundsMax[3];
+    uint64_t vertexOffset; // from the start of the mesh blob
+    uint64_t vertexBytes;
+    uint64_t indexOffset;
+    uint64_t indexBytes;
+};
+
+static_assert(sizeof(PackHeader) == 24 && sizeof(PackEntry) == 136 && sizeof(PackMesh) == 72, "pack layout changed");
+
+inline uint64_t packAlign(uint64_t offset)
+{
+    return (offset + packAlignment - 1) / packAlignment * packAlignment;
+}
+
+// memory mapped pack, entries point into the mapping and stay valid while the pack is open
+struct AssetPack {
+    MappedFile file;
+    const PackHeader* header = nullptr;
+    const PackEntry* entries = nullptr;
+
+    bool isOpen() const { return header != nullptr; }
+
+    bool open(const std::string& path)
+    {
+        header = nullptr;
+        entries = nullptr;
+
+        if (!file.open(path)) {
+            return false;
+        }
+
+        const PackHeader* h = (const PackHeader*)file.data;
+        if (file.size < sizeof(PackHeader) || h->magic != packMagic || h->version != packVersion) {
+            fprintf(stderr, "err: %s is not a version %u asset pack\n", path.c_str(), packVersion);
+            file.close();
+            return false;
+        }
+
+        if (h->entriesOffset > file.size || (file.size - h->entriesOffset) / sizeof(PackEntry) < h->entryCount) {
+            fprintf(stderr, "err: asset pack %s is truncated\n", path.c_str());
+            file.close();
+            return false;
+        }
+
+        const PackEntry* e = (const PackEntry*)(file.data + h->entriesOffset);
+        for (uint32_t i = 0; i < h->entryCount; i++) {
+            if (e[i].offset > file.size || e[i].size > file.size - e[i].offset) {
+                fprintf(stderr, "err: asset pack entry %.*s is out of bounds\n", (int)sizeof(e[i].name), e[i].name);
+                file.close();
+                return false;
+            }
+        }
+
+        header = h;
+        entries = e;
+        return true;
+    }
+
+    const PackEntry* find(const std::string& name, PackEntryType type) const
+    {
+        if (!isOpen()) {
+            return nullptr;
+        }
+
+        for (uint32_t i = 0; i < header->entryCount; i++) {
+            if (entries[i].type == type && strncmp(entries[i].name, name.c_str(), sizeof(entries[i].name)) == 0) {
+                return &entries[i];
+            }
+        }
+        return nullptr;
+    }
+
+    const uint8_t* data(const PackEntry& entry) const { return file.data + entry.offset; }
+
+    std::optional<std::string> text(const std::string& name) const
+    {
+        const PackEntry* entry = find(name, PackEntryText);
+        if (!entry) {
+            return std::nullopt;
+        }
+        return std::string((const char*)data(*entry), entry->size);
+    }
+
+    static uint32_t indexTypeSize(uint32_t type)
+    {
+        switch (type) {
+        case GL_UNSIGNED_BYTE: return 1;
+        case GL_UNSIGNED_SHORT: return 2;
+        case GL_UNSIGNED_INT: return 4;
+        default: return 0;
+        }
+    }
+
+    // nullptr if missing, if the blobs do not fit in the entry or do not hold the counts the
+    // mesh claims in the layout this build reads
+    const PackMesh* mesh(const std::string& name) const
+    {
+        const PackEntry* entry = find(name, PackEntryMesh);
+        if (!entry || entry->size < sizeof(PackMesh)) {
+            return nullptr;
+        }
+
+        const PackMesh* m = (const PackMesh*)data(*entry);
+        if (m->vertexOffset > entry->size || m->vertexBytes > entry->size - m->vertexOffset || m->indexOffset > entry->size
+            || m->indexBytes > entry->size - m->indexOffset) {
+            fprintf(stderr, "err: asset pack mesh %s is out of bounds\n", name.c_str());
+            return nullptr;
+        }
+
+        uint32_t indexSize = indexTypeSize(m->indexType);
+        if (m->vertexStride != sizeof(Vertex) || indexSize == 0 || (uint64_t)m->vertexCount * sizeof(Vertex) > m->vertexBytes
+            || (uint64_t)m->indexCount * indexSize > m->indexBytes) {
+            fprintf(stderr, "err: asset pack mesh %s has an unexpected layout (stride %u, index type 0x%x)\n", name.c_str(), m->vertexStride,
+                m->indexType);
+            return nullptr;
+        }
+        return m;
+    }
+
+    void close()
+    {
+        header = nullptr;
+        entries = nullptr;
+        file.close();
+    }
+};
+
+#endif // ASSET_PACK_H
@@ -0,0 +1,308 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#define GLAD_IMPLEMENTATION
+#include "glad/glad.h"
+
+#include "frame_pacer.h"
+#include "gl_resources.h"
+#include "gl_stats.h"
+#include "math_kernels.h"
+#include "render_queue.h"
+#include "options.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// scene description written next to the timings
+struct BenchScene {
+    int objects = 0;
+    const char* vertexFormat = "float";
+    const char* gridMode = "procedural";
+    double startupMs = 0.0;
+    double meshLoadMs = 0.0;
+    double shaderSetupMs = 0.0;
+    int shaderCacheHits = 0;
+    int shaderCacheMisses = 0;
+    size_t vertexBytes = 0;
+    size_t vertexCount = 0;
+    size_t indexBytes = 0;
+    size_t indexCount = 0;
+    bool threadedUpdate = false;
+    int jobThreads = 1;
+    bool jobsInline = false;
+    bool gpuCull = false;
+    bool dynamicRes = false;
+    const char* upscale = "bilinear";
+    const char* pacing = "unlimited";
+    bool idle = false;
+    std::string replay; // input log the frames were driven by
+};
+
+// one measured frame, kept for replays so two builds can be compared frame by frame
+struct BenchFrame {
+    double cpuMs = 0.0;
+    double submitMs = 0.0;
+    double updateMs = 0.0;
+    uint64_t glCalls = 0;
+    uint64_t drawCalls = 0;
+    int visible = 0;
+};
+
+// per-frame measurements of a --bench run
+struct BenchStats {
+    std::vector<double> frameMs;
+    uint64_t glCalls = 0;
+    uint64_t drawCalls = 0;
+    uint64_t vertices = 0;
+    uint64_t uploadBytes = 0;
+    uint64_t uploads = 0;
+    uint64_t reallocations = 0;
+    uint64_t visibleObjects = 0;
+    double cullMs = 0.0;
+    double submitMs = 0.0;
+    double captureMs = 0.0;
+    int capturedFrames = 0;
+    double scaleSum = 0.0;
+    float scaleMin = 1.0f;
+    uint64_t scaledPixels = 0;
+    uint64_t nodesUpdated = 0;
+    double sceneMs = 0.0;
+    double updateMs = 0.0;
+    double updateWaitMs = 0.0;
+    std::vector<double> latencyMs;
+    std::vector<BenchFrame> perFrame;
+
+    // wall and process cpu time over the measured frames, idle time between them included
+    double wallStart = -1.0;
+    double cpuStart = 0.0;
+    double wallSeconds = 0.0;
+    double cpuSeconds = 0.0;
+    uint64_t idleWakeups = 0;
+
+    uint64_t bindsRequested = 0;
+    uint64_t bindsFiltered = 0;
+    uint64_t uniformsRequested = 0;
+    uint64_t uniformsFiltered = 0;
+
+    void addFrame(double ms, const GlFrameStats& gl)
+    {
+        frameMs.push_back(ms);
+        glCalls += gl.calls;
+        drawCalls += gl.drawCalls;
+        vertices += gl.vertices;
+    }
+
+    void addUploads(const GlUploadStats& stats)
+    {
+        uploadBytes += stats.bytes;
+        uploads += stats.uploads;
+        reallocations += stats.reallocations;
+    }
+
+    void addCull(int visible, double ms)
+    {
+        visibleObjects += visible;
+        cullMs += ms;
+    }
+
+    void addSubmit(double ms)
+    {
+        submitMs += ms;
+    }
+
+    void addCapture(double ms, int written)
+    {
+        captureMs += ms;
+        capturedFrames = written;
+    }
+
+    // scene resolution the frame was drawn at
+    void addResolution(float scale, int width, int height)
+    {
+        scaleSum += scale;
+        scaleMin = std::min(scaleMin, scale);
+        scaledPixels += (uint64_t)width * height;
+    }
+
+    void addQueue(const RenderQueueStats& queue)
+    {
+        bindsRequested += queue.bindsRequested;
+        bindsFiltered += queue.bindsFiltered;
+        uniformsRequested += queue.uniformsRequested;
+        uniformsFiltered += queue.uniformsFiltered;
+    }
+
+    void addScene(size_t updated, double ms)
+    {
+        nodesUpdated += updated;
+        sceneMs += ms;
+    }
+
+    void addFrameDetail(const BenchFrame& frame)
+    {
+        perFrame.push_back(frame);
+    }
+
+    void addLatency(double ms)
+    {
+        latencyMs.push_back(ms);
+    }
+
+    void startClock(double wall)
+    {
+        if (wallStart < 0.0) {
+            wallStart = wall;
+            cpuStart = processCpuSeconds();
+        }
+    }
+
+    void stopClock(double wall, uint64_t wakeups)
+    {
+        wallSeconds = wall - wallStart;
+        cpuSeconds = processCpuSeconds() - cpuStart;
+        idleWakeups = wakeups;
+    }
+
+    void addUpdate(double ms, double waitMs)
+    {
+        updateMs += ms;
+        updateWaitMs += waitMs;
+    }
+
+    // nearest-rank percentile over a sorted sample
+    static double percentile(const std::vector<double>& sorted, double p)
+    {
+        if (sorted.empty()) {
+            return 0.0;
+        }
+
+        size_t rank = (size_t)std::ceil(p / 100.0 * sorted.size());
+        return sorted[std::min(std::max(rank, (size_t)1), sorted.size()) - 1];
+    }
+
+    bool writeJson(const std::string& path, const Options& opts, const BenchScene& scene) const
+    {
+        FILE* file = fopen(path.c_str(), "w");
+        if (!file) {
+            fprintf(stderr, "err: failed to open bench output: %s\n", path.c_str());
+            return false;
+        }
+
+        std::vector<double> sorted = frameMs;
+        std::sort(sorted.begin(), sorted.end());
+
+        double sum = 0.0;
+        for (double ms : sorted) {
+            sum += ms;
+        }
+
+        double n = sorted.empty() ? 1.0 : (double)sorted.size();
+
+        std::vector<double> latency = latencyMs;
+        std::sort(latency.begin(), latency.end());
+        double latencySum = 0.0;
+        for (double ms : latency) {
+            latencySum += ms;
+        }
+
+        fprintf(file, "{\n");
+        fprintf(file, "  \"renderer\": \"%s\",\n", (const char*)glGetString(GL_RENDERER));
+        fprintf(file, "  \"version\": \"%s\",\n", (const char*)glGetString(GL_VERSION));
+        fprintf(file, "  \"frames\": %zu,\n", sorted.size());
+        fprintf(file, "  \"warmup\": %d,\n", opts.warmup);
+        fprintf(file, "  \"width\": %d,\n", opts.width);
+        fprintf(file, "  \"height\": %d,\n", opts.height);
+        fprintf(file, "  \"startupMs\": %.2f,\n", scene.startupMs);
+        fprintf(file, "  \"meshLoadMs\": %.2f,\n", scene.meshLoadMs);
+        fprintf(file, "  \"shaderSetupMs\": %.2f,\n", scene.shaderSetupMs);
+        fprintf(file, "  \"shaderCacheHits\": %d,\n", scene.shaderCacheHits);
+        fprintf(file, "  \"shaderCacheMisses\": %d,\n", scene.shaderCacheMisses);
+        fprintf(file, "  \"simd\": \"%s\",\n", simdLevelNames[MathKernels::level]);
+        fprintf(file, "  \"scene\": {\n");
+        fprintf(file, "    \"objects\": %d,\n", scene.objects);
+        fprintf(file, "    \"gridSize\": %d,\n", opts.gridSize);
+        fprintf(file, "    \"gridSpacing\": %.3f,\n", opts.gridSpacing);
+        fprintf(file, "    \"dense\": %s,\n", opts.dense ? "true" : "false");
+        fprintf(file, "    \"mesh\": \"%s\",\n", opts.mesh.c_str());
+        fprintf(file, "    \"gpuAnim\": %s,\n", opts.gpuAnim ? "true" : "false");
+        fprintf(file, "    \"frustumCull\": %s,\n", opts.noCull ? "false" : "true");
+        fprintf(file, "    \"gpuCull\": %s,\n", scene.gpuCull ? "true" : "false");
+        fprintf(file, "    \"dynamicRes\": %s,\n", scene.dynamicRes ? "true" : "false");
+        fprintf(file, "    \"upscale\": \"%s\",\n", scene.upscale);
+        fprintf(file, "    \"threadedUpdate\": %s,\n", scene.threadedUpdate ? "true" : "false");
+        fprintf(file, "    \"jobThreads\": %d,\n", scene.jobThreads);
+        fprintf(file, "    \"jobsInline\": %s,\n", scene.jobsInline ? "true" : "false");
+        fprintf(file, "    \"pacing\": \"%s\",\n", scene.pacing);
+        fprintf(file, "    \"idle\": %s,\n", scene.idle ? "true" : "false");
+        fprintf(file, "    \"replay\": \"%s\",\n", scene.replay.c_str());
+        fprintf(file, "    \"gridMode\": \"%s\",\n", scene.gridMode);
+        fprintf(file, "    \"vertexFormat\": \"%s\",\n", scene.vertexFormat);
+        fprintf(file, "    \"bytesPerVertex\": %.1f,\n", scene.vertexCount ? (double)scene.vertexBytes / scene.vertexCount : 0.0);
+        fprintf(file, "    \"bytesPerIndex\": %.1f,\n", scene.indexCount ? (double)scene.indexBytes / scene.indexCount : 0.0);
+        fprintf(file, "    \"meshBytes\": %zu\n", scene.vertexBytes + scene.indexBytes);
+        fprintf(file, "  },\n");
+        fprintf(file, "  \"cpuFrameMs\": {\n");
+        fprintf(file, "    \"min\": %.4f,\n", sorted.empty() ? 0.0 : sorted.front());
+        fprintf(file, "    \"avg\": %.4f,\n", sum / n);
+        fprintf(file, "    \"p50\": %.4f,\n", percentile(sorted, 50.0));
+        fprintf(file, "    \"p95\": %.4f,\n", percentile(sorted, 95.0));
+        fprintf(file, "    \"p99\": %.4f,\n", percentile(sorted, 99.0));
+        fprintf(file, "    \"max\": %.4f\n", sorted.empty() ? 0.0 : sorted.back());
+        fprintf(file, "  },\n");
+        fprintf(file, "  \"pacing\": {\n");
+        fprintf(file, "    \"wallSeconds\": %.3f,\n", wallSeconds);
+        fprintf(file, "    \"fps\": %.2f,\n", wallSeconds > 0.0 ? sorted.size() / wallSeconds : 0.0);
+        fprintf(file, "    \"cpuPercent\": %.1f,\n", wallSeconds > 0.0 ? 100.0 * cpuSeconds / wallSeconds : 0.0);
+        fprintf(file, "    \"idleWakeups\": %llu,\n", (unsigned long long)idleWakeups);
+        fprintf(file, "    \"inputs\": %zu,\n", latency.size());
+        fprintf(file, "    \"latencyMs\": { \"avg\": %.3f, \"p50\": %.3f, \"p95\": %.3f, \"max\": %.3f }\n",
+            latency.empty() ? 0.0 : latencySum / latency.size(), percentile(latency, 50.0), percentile(latency, 95.0),
+            latency.empty() ? 0.0 : latency.back());
+        fprintf(file, "  },\n");
+        fprintf(file, "  \"glCallsPerFrame\": %.1f,\n", glCalls / n);
+        fprintf(file, "  \"drawCallsPerFrame\": %.1f,\n", drawCalls / n);
+        fprintf(file, "  \"verticesPerFrame\": %.1f,\n", vertices / n);
+        fprintf(file, "  \"uploadsPerFrame\": { \"bytes\": %.1f, \"calls\": %.1f, \"reallocations\": %.2f },\n", uploadBytes / n, uploads / n,
+            reallocations / n);
+        GlResourceTotals totals = GlResources::totals();
+        fprintf(file, "  \"gpuResources\": {");
+        for (int k = 0; k < GlResourceKindCount; k++) {
+            fprintf(file, "%s \"%s\": { \"count\": %d, \"bytes\": %zu }", k ? "," : "", glResourceKindNames[k], totals.count[k], totals.bytes[k]);
+        }
+        fprintf(file, " },\n");
+        fprintf(file, "  \"visibleObjectsPerFrame\": %.1f,\n", visibleObjects / n);
+        fprintf(file, "  \"cullMsPerFrame\": %.4f,\n", cullMs / n);
+        fprintf(file, "  \"submitMsPerFrame\": %.4f,\n", submitMs / n);
+        fprintf(file, "  \"captureMsPerFrame\": %.4f,\n", captureMs / n);
+        fprintf(file, "  \"capturedFrames\": %d,\n", capturedFrames);
+        fprintf(file, "  \"resolutionScale\": { \"avg\": %.3f, \"min\": %.3f, \"pixelsPerFrame\": %.0f },\n", scaleSum / n,
+            sorted.empty() ? 1.0 : scaleMin, scaledPixels / n);
+        fprintf(file, "  \"nodesUpdatedPerFrame\": %.1f,\n", nodesUpdated / n);
+        fprintf(file, "  \"sceneUpdateMsPerFrame\": %.4f,\n", sceneMs / n);
+        fprintf(file, "  \"updateMsPerFrame\": %.4f,\n", updateMs / n);
+        fprintf(file, "  \"updateWaitMsPerFrame\": %.4f,\n", updateWaitMs / n);
+        fprintf(file, "  \"stateChangesPerFrame\": { \"requested\": %.1f, \"filtered\": %.1f },\n", bindsRequested / n, bindsFiltered / n);
+        fprintf(file, "  \"uniformWritesPerFrame\": { \"requested\": %.1f, \"filtered\": %.1f }%s\n", uniformsRequested / n, uniformsFiltered / n,
+            perFrame.empty() ? "" : ",");
+        if (!perFrame.empty()) {
+            fprintf(file, "  \"perFrame\": [\n");
+            for (size_t i = 0; i < perFrame.size(); i++) {
+                const BenchFrame& f = perFrame[i];
+                fprintf(file, "    { \"cpuMs\": %.4f, \"submitMs\": %.4f, \"updateMs\": %.4f, \"glCalls\": %llu, \"drawCalls\": %llu, \"visible\": %d }%s\n",
+                    f.cpuMs, f.submitMs, f.updateMs, (unsigned long long)f.glCalls, (unsigned long long)f.drawCalls, f.visible,
+                    i + 1 < perFrame.size() ? "," : "");
+            }
+            fprintf(file, "  ]\n");
+        }
+        fprintf(file, "}\n");
+
+        fclose(file);
+        return true;
+    }
+};
+
+#endif // BENCH_H
@@ -0,0 +1,113 @@
+#ifndef BOUNDS_H
+#define BOUNDS_H
+
+#include "vertex.h"
+
+#include <cfloat>
+#include <glm/glm.hpp>
+#include <vector>
+
+struct Aabb {
+    glm::vec3 min { FLT_MAX };
+    glm::vec3 max { -FLT_MAX };
+
+    bool empty() const { return min.x > max.x; }
+    glm::vec3 center() const { return (min + max) * 0.5f; }
+    glm::vec3 extent() const { return (max - min) * 0.5f; }
+
+    void expand(const glm::vec3& p)
+    {
+        min = glm::min(min, p);
+        max = glm::max(max, p);
+    }
+
+    void expand(const Aabb& b)
+    {
+        min = glm::min(min, b.min);
+        max = glm::max(max, b.max);
+    }
+
+    bool operator==(const Aabb& b) const { return min == b.min && max == b.max; }
+    bool operator!=(const Aabb& b) const { return !(*this == b); }
+
+    static Aabb fromVertices(const std::vector<Vertex>& vertices)
+    {
+        Aabb box;
+        for (const auto& v : vertices) {
+            box.expand(v.position);
+        }
+        return box;
+    }
+
+    // bounds of the box after an affine transform (Arvo's method)
+    Aabb transformed(const glm::mat4& m) const
+    {
+        glm::vec3 c = glm::vec3(m * glm::vec4(center(), 1.0f));
+        glm::vec3 e = extent();
+        glm::vec3 r = glm::abs(glm::vec3(m[0])) * e.x + glm::abs(glm::vec3(m[1])) * e.y + glm::abs(glm::vec3(m[2])) * e.z;
+        return { c - r, c + r };
+    }
+
+    // bounds that hold under any rotation about the local origin, for animated objects
+    Aabb rotationInvariant(const glm::mat4& m) const
+    {
+        float radius = glm::length(glm::max(glm::abs(min), glm::abs(max)));
+        float scale = glm::max(glm::length(glm::vec3(m[0])), glm::max(glm::length(glm::vec3(m[1])), glm::length(glm::vec3(m[2]))));
+        glm::vec3 c = glm::vec3(m[3]);
+        glm::vec3 r(radius * scale);
+        return { c - r, c + r };
+    }
+};
+
+enum FrustumTest {
+    FrustumOutside,
+    FrustumIntersects,
+    FrustumInside,
+};
+
+// planes extracted from a view projection matrix (Gribb/Hartmann), normals point inwards
+struct Frustum {
+    glm::vec4 planes[6];
+
+    static Frustum fromMatrix(const glm::mat4& m)
+    {
+        glm::vec4 row[4];
+        for (int i = 0; i < 4; i++) {
+            row[i] = glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]);
+        }
+
+        Frustum f;
+        f.planes[0] = row[3] + row[0]; // left
+        f.planes[1] = row[3] - row[0]; // right
+        f.planes[2] = row[3] + row[1]; // bottom
+        f.planes[3] = row[3] - row[1]; // top
+        f.planes[4] = row[3] + row[2]; // near
+        f.planes[5] = row[3] - row[2]; // far
+
+        for (auto& p : f.planes) {
+            p /= glm::length(glm::vec3(p));
+        }
+        return f;
+    }
+
+    FrustumTest test(const Aabb& box) const
+    {
+        glm::vec3 c = box.center();
+        glm::vec3 e = box.extent();
+
+        FrustumTest result = FrustumInside;
+        for (const auto& p : planes) {
+            float d = glm::dot(glm::vec3(p), c) + p.w;
+            float r = glm::dot(glm::abs(glm::vec3(p)), e);
+            if (d < -r) {
+                return FrustumOutside;
+            }
+            if (d < r) {
+                result = FrustumIntersects;
+            }
+        }
+        return result;
+    }
+};
+
+#endif // BOUNDS_H
@@ -0,0 +1,184 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include "bounds.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// bounding volume hierarchy over scene objects for frustum culling. built once by median
+// split, then kept valid by refitting the bounds of changed objects and their ancestors.
+// a rebuild is only needed when objects are added or removed.
+struct Bvh {
+    static constexpr int leafSize = 4;
+
+    // nodes are stored depth first, the left child directly follows its parent
+    struct Node {
+        Aabb bounds;
+        int parent = -1;
+        int right = -1; // leaves have no children
+        int first = 0;  // leaves: range in `objects`
+        int count = 0;
+        bool dirty = false;
+
+        bool leaf() const { return right < 0; }
+    };
+
+    std::vector<Node> nodes;
+    std::vector<int> objects;    // object indices, grouped by leaf
+    std::vector<int> objectLeaf; // leaf node of each object
+    std::vector<Aabb> objectBounds;
+    std::vector<int> dirtyLeaves;
+
+    // per-cull counters
+    int nodesVisited = 0;
+
+    size_t size() const { return objectBounds.size(); }
+
+    void build(const std::vector<Aabb>& bounds)
+    {
+        objectBounds = bounds;
+        objects.resize(bounds.size());
+        objectLeaf.assign(bounds.size(), -1);
+        for (size_t i = 0; i < bounds.size(); i++) {
+            objects[i] = (int)i;
+        }
+
+        nodes.clear();
+        dirtyLeaves.clear();
+        if (!bounds.empty()) {
+            nodes.reserve(2 * (bounds.size() / leafSize + 1));
+            buildNode(-1, 0, (int)bounds.size());
+        }
+    }
+
+    int buildNode(int parent, int first, int count)
+    {
+        int index = (int)nodes.size();
+        nodes.push_back({});
+        nodes[index].parent = parent;
+
+        Aabb bounds, centers;
+        for (int i = first; i < first + count; i++) {
+            bounds.expand(objectBounds[objects[i]]);
+            centers.expand(objectBounds[objects[i]].center());
+        }
+        nodes[index].bounds = bounds;
+
+        if (count <= leafSize) {
+            nodes[index].first = first;
+            nodes[index].count = count;
+            for (int i = first; i < first + count; i++) {
+                objectLeaf[objects[i]] = index;
+            }
+            return index;
+        }
+
+        // split at the median along the widest axis of the object centers
+        glm::vec3 size = centers.max - centers.min;
+        int axis = size.x > size.y ? (size.x > size.z ? 0 : 2) : (size.y > size.z ? 1 : 2);
+        int mid = first + count / 2;
+        std::nth_element(objects.begin() + first, objects.begin() + mid, objects.begin() + first + count,
+            [&](int a, int b) { return objectBounds[a].center()[axis] < objectBounds[b].center()[axis]; });
+
+        buildNode(index, first, mid - first);
+        int right = buildNode(index, mid, first + count - mid);
+        nodes[index].right = right;
+        return index;
+    }
+
+    // record new bounds for one object, applied by the next refit()
+    void update(int object, const Aabb& bounds)
+    {
+        if (objectBounds[object] == bounds) {
+            return;
+        }
+
+        objectBounds[object] = bounds;
+        int leaf = objectLeaf[object];
+        if (!nodes[leaf].dirty) {
+            nodes[leaf].dirty = true;
+            dirtyLeaves.push_back(leaf);
+        }
+    }
+
+    // recompute changed leaves and walk up while the parent bounds keep changing
+    void refit()
+    {
+        for (int leaf : dirtyLeaves) {
+            Node& node = nodes[leaf];
+            node.dirty = false;
+
+            Aabb bounds;
+            for (int i = node.first; i < node.first + node.count; i++) {
+                bounds.expand(objectBounds[objects[i]]);
+            }
+            node.bounds = bounds;
+
+            for (int n = node.parent; n >= 0; n = nodes[n].parent) {
+                Aabb merged = nodes[n + 1].bounds;
+                merged.expand(nodes[nodes[n].right].bounds);
+                if (merged == nodes[n].bounds) {
+                    break;
+                }
+                nodes[n].bounds = merged;
+            }
+        }
+        dirtyLeaves.clear();
+    }
+
+    // appends the objects whose bounds intersect the frustum, subtrees fully inside are
+    // accepted without testing their children
+    void cull(const Frustum& frustum, std::vector<int>& visible)
+    {
+        visible.clear();
+        nodesVisited = 0;
+        if (nodes.empty()) {
+            return;
+        }
+
+        int stack[64];
+        int top = 0;
+        stack[top++] = 0;
+
+        while (top > 0) {
+            const Node& node = nodes[stack[--top]];
+            nodesVisited++;
+
+            FrustumTest result = frustum.test(node.bounds);
+            if (result == FrustumOutside) {
+                continue;
+            }
+
+            if (result == FrustumInside) {
+                appendAll(node, visible);
+            } else if (node.leaf()) {
+                for (int i = node.first; i < node.first + node.count; i++) {
+                    if (frustum.test(objectBounds[objects[i]]) != FrustumOutside) {
+                        visible.push_back(objects[i]);
+                    }
+                }
+            } else {
+                stack[top++] = node.right;
+                stack[top++] = (int)(&node - nodes.data()) + 1;
+            }
+        }
+    }
+
+    // the objects below a node are the contiguous range of its leftmost and rightmost leaf
+    void appendAll(const Node& node, std::vector<int>& visible) const
+    {
+        const Node* lo = &node;
+        while (!lo->leaf()) {
+            lo = lo + 1;
+        }
+        const Node* hi = &node;
+        while (!hi->leaf()) {
+            hi = &nodes[hi->right];
+        }
+        visible.insert(visible.end(), objects.begin() + lo->first, objects.begin() + hi->first + hi->count);
+    }
+};
+
+#endif // BVH_H
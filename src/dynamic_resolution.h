@@ -0,0 +1,158 @@
+#ifndef DYNAMIC_RESOLUTION_H
+#define DYNAMIC_RESOLUTION_H
+
+#define GLAD_IMPLEMENTATION
+#include "glad/glad.h"
+
+#include "framebuffer.h"
+#include "gl_buffer.h"
+#include "shader.h"
+
+#include <algorithm>
+#include <cmath>
+#include <glm/glm.hpp>
+
+enum UpscaleFilter {
+    UpscaleBilinear, // linear framebuffer blit
+    UpscaleSharpen, // shader pass, bilinear plus contrast adaptive sharpening
+};
+
+inline constexpr const char* upscaleFilterNames[] = { "bilinear", "sharpen" };
+
+// renders the scene below the output resolution when frames run over budget. the scene target
+// is sized for the full output and only a scaled viewport of it is drawn, so scale changes
+// never reallocate. fill cost follows the pixel count, the controller moves the scale by the
+// square root of budget / cost, drops fast and recovers slowly, and holds inside a band under
+// the budget so it settles instead of oscillating. the ui is drawn after resolve() at native
+// resolution.
+struct DynamicResolution {
+    static constexpr int historySize = 240;
+
+    Fbo target;
+    Shader upscale;
+    Vao vao { "upscale" }; // core profile needs a bound vao even without attributes
+    Uniform<glm::vec4> source;
+    Uniform<float> sharpness;
+
+    bool enabled = false;
+    UpscaleFilter filter = UpscaleBilinear;
+    float budgetMs = 16.6f;
+    float minScale = 0.5f;
+    float maxScale = 1.0f;
+    float sharpenAmount = 0.5f;
+
+    float scale = 1.0f;
+    int width = 0; // scene resolution of the current frame
+    int height = 0;
+    int outputWidth = 0;
+    int outputHeight = 0;
+
+    // inputs of the last adjustment, the frame cost is the larger of the two
+    double gpuMs = 0.0;
+    double cpuMs = 0.0;
+
+    float scaleHistory[historySize] {};
+    float costHistory[historySize] {};
+    int historyHead = 0;
+
+    bool init(const std::string& vertSource, const std::string& fragSource)
+    {
+        upscale.label = "upscale";
+        if (!upscale.initFromSource(vertSource, fragSource)) {
+            return false;
+        }
+
+        source = upscale.uniform<glm::vec4>("uSource");
+        sharpness = upscale.uniform<float>("uSharpness");
+        return true;
+    }
+
+    // bind the scene target at the current scale, false when disabled and the scene should be
+    // drawn straight into the output
+    bool begin(int outWidth, int outHeight)
+    {
+        outputWidth = outWidth;
+        outputHeight = outHeight;
+        width = outWidth;
+        height = outHeight;
+        if (!enabled || outWidth <= 0 || outHeight <= 0) {
+            return false;
+        }
+
+        if ((target.width != outWidth || target.height != outHeight) && !target.init(outWidth, outHeight, "dynamic resolution target")) {
+            enabled = false;
+            return false;
+        }
+
+        width = std::max(1, (int)std::lround(outWidth * scale));
+        height = std::max(1, (int)std::lround(outHeight * scale));
+
+        glBindFramebuffer(GL_FRAMEBUFFER, target.id);
+        glViewport(0, 0, width, height);
+        return true;
+    }
+
+    // stretch the drawn region over `output` and leave it bound with a full viewport
+    void resolve(GLuint output)
+    {
+        if (filter == UpscaleBilinear || !upscale.program) {
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, target.id);
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, output);
+            glBlitFramebuffer(0, 0, width, height, 0, 0, outputWidth, outputHeight, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+            glBindFramebuffer(GL_FRAMEBUFFER, output);
+            glViewport(0, 0, outputWidth, outputHeight);
+            return;
+        }
+
+        glBindFramebuffer(GL_FRAMEBUFFER, output);
+        glViewport(0, 0, outputWidth, outputHeight);
+        glDisable(GL_DEPTH_TEST);
+        glDisable(GL_BLEND);
+
+        glUseProgram(upscale.program);
+        source.set(glm::vec4((float)width / target.width, (float)height / target.height, 1.0f / target.width, 1.0f / target.height));
+        sharpness.set(sharpenAmount);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, target.color);
+        vao.bind();
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        vao.unbind();
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glUseProgram(0);
+
+        glEnable(GL_DEPTH_TEST);
+    }
+
+    // feed the measured cost of a frame, adjusts the scale used by the next begin()
+    void update(double gpuFrameMs, double cpuFrameMs)
+    {
+        gpuMs = gpuFrameMs;
+        cpuMs = cpuFrameMs;
+        double cost = std::max(gpuMs, cpuMs);
+
+        scaleHistory[historyHead] = enabled ? scale : 1.0f;
+        costHistory[historyHead] = (float)cost;
+        historyHead = (historyHead + 1) % historySize;
+
+        if (!enabled || cost <= 0.0) {
+            return;
+        }
+
+        // over budget: shrink right away, well under it: grow back slowly, in between: hold
+        float desired = scale * (float)std::sqrt(budgetMs / cost);
+        if (cost > budgetMs) {
+            scale += (desired - scale) * 0.5f;
+        } else if (cost < budgetMs * 0.8f) {
+            scale += (desired - scale) * 0.1f;
+        }
+        scale = std::clamp(scale, minScale, std::max(minScale, maxScale));
+    }
+
+    // the ui may have changed the limits or turned scaling off
+    void clampScale()
+    {
+        scale = enabled ? std::clamp(scale, minScale, std::max(minScale, maxScale)) : 1.0f;
+    }
+};
+
+#endif // DYNAMIC_RESOLUTION_H
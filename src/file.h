@@ -2,28 +2,43 @@
 #define FILE_H
 
 #include <cstdio>
-#include <fstream>
 #include <optional>
-#include <sstream>
 #include <string>
 
 struct File {
+    // sized up front and read with a single fread, no stream buffering in between
     static std::optional<std::string> readFile(const std::string& path)
     {
-        std::ifstream file(path);
-        if (!file.is_open()) {
+        FILE* file = fopen(path.c_str(), "rb");
+        if (!file) {
             return std::nullopt;
         }
 
-        std::ostringstream ss;
-        ss << file.rdbuf();
-        return ss.str();
+        std::string data;
+        if (fseek(file, 0, SEEK_END) == 0) {
+            long size = ftell(file);
+            if (size > 0) {
+                data.resize((size_t)size);
+            }
+            fseek(file, 0, SEEK_SET);
+        }
+
+        size_t read = data.empty() ? 0 : fread(data.data(), 1, data.size(), file);
+        fclose(file);
+
+        if (read != data.size()) {
+            return std::nullopt;
+        }
+        return data;
     }
 
     static bool exists(const std::string& path)
     {
-        std::fstream file(path);
-        return file.good();
+        FILE* file = fopen(path.c_str(), "rb");
+        if (file) {
+            fclose(file);
+        }
+        return file != nullptr;
     }
 };
 
@@ -0,0 +1,141 @@
+#ifndef FILE_WATCHER_H
+#define FILE_WATCHER_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+// reports files in one directory that were written since the last poll. uses inotify on linux,
+// elsewhere it compares modification times a couple of times per second.
+struct FileWatcher {
+    std::string directory;
+
+#ifdef __linux__
+    int fd = -1;
+    int watch = -1;
+#else
+    std::unordered_map<std::string, std::filesystem::file_time_type> times;
+    std::chrono::steady_clock::time_point lastScan;
+#endif
+
+    FileWatcher() = default;
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+    ~FileWatcher() { close(); }
+
+    bool open(const std::string& path)
+    {
+        directory = path;
+
+#ifdef __linux__
+        fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (fd < 0) {
+            fprintf(stderr, "err: failed to initialize inotify\n");
+            return false;
+        }
+
+        // editors either rewrite the file in place or rename a temporary over it
+        watch = inotify_add_watch(fd, path.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+        if (watch < 0) {
+            fprintf(stderr, "err: failed to watch directory: %s\n", path.c_str());
+            close();
+            return false;
+        }
+#else
+        std::error_code error;
+        for (const auto& entry : std::filesystem::directory_iterator(path, error)) {
+            times[entry.path().filename().string()] = entry.last_write_time(error);
+        }
+        if (error) {
+            fprintf(stderr, "err: failed to watch directory: %s\n", path.c_str());
+            return false;
+        }
+        lastScan = std::chrono::steady_clock::now();
+#endif
+
+        return true;
+    }
+
+    bool isOpen() const
+    {
+#ifdef __linux__
+        return fd >= 0;
+#else
+        return !directory.empty();
+#endif
+    }
+
+    // file names relative to the watched directory, each reported once per poll. never blocks.
+    std::vector<std::string> poll()
+    {
+        std::vector<std::string> changed;
+        if (!isOpen()) {
+            return changed;
+        }
+
+#ifdef __linux__
+        alignas(inotify_event) char buffer[4096];
+        while (true) {
+            ssize_t length = read(fd, buffer, sizeof(buffer));
+            if (length <= 0) {
+                break;
+            }
+
+            for (ssize_t offset = 0; offset < length;) {
+                const inotify_event* event = (const inotify_event*)(buffer + offset);
+                if (event->len > 0) {
+                    std::string name = event->name;
+                    if (std::find(changed.begin(), changed.end(), name) == changed.end()) {
+                        changed.push_back(name);
+                    }
+                }
+                offset += sizeof(inotify_event) + event->len;
+            }
+        }
+#else
+        auto now = std::chrono::steady_clock::now();
+        if (now - lastScan < std::chrono::milliseconds(500)) {
+            return changed;
+        }
+        lastScan = now;
+
+        std::error_code error;
+        for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+            std::string name = entry.path().filename().string();
+            auto time = entry.last_write_time(error);
+            auto it = times.find(name);
+            if (it == times.end() || it->second != time) {
+                times[name] = time;
+                changed.push_back(name);
+            }
+        }
+#endif
+
+        return changed;
+    }
+
+    void close()
+    {
+#ifdef __linux__
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        fd = -1;
+        watch = -1;
+#else
+        times.clear();
+#endif
+        directory.clear();
+    }
+};
+
+#endif // FILE_WATCHER_H
@@ -0,0 +1,363 @@
+#ifndef FRAME_CAPTURE_H
+#define FRAME_CAPTURE_H
+
+#define GLAD_IMPLEMENTATION
+#include "glad/glad.h"
+
+#include "gl_resources.h"
+
+#define STB_IMAGE_WRITE_STATIC
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "stb_image_write.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum CaptureFormat {
+    CapturePng,
+    CaptureRaw, // rgba8 frames appended to one file, bottom row first
+};
+
+inline constexpr const char* captureFormatNames[] = { "png", "raw" };
+
+// frame capture without stalling the pipeline. glReadPixels goes into a ring of pixel pack
+// buffers and is fenced, a slot is mapped a few frames later once its fence signaled and the
+// pixels are handed to a worker thread that encodes them. when every slot is still in flight
+// the oldest one is waited for, up to a second, and the frame is dropped if it never signals.
+struct FrameCapture {
+    static constexpr int ringSize = 4;
+
+    struct Slot {
+        GLuint pbo = 0;
+        GLsync fence = 0;
+        GLsizeiptr size = 0;
+        int width = 0;
+        int height = 0;
+        std::string screenshot; // png written besides the sequence frame
+        std::string path; // sequence frame
+        CaptureFormat format = CapturePng;
+    };
+
+    struct Job {
+        std::vector<uint8_t> pixels;
+        int width = 0;
+        int height = 0;
+        std::string screenshot;
+        std::string path;
+        CaptureFormat format = CapturePng;
+    };
+
+    Slot slots[ringSize];
+    int head = 0; // next slot to read into
+    int inFlight = 0; // slots between head - inFlight and head wait for their fence
+
+    // requests, a single screenshot or every frame of a sequence
+    std::string screenshotPath;
+    bool sequence = false;
+    std::string directory = "capture";
+    CaptureFormat format = CapturePng;
+    int sequenceFrame = 0;
+
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<Job> jobs;
+    std::vector<std::vector<uint8_t>> spare; // pixel storage returned by the worker
+    FILE* rawFile = nullptr; // owned by the worker
+    std::string rawPath;
+    bool quit = false;
+
+    // main thread cost of the last captured frame, readback issue plus copy out of the mapped slot
+    double lastMs = 0.0;
+    int captured = 0; // readbacks issued
+    int stalls = 0; // captures that had to wait for the oldest fence
+    int dropped = 0; // captures skipped because the oldest fence did not signal in time
+    int written = 0; // frames the worker finished, under the mutex
+    int failed = 0;
+
+    ~FrameCapture() { shutdown(); }
+
+    void init()
+    {
+        for (Slot& slot : slots) {
+            glGenBuffers(1, &slot.pbo);
+            GlResources::name(GlResourceBuffer, slot.pbo, "capture readback");
+        }
+        worker = std::thread([this] { run(); });
+    }
+
+    void screenshot(const std::string& path)
+    {
+        std::error_code ec;
+        std::filesystem::path parent = std::filesystem::path(path).parent_path();
+        if (!parent.empty()) {
+            std::filesystem::create_directories(parent, ec);
+        }
+        screenshotPath = path;
+    }
+
+    void startSequence(const std::string& dir, CaptureFormat f)
+    {
+        std::error_code ec;
+        std::filesystem::create_directories(dir, ec);
+        if (ec) {
+            fprintf(stderr, "err: failed to create capture directory %s: %s\n", dir.c_str(), ec.message().c_str());
+            return;
+        }
+
+        directory = dir;
+        format = f;
+        sequence = true;
+        sequenceFrame = 0;
+    }
+
+    void stopSequence() { sequence = false; }
+
+    bool requested() const { return sequence || !screenshotPath.empty(); }
+
+    // readbacks waiting for the gpu plus frames waiting for the encoder
+    int queueDepth()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return inFlight + (int)jobs.size();
+    }
+
+    int writtenFrames()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return written;
+    }
+
+    // read the bound read framebuffer if this frame was requested, call once rendering is done
+    void capture(int width, int height)
+    {
+        lastMs = 0.0;
+        if (!requested()) {
+            return;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+
+        // a slot is only reused once its fence signaled, otherwise this frame is skipped
+        if (inFlight == ringSize) {
+            stalls++;
+            if (!collect(true)) {
+                dropped++;
+                lastMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                return;
+            }
+        }
+
+        Slot& slot = slots[head];
+        slot.width = width;
+        slot.height = height;
+        slot.screenshot = std::move(screenshotPath);
+        screenshotPath.clear();
+        slot.path.clear();
+        if (sequence) {
+            char name[64];
+            snprintf(name, sizeof(name), "/frame_%06d.png", sequenceFrame++);
+            slot.path = directory + (format == CapturePng ? name : "/frames.raw");
+            slot.format = format;
+        }
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+        if (slot.size != (GLsizeiptr)width * height * 4) {
+            slot.size = (GLsizeiptr)width * height * 4;
+            glBufferData(GL_PIXEL_PACK_BUFFER, slot.size, nullptr, GL_STREAM_READ);
+        }
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+        glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+        head = (head + 1) % ringSize;
+        captured++;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            inFlight++;
+        }
+
+        lastMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // hand every slot whose fence signaled to the encoder, call once per frame after capture()
+    void poll()
+    {
+        if (inFlight == 0) {
+            return;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        collect(false);
+        lastMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // oldest first, `wait` blocks on the oldest slot when the ring is full and on shutdown.
+    // false when that wait timed out or failed and the oldest slot is still in flight
+    bool collect(bool wait)
+    {
+        while (inFlight > 0) {
+            Slot& slot = slots[(head - inFlight + ringSize) % ringSize];
+
+            GLbitfield flags = wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0;
+            GLenum status = glClientWaitSync(slot.fence, flags, wait ? (GLuint64)1e9 : 0);
+            if (status == GL_TIMEOUT_EXPIRED || status == GL_WAIT_FAILED) {
+                return !wait;
+            }
+            glDeleteSync(slot.fence);
+            slot.fence = 0;
+            wait = false;
+
+            Job job;
+            job.width = slot.width;
+            job.height = slot.height;
+            job.screenshot = slot.screenshot;
+            job.path = slot.path;
+            job.format = slot.format;
+
+            size_t size = (size_t)slot.width * slot.height * 4;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!spare.empty()) {
+                    job.pixels = std::move(spare.back());
+                    spare.pop_back();
+                }
+            }
+            job.pixels.resize(size);
+
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+            void* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+            if (data) {
+                memcpy(job.pixels.data(), data, size);
+                glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+            } else {
+                fprintf(stderr, "err: failed to map capture buffer\n");
+            }
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                inFlight--;
+                if (data) {
+                    jobs.push_back(std::move(job));
+                } else {
+                    failed++;
+                }
+            }
+            wake.notify_one();
+        }
+        return true;
+    }
+
+    // finish every pending readback and encode, then stop the worker
+    void shutdown()
+    {
+        if (!worker.joinable()) {
+            return;
+        }
+
+        // readbacks whose fence never signals are given up, their buffers are deleted below
+        while (inFlight > 0) {
+            if (!collect(true)) {
+                fprintf(stderr, "warn: %d capture readbacks did not complete\n", inFlight);
+                std::lock_guard<std::mutex> lock(mutex);
+                failed += inFlight;
+                inFlight = 0;
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            quit = true;
+        }
+        wake.notify_one();
+        worker.join();
+
+        for (Slot& slot : slots) {
+            if (slot.fence) {
+                glDeleteSync(slot.fence);
+                slot.fence = 0;
+            }
+            glDeleteBuffers(1, &slot.pbo);
+            slot.pbo = 0;
+        }
+    }
+
+    void run()
+    {
+        while (true) {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this] { return quit || !jobs.empty(); });
+                if (jobs.empty()) {
+                    break;
+                }
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+
+            bool ok = encode(job);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            written += ok ? 1 : 0;
+            failed += ok ? 0 : 1;
+            spare.push_back(std::move(job.pixels));
+        }
+
+        if (rawFile) {
+            fclose(rawFile);
+            rawFile = nullptr;
+        }
+    }
+
+    bool encode(const Job& job)
+    {
+        bool ok = true;
+        if (!job.screenshot.empty()) {
+            ok = writePng(job, job.screenshot);
+        }
+        if (job.path.empty()) {
+            return ok;
+        }
+        if (job.format == CapturePng) {
+            return writePng(job, job.path) && ok;
+        }
+
+        if (!rawFile || rawPath != job.path) {
+            if (rawFile) {
+                fclose(rawFile);
+            }
+            rawPath = job.path;
+            rawFile = fopen(rawPath.c_str(), "wb");
+            if (!rawFile) {
+                fprintf(stderr, "err: failed to open %s\n", rawPath.c_str());
+                return false;
+            }
+        }
+        return fwrite(job.pixels.data(), 1, job.pixels.size(), rawFile) == job.pixels.size() && ok;
+    }
+
+    // gl rows start at the bottom, png rows are flipped with a negative stride
+    static bool writePng(const Job& job, const std::string& path)
+    {
+        int stride = job.width * 4;
+        const uint8_t* top = job.pixels.data() + (size_t)(job.height - 1) * stride;
+        if (!stbi_write_png(path.c_str(), job.width, job.height, 4, top, -stride)) {
+            fprintf(stderr, "err: failed to write %s\n", path.c_str());
+            return false;
+        }
+        return true;
+    }
+};
+
+#endif // FRAME_CAPTURE_H
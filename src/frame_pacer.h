@@ -0,0 +1,190 @@
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+
+#include "window.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#endif
+
+enum PacingMode {
+    PacingVsync, // continuous, the swap waits for the display
+    PacingUnlimited, // continuous without vsync, for profiling
+    PacingCapped, // continuous at a target rate, sleep then spin to each deadline
+    PacingOnDemand, // block for events, draw only when something can have changed
+};
+
+inline constexpr const char* pacingModeNames[] = { "vsync", "unlimited", "capped", "on demand" };
+
+// cpu time of every thread of the process, in seconds
+inline double processCpuSeconds()
+{
+#ifdef _WIN32
+    FILETIME creation, exited, kernel, user;
+    GetProcessTimes(GetCurrentProcess(), &creation, &exited, &kernel, &user);
+    auto seconds = [](const FILETIME& t) { return (((uint64_t)t.dwHighDateTime << 32) | t.dwLowDateTime) * 1e-7; };
+    return seconds(kernel) + seconds(user);
+#else
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1e-6;
+#endif
+}
+
+// decides when frames start. wait() handles events, polling while frames are continuous and
+// blocking in on-demand mode until an event, a redraw request or the idle timeout. input that
+// arrived is reported as arrival times so the caller can measure input-to-present latency.
+struct FramePacer {
+    using Clock = std::chrono::steady_clock;
+
+    // imgui needs a few frames to settle after input, a snapshot lands one frame late
+    static constexpr int settleFrames = 3;
+
+    PacingMode mode = PacingVsync;
+    double targetFps = 60.0;
+    double idleTimeout = 0.25; // on-demand wakeups, for work that arrives without an event
+
+    // capped: sleep up to this much before the deadline, then spin. grows with the sleep
+    // overshoot seen on this machine.
+    double spinMargin = 0.0005;
+
+    // headless runs have no event source, synthetic input arrives at this rate instead
+    double syntheticRate = 0.0;
+    double nextSynthetic = 0.0;
+    uint32_t syntheticCount = 0;
+
+    int owedFrames = settleFrames;
+    uint64_t seenEvents = 0;
+    Clock::time_point epoch = Clock::now();
+    Clock::time_point deadline = Clock::now();
+
+    std::vector<double> arrivals; // input picked up by the last wait(), seconds since epoch
+    uint64_t wakeups = 0; // wait() calls that did not lead to a frame
+    uint64_t frames = 0;
+
+    // cpu usage over the last half second
+    double cpuPercent = 0.0;
+    double cpuSampleCpu = processCpuSeconds();
+    double cpuSampleWall = 0.0;
+
+    double now() const { return std::chrono::duration<double>(Clock::now() - epoch).count(); }
+
+    void setMode(PacingMode m, Window& window)
+    {
+        mode = m;
+        window.setSwapInterval(m == PacingVsync || m == PacingOnDemand ? 1 : 0);
+        deadline = Clock::now();
+        owedFrames = settleFrames;
+    }
+
+    // something changed outside of window events, draw it
+    void requestRedraw() { owedFrames = std::max(owedFrames, 1); }
+
+    // `animating` keeps frames coming in on-demand mode, anything that moves without input
+    void wait(Window& window, bool animating)
+    {
+        arrivals.clear();
+
+        if (mode == PacingOnDemand && !animating && owedFrames == 0) {
+            double timeout = idleTimeout;
+            if (syntheticRate > 0.0) {
+                timeout = std::clamp(nextSynthetic - now(), 0.0, timeout);
+            }
+            window.waitEvents(timeout);
+        } else {
+            window.pollEvents();
+        }
+
+        if (window.m_events != seenEvents) {
+            seenEvents = window.m_events;
+            arrivals.push_back(now());
+        }
+
+        // jittered by a hash so arrivals land anywhere within a frame
+        while (syntheticRate > 0.0 && now() >= nextSynthetic) {
+            arrivals.push_back(nextSynthetic);
+            uint32_t h = ++syntheticCount * 2654435761u;
+            nextSynthetic += (0.5 + (h >> 16) / 65536.0) / syntheticRate;
+        }
+
+        if (!arrivals.empty()) {
+            owedFrames = settleFrames;
+        }
+        sampleCpu();
+    }
+
+    // whether to draw a frame after wait()
+    bool shouldDraw(bool animating)
+    {
+        if (mode != PacingOnDemand || animating) {
+            frames++;
+            return true;
+        }
+
+        if (owedFrames > 0) {
+            owedFrames--;
+            frames++;
+            return true;
+        }
+
+        wakeups++;
+        return false;
+    }
+
+    // after the swap. capped mode sleeps most of the way to the next deadline and spins the
+    // rest, os sleeps overshoot by up to a scheduler tick.
+    void endFrame()
+    {
+        if (mode != PacingCapped || targetFps <= 0.0) {
+            return;
+        }
+
+        auto period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / targetFps));
+        deadline += period;
+
+        // a frame that overran starts a new schedule instead of rushing to catch up
+        auto start = Clock::now();
+        if (deadline < start) {
+            deadline = start;
+            return;
+        }
+
+        auto margin = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(spinMargin));
+        if (deadline - start > margin) {
+            auto wake = deadline - margin;
+            std::this_thread::sleep_until(wake);
+
+            double overshoot = std::chrono::duration<double>(Clock::now() - wake).count();
+            spinMargin = std::clamp(std::max(spinMargin * 0.99, overshoot * 1.5), 0.0002, 0.004);
+        }
+
+        while (Clock::now() < deadline) {
+            std::this_thread::yield();
+        }
+    }
+
+    void sampleCpu()
+    {
+        double wall = now();
+        if (wall - cpuSampleWall < 0.5) {
+            return;
+        }
+
+        double cpu = processCpuSeconds();
+        cpuPercent = 100.0 * (cpu - cpuSampleCpu) / (wall - cpuSampleWall);
+        cpuSampleCpu = cpu;
+        cpuSampleWall = wall;
+    }
+};
+
+#endif // FRAME_PACER_H
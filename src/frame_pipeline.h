@@ -0,0 +1,136 @@
+#ifndef FRAME_PIPELINE_H
+#define FRAME_PIPELINE_H
+
+#include "triple_buffer.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// two-stage frame pipeline. the update stage turns an input into an immutable snapshot on its
+// own thread while the caller renders the snapshot of the previous input, so a frame costs the
+// slower of the two stages instead of their sum. inputs and snapshots are handed over through
+// triple buffers; the mutex only parks whichever side ran out of work.
+//
+// every input produces exactly one snapshot and each is consumed before the next input is
+// posted, so snapshots can carry deltas. with threading off the update runs inline and the
+// snapshot of the current input is returned, the single-threaded reference.
+template <typename Input, typename Snapshot>
+struct FramePipeline {
+    std::function<void(const Input&, Snapshot&)> update;
+
+    TripleBuffer<Input> inputs;
+    TripleBuffer<Snapshot> snapshots;
+
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable wakeWorker;
+    std::condition_variable wakeMain;
+    bool quit = false;
+
+    bool threaded = false;
+    bool inFlight = false; // an input was posted and its snapshot not taken yet
+    bool primed = false; // a snapshot was taken at least once
+    double waitMs = 0.0; // time step() spent blocked on the update stage
+
+    ~FramePipeline() { shutdown(); }
+
+    // with a single hardware thread the stages would only time-slice, so the update runs inline
+    void init(std::function<void(const Input&, Snapshot&)> fn, bool useThread)
+    {
+        update = std::move(fn);
+        threaded = useThread && std::thread::hardware_concurrency() > 1;
+        worker = std::thread([this] { run(); });
+    }
+
+    void shutdown()
+    {
+        if (!worker.joinable()) {
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            quit = true;
+        }
+        wakeWorker.notify_one();
+        worker.join();
+    }
+
+    // post the input of this frame and return the snapshot to render. threaded, that is the
+    // snapshot of the previous input; the very first one is produced before returning.
+    const Snapshot& step(const Input& input)
+    {
+        waitMs = 0.0;
+
+        if (!threaded) {
+            if (inFlight) {
+                take();
+            }
+            update(input, snapshots.writeSlot());
+            snapshots.publish();
+            snapshots.acquire();
+            primed = true;
+            return snapshots.readSlot();
+        }
+
+        if (inFlight) {
+            take();
+        }
+
+        inputs.writeSlot() = input;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            inputs.publish();
+        }
+        wakeWorker.notify_one();
+        inFlight = true;
+
+        if (!primed) {
+            take();
+        }
+        return snapshots.readSlot();
+    }
+
+    // block until the posted input's snapshot is published and swap it in
+    void take()
+    {
+        auto waitStart = std::chrono::steady_clock::now();
+        if (!snapshots.acquire()) {
+            std::unique_lock<std::mutex> lock(mutex);
+            wakeMain.wait(lock, [this] { return snapshots.fresh(); });
+            lock.unlock();
+            snapshots.acquire();
+        }
+        waitMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - waitStart).count();
+
+        inFlight = false;
+        primed = true;
+    }
+
+    void run()
+    {
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wakeWorker.wait(lock, [this] { return quit || inputs.fresh(); });
+                if (quit) {
+                    return;
+                }
+            }
+
+            inputs.acquire();
+            update(inputs.readSlot(), snapshots.writeSlot());
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                snapshots.publish();
+            }
+            wakeMain.notify_one();
+        }
+    }
+};
+
+#endif // FRAME_PIPELINE_H
@@ -0,0 +1,27 @@
+#ifndef FRAME_UNIFORMS_H
+#define FRAME_UNIFORMS_H
+
+#define GLAD_IMPLEMENTATION
+#include "glad/glad.h"
+
+#include <glm/glm.hpp>
+
+// host mirror of `layout(std140) uniform Frame` in shaders/vertex.glsl, keep both in sync.
+// every member is either a mat4 or a 4 byte scalar packed so no std140 padding is implied.
+struct FrameUniforms {
+    static constexpr GLuint binding = 0;
+
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::mat4 viewProjection;
+    GLint rotateAnimX;
+    GLint rotateAnimY;
+    GLint rotateAnimZ;
+    float time;
+    float animSpeed;
+    float pad[3];
+};
+
+static_assert(sizeof(FrameUniforms) == 224, "FrameUniforms must match the std140 layout of the Frame block");
+
+#endif // FRAME_UNIFORMS_H
@@ -0,0 +1,87 @@
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+
+#define GLAD_IMPLEMENTATION
+#include "glad/glad.h"
+
+#include "gl_resources.h"
+
+#include <cstdio>
+
+// offscreen render target with an RGBA8 color texture and a depth renderbuffer
+struct Fbo {
+    GLuint id {};
+    GLuint color {};
+    GLuint depth {};
+    int width = 0;
+    int height = 0;
+
+    ~Fbo() { release(); }
+
+    // `name` labels the framebuffer and its attachments in the resource registry
+    bool init(int w, int h, const char* name = "framebuffer", const char* file = __builtin_FILE(), int line = __builtin_LINE())
+    {
+        release();
+        width = w;
+        height = h;
+
+        glGenTextures(1, &color);
+        GlResources::name(GlResourceTexture, color, name, file, line);
+        glBindTexture(GL_TEXTURE_2D, color);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        glGenRenderbuffers(1, &depth);
+        GlResources::name(GlResourceRenderbuffer, depth, name, file, line);
+        glBindRenderbuffer(GL_RENDERBUFFER, depth);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+        glGenFramebuffers(1, &id);
+        GlResources::name(GlResourceFramebuffer, id, name, file, line);
+        glBindFramebuffer(GL_FRAMEBUFFER, id);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, color, 0);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depth);
+
+        GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+        if (status != GL_FRAMEBUFFER_COMPLETE) {
+            fprintf(stderr, "err: framebuffer incomplete (0x%x)\n", status);
+            release();
+            return false;
+        }
+
+        return true;
+    }
+
+    void bind() const
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, id);
+        glViewport(0, 0, width, height);
+    }
+
+    void unbind() const { glBindFramebuffer(GL_FRAMEBUFFER, 0); }
+
+    void release()
+    {
+        if (id) {
+            glDeleteFramebuffers(1, &id);
+            id = 0;
+        }
+        if (depth) {
+            glDeleteRenderbuffers(1, &depth);
+            depth = 0;
+        }
+        if (color) {
+            glDeleteTextures(1, &color);
+            color = 0;
+        }
+    }
+};
+
+#endif // FRAMEBUFFER_H
@@ -1,29 +1,73 @@
+#ifndef GL_BUFFER_H
+#define GL_BUFFER_H
+
 #define GLAD_IMPLEMENTATION
 #include "glad/glad.h"
 
+#include "gl_resources.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+// the wrappers own their GL name and are move-only, a copy would delete it twice. a moved-from
+// wrapper holds the name it was assigned over, or 0, and deletes that. the optional debug name
+// and the constructing site are shown by the resource registry.
 struct Vao {
     GLuint id {};
-    Vao() { glGenVertexArrays(1, &id); }
+    explicit Vao(const char* name = nullptr, const char* file = __builtin_FILE(), int line = __builtin_LINE())
+    {
+        glGenVertexArrays(1, &id);
+        GlResources::name(GlResourceVertexArray, id, name, file, line);
+    }
     ~Vao() { glDeleteVertexArrays(1, &id); }
+
+    Vao(const Vao&) = delete;
+    Vao& operator=(const Vao&) = delete;
+    Vao(Vao&& other) noexcept : id(std::exchange(other.id, 0)) { }
+    Vao& operator=(Vao&& other) noexcept
+    {
+        std::swap(id, other.id);
+        return *this;
+    }
+
     void bind() const { glBindVertexArray(id); }
     void unbind() const { glBindVertexArray(0); }
-    void attrib(GLuint index, GLint size, GLenum type, GLboolean norm, GLsizei stride, GLintptr offset) const { 
+
+    // configure the bound vao
+    static void attrib(GLuint index, GLint size, GLenum type, GLboolean norm, GLsizei stride, GLintptr offset)
+    {
         glVertexAttribPointer(index, size, type, norm, stride, (void*)offset);
         glEnableVertexAttribArray(index);
     }
+    static void divisor(GLuint index, GLuint d) { glVertexAttribDivisor(index, d); }
 };
 
 struct Vbo {
     GLuint id {};
     GLenum target {};
 
-    explicit Vbo(GLenum t = GL_ARRAY_BUFFER)
+    explicit Vbo(GLenum t = GL_ARRAY_BUFFER, const char* name = nullptr, const char* file = __builtin_FILE(), int line = __builtin_LINE())
         : target(t)
     {
         glGenBuffers(1, &id);
+        GlResources::name(GlResourceBuffer, id, name, file, line);
     }
     ~Vbo() { glDeleteBuffers(1, &id); }
 
+    Vbo(const Vbo&) = delete;
+    Vbo& operator=(const Vbo&) = delete;
+    Vbo(Vbo&& other) noexcept : id(std::exchange(other.id, 0)), target(other.target) { }
+    Vbo& operator=(Vbo&& other) noexcept
+    {
+        std::swap(id, other.id);
+        std::swap(target, other.target);
+        return *this;
+    }
+
     void bind() const { glBindBuffer(target, id); }
     void unbind() const { glBindBuffer(target, 0); }
 
@@ -37,13 +81,24 @@ struct Ebo {
     GLuint id {};
     GLenum target {};
 
-    explicit Ebo(GLenum t = GL_ELEMENT_ARRAY_BUFFER)
+    explicit Ebo(GLenum t = GL_ELEMENT_ARRAY_BUFFER, const char* name = nullptr, const char* file = __builtin_FILE(), int line = __builtin_LINE())
         : target(t)
     {
         glGenBuffers(1, &id);
+        GlResources::name(GlResourceBuffer, id, name, file, line);
     }
     ~Ebo() { glDeleteBuffers(1, &id); }
 
+    Ebo(const Ebo&) = delete;
+    Ebo& operator=(const Ebo&) = delete;
+    Ebo(Ebo&& other) noexcept : id(std::exchange(other.id, 0)), target(other.target) { }
+    Ebo& operator=(Ebo&& other) noexcept
+    {
+        std::swap(id, other.id);
+        std::swap(target, other.target);
+        return *this;
+    }
+
     void bind() const { glBindBuffer(target, id); }
     void unbind() const { glBindBuffer(target, 0); }
 
@@ -52,3 +107,331 @@ struct Ebo {
         glBufferData(target, size, data, usage);
     }
 };
+
+// keeps a CPU copy of the buffer and uploads only the byte ranges written since the last flush
+struct DirtyBuffer {
+    GLuint id {};
+    GLenum target {};
+    std::vector<uint8_t> shadow;
+    std::vector<std::pair<size_t, size_t>> dirty; // [begin, end)
+
+    // ranges closer than this are merged into one upload
+    static constexpr size_t mergeGap = 256;
+
+    explicit DirtyBuffer(GLenum t = GL_ARRAY_BUFFER, const char* name = nullptr, const char* file = __builtin_FILE(), int line = __builtin_LINE())
+        : target(t)
+    {
+        glGenBuffers(1, &id);
+        GlResources::name(GlResourceBuffer, id, name, file, line);
+    }
+    ~DirtyBuffer() { glDeleteBuffers(1, &id); }
+
+    DirtyBuffer(const DirtyBuffer&) = delete;
+    DirtyBuffer& operator=(const DirtyBuffer&) = delete;
+    DirtyBuffer(DirtyBuffer&& other) noexcept
+        : id(std::exchange(other.id, 0))
+        , target(other.target)
+        , shadow(std::move(other.shadow))
+        , dirty(std::move(other.dirty))
+    {
+    }
+    DirtyBuffer& operator=(DirtyBuffer&& other) noexcept
+    {
+        std::swap(id, other.id);
+        std::swap(target, other.target);
+        shadow.swap(other.shadow);
+        dirty.swap(other.dirty);
+        return *this;
+    }
+
+    void bind() const { glBindBuffer(target, id); }
+    void unbind() const { glBindBuffer(target, 0); }
+
+    // allocate storage and upload everything once, expects the buffer to be bound
+    void fill(size_t size, const void* data, GLenum usage = GL_STATIC_DRAW)
+    {
+        if (data) {
+            shadow.assign((const uint8_t*)data, (const uint8_t*)data + size);
+        } else {
+            shadow.assign(size, 0);
+        }
+        dirty.clear();
+        glBufferData(target, size, data, usage);
+    }
+
+    // copy into the shadow store, ranges that did not change are not marked dirty
+    void write(size_t offset, const void* data, size_t size)
+    {
+        if (offset + size > shadow.size()) {
+            fprintf(stderr, "err: dirty buffer write [%zu, %zu) out of range %zu\n", offset, offset + size, shadow.size());
+            return;
+        }
+
+        if (memcmp(shadow.data() + offset, data, size) == 0) {
+            return;
+        }
+
+        memcpy(shadow.data() + offset, data, size);
+        dirty.emplace_back(offset, offset + size);
+    }
+
+    bool isDirty() const { return !dirty.empty(); }
+
+    // upload the merged dirty ranges, expects the buffer to be bound. returns bytes uploaded
+    size_t flush()
+    {
+        if (dirty.empty()) {
+            return 0;
+        }
+
+        std::sort(dirty.begin(), dirty.end());
+
+        size_t uploaded = 0;
+        size_t begin = dirty[0].first;
+        size_t end = dirty[0].second;
+        for (size_t i = 1; i <= dirty.size(); i++) {
+            if (i < dirty.size() && dirty[i].first <= end + mergeGap) {
+                end = std::max(end, dirty[i].second);
+                continue;
+            }
+
+            glBufferSubData(target, begin, end - begin, shadow.data() + begin);
+            uploaded += end - begin;
+
+            if (i < dirty.size()) {
+                begin = dirty[i].first;
+                end = dirty[i].second;
+            }
+        }
+
+        dirty.clear();
+        return uploaded;
+    }
+};
+
+// ring of per-frame segments for data rewritten every frame. each segment is fenced when
+// the frame is submitted and only reused once the GPU is done with it. with
+// ARB_buffer_storage the ring is persistently mapped; otherwise each write maps its range
+// unsynchronized and the buffer is orphaned instead of waiting when the GPU falls behind.
+struct StreamBuffer {
+    static constexpr int segmentCount = 3;
+
+    GLuint id {};
+    GLenum target {};
+    GLsizeiptr segmentSize = 0;
+    GLsizeiptr head = 0;
+    int segment = 0;
+    GLsync fences[segmentCount] {};
+    uint8_t* mapped = nullptr;
+
+    // debug name and site, the storage is created and named in init()
+    const char* name = nullptr;
+    const char* file = nullptr;
+    int line = 0;
+
+    explicit StreamBuffer(GLenum t = GL_ARRAY_BUFFER, const char* n = nullptr, const char* f = __builtin_FILE(), int l = __builtin_LINE())
+        : target(t)
+        , name(n)
+        , file(f)
+        , line(l)
+    {
+    }
+    ~StreamBuffer() { release(); }
+
+    StreamBuffer(const StreamBuffer&) = delete;
+    StreamBuffer& operator=(const StreamBuffer&) = delete;
+    StreamBuffer(StreamBuffer&& other) noexcept
+        : target(other.target)
+    {
+        swap(other);
+    }
+    StreamBuffer& operator=(StreamBuffer&& other) noexcept
+    {
+        swap(other);
+        return *this;
+    }
+
+    void swap(StreamBuffer& other) noexcept
+    {
+        std::swap(id, other.id);
+        std::swap(target, other.target);
+        std::swap(segmentSize, other.segmentSize);
+        std::swap(head, other.head);
+        std::swap(segment, other.segment);
+        std::swap(fences, other.fences);
+        std::swap(mapped, other.mapped);
+        std::swap(name, other.name);
+        std::swap(file, other.file);
+        std::swap(line, other.line);
+    }
+
+    void bind() const { glBindBuffer(target, id); }
+    void unbind() const { glBindBuffer(target, 0); }
+
+    void bindRange(GLuint binding, GLintptr offset, GLsizeiptr size) const { glBindBufferRange(target, binding, id, offset, size); }
+
+    bool persistent() const { return mapped != nullptr; }
+
+    // (re)create storage for `size` bytes per frame
+    void init(GLsizeiptr size)
+    {
+        release();
+
+        segmentSize = size;
+        head = 0;
+        segment = 0;
+
+        glGenBuffers(1, &id);
+        GlResources::name(GlResourceBuffer, id, name, file, line);
+        glBindBuffer(target, id);
+
+        GLsizeiptr total = segmentSize * segmentCount;
+        if (GLAD_GL_ARB_buffer_storage) {
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            glBufferStorage(target, total, nullptr, flags);
+            mapped = (uint8_t*)glMapBufferRange(target, 0, total, flags);
+        } else {
+            glBufferData(target, total, nullptr, GL_STREAM_DRAW);
+        }
+
+        glBindBuffer(target, 0);
+    }
+
+    // grow the ring so a frame can hold `size` bytes, drops the previous storage. true when
+    // the buffer was recreated, its name may be reused so attribute bindings must be redone
+    bool reserve(GLsizeiptr size)
+    {
+        if (size <= segmentSize) {
+            return false;
+        }
+        init(std::max(size, segmentSize * 2));
+        return true;
+    }
+
+    // copy `size` bytes into this frame's segment and return their absolute offset in the
+    // buffer, or -1 when the segment is full. expects the buffer to be bound when not persistent
+    GLintptr write(const void* data, GLsizeiptr size, GLsizeiptr alignment = 4)
+    {
+        if (!segmentFree()) {
+            fprintf(stderr, "err: stream buffer segment %d is still in use by the gpu\n", segment);
+            return -1;
+        }
+
+        GLsizeiptr offset = (head + alignment - 1) / alignment * alignment;
+        if (offset + size > segmentSize) {
+            fprintf(stderr, "err: stream buffer segment overflow (%d + %d > %d)\n", (int)offset, (int)size, (int)segmentSize);
+            return -1;
+        }
+
+        GLintptr absolute = segment * segmentSize + offset;
+        if (mapped) {
+            memcpy(mapped + absolute, data, size);
+        } else {
+            GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+            void* dst = glMapBufferRange(target, absolute, size, access);
+            if (!dst) {
+                fprintf(stderr, "err: failed to map stream buffer range\n");
+                return -1;
+            }
+            memcpy(dst, data, size);
+            glUnmapBuffer(target);
+        }
+        GlResources::upload(id, size);
+
+        head = offset + size;
+        return absolute;
+    }
+
+    // fence the segment written this frame and move on to the next one
+    void endFrame()
+    {
+        if (fences[segment]) {
+            glDeleteSync(fences[segment]);
+        }
+        fences[segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+        segment = (segment + 1) % segmentCount;
+        head = 0;
+
+        GLsync fence = fences[segment];
+        if (!fence) {
+            return;
+        }
+
+        // the gpu is usually segmentCount - 1 frames ahead, so this rarely has to wait
+        GLenum status = glClientWaitSync(fence, 0, 0);
+        if (status == GL_TIMEOUT_EXPIRED && !mapped) {
+            orphan();
+            return;
+        }
+
+        if (status == GL_TIMEOUT_EXPIRED) {
+            status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, (GLuint64)1e9);
+        }
+
+        // a segment the gpu still reads keeps its fence, write() refuses it until it signals
+        if (status == GL_TIMEOUT_EXPIRED || status == GL_WAIT_FAILED) {
+            fprintf(stderr, "warn: stream buffer segment %d still in use after 1 s\n", segment);
+            return;
+        }
+
+        glDeleteSync(fence);
+        fences[segment] = 0;
+    }
+
+    // true once the current segment's fence has signaled, drops the fence then
+    bool segmentFree()
+    {
+        GLsync fence = fences[segment];
+        if (!fence) {
+            return true;
+        }
+
+        GLenum status = glClientWaitSync(fence, 0, 0);
+        if (status == GL_TIMEOUT_EXPIRED || status == GL_WAIT_FAILED) {
+            return false;
+        }
+
+        glDeleteSync(fence);
+        fences[segment] = 0;
+        return true;
+    }
+
+    // give the driver fresh storage so in-flight draws keep the old one
+    void orphan()
+    {
+        glBindBuffer(target, id);
+        glBufferData(target, segmentSize * segmentCount, nullptr, GL_STREAM_DRAW);
+        glBindBuffer(target, 0);
+
+        for (auto& fence : fences) {
+            if (fence) {
+                glDeleteSync(fence);
+                fence = 0;
+            }
+        }
+    }
+
+    void release()
+    {
+        for (auto& fence : fences) {
+            if (fence) {
+                glDeleteSync(fence);
+                fence = 0;
+            }
+        }
+
+        if (id) {
+            if (mapped) {
+                glBindBuffer(target, id);
+                glUnmapBuffer(target);
+                glBindBuffer(target, 0);
+                mapped = nullptr;
+            }
+            glDeleteBuffers(1, &id);
+            id = 0;
+        }
+    }
+};
+
+#endif // GL_BUFFER_H
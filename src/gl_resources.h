@@ -0,0 +1,527 @@
+#ifndef GL_RESOURCES_H
+#define GL_RESOURCES_H
+
+#define GLAD_IMPLEMENTATION
+#include "glad/glad.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <iterator>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+enum GlResourceKind {
+    GlResourceBuffer,
+    GlResourceVertexArray,
+    GlResourceProgram,
+    GlResourceFramebuffer,
+    GlResourceTexture,
+    GlResourceRenderbuffer,
+    GlResourceQuery,
+    GlResourceKindCount,
+};
+
+inline constexpr const char* glResourceKindNames[] = { "buffers", "vertex arrays", "programs", "framebuffers", "textures", "renderbuffers", "queries" };
+
+struct GlResource {
+    GlResourceKind kind = GlResourceBuffer;
+    GLuint id = 0;
+    std::string name; // empty until named
+    const char* file = nullptr; // where it was named
+    int line = 0;
+    GLenum usage = 0; // usage hint of the last glBufferData
+    bool immutable = false; // glBufferStorage
+    size_t bytes = 0; // current storage
+    uint64_t uploaded = 0; // bytes written from the cpu over the lifetime
+    uint64_t frameUploaded = 0; // the same, this frame
+    uint64_t lastUploaded = 0; // the same, last frame
+    uint32_t reallocations = 0; // glBufferData calls that replaced existing storage
+    uint64_t createdFrame = 0;
+};
+
+struct GlResourceTotals {
+    int count[GlResourceKindCount] {};
+    size_t bytes[GlResourceKindCount] {};
+};
+
+struct GlUploadStats {
+    uint64_t bytes = 0;
+    uint32_t uploads = 0;
+    uint32_t reallocations = 0;
+    uint32_t created = 0;
+    uint32_t deleted = 0;
+};
+
+// shadow of the bindings storage calls act on, kept up to date by the bind hooks so the registry
+// never has to query the driver, which would sync a threaded one. it follows the main context,
+// the only one that binds buffers and textures; imgui's backend binds through its own loader
+// and restores what it found. the element buffer is vertex array state.
+struct GlBindings {
+    static constexpr int bufferTargets = 10;
+    static constexpr int textureUnits = 32;
+
+    static inline GLuint buffers[bufferTargets] {};
+    static inline GLuint vertexArray = 0;
+    static inline std::unordered_map<GLuint, GLuint> elementBuffers; // by vertex array
+    static inline GLuint textures2D[textureUnits] {};
+    static inline int activeUnit = 0;
+    static inline GLuint renderbuffer = 0;
+
+    static int bufferSlot(GLenum target)
+    {
+        switch (target) {
+        case GL_ARRAY_BUFFER: return 0;
+        case GL_UNIFORM_BUFFER: return 1;
+        case GL_COPY_READ_BUFFER: return 2;
+        case GL_COPY_WRITE_BUFFER: return 3;
+        case GL_PIXEL_PACK_BUFFER: return 4;
+        case GL_PIXEL_UNPACK_BUFFER: return 5;
+        case GL_DRAW_INDIRECT_BUFFER: return 6;
+        case GL_DISPATCH_INDIRECT_BUFFER: return 7;
+        case GL_SHADER_STORAGE_BUFFER: return 8;
+        case GL_TRANSFORM_FEEDBACK_BUFFER: return 9;
+        default: return -1;
+        }
+    }
+
+    static GLuint buffer(GLenum target)
+    {
+        if (target == GL_ELEMENT_ARRAY_BUFFER) {
+            auto it = elementBuffers.find(vertexArray);
+            return it != elementBuffers.end() ? it->second : 0;
+        }
+        int slot = bufferSlot(target);
+        return slot >= 0 ? buffers[slot] : 0;
+    }
+
+    static void bindBuffer(GLenum target, GLuint id)
+    {
+        if (target == GL_ELEMENT_ARRAY_BUFFER) {
+            elementBuffers[vertexArray] = id;
+            return;
+        }
+        int slot = bufferSlot(target);
+        if (slot >= 0) {
+            buffers[slot] = id;
+        }
+    }
+
+    static GLuint texture2D() { return textures2D[activeUnit]; }
+
+    // deleting a bound object unbinds it from the current context
+    static void forget(GlResourceKind kind, GLuint id)
+    {
+        switch (kind) {
+        case GlResourceBuffer:
+            std::replace(std::begin(buffers), std::end(buffers), id, 0u);
+            if (buffer(GL_ELEMENT_ARRAY_BUFFER) == id) {
+                elementBuffers.erase(vertexArray);
+            }
+            break;
+        case GlResourceVertexArray:
+            elementBuffers.erase(id);
+            vertexArray = vertexArray == id ? 0 : vertexArray;
+            break;
+        case GlResourceTexture:
+            std::replace(std::begin(textures2D), std::end(textures2D), id, 0u);
+            break;
+        case GlResourceRenderbuffer:
+            renderbuffer = renderbuffer == id ? 0 : renderbuffer;
+            break;
+        default:
+            break;
+        }
+    }
+};
+
+// registry of every GL object made through glad's function pointers. creation, deletion and
+// storage calls are hooked like GlStats does, so objects are tracked without their owners
+// registering them; owners only attach a debug name. storage sizes come from glBufferData,
+// glBufferStorage, glTexImage2D and glRenderbufferStorage, uploads from the sub data calls
+// and from StreamBuffer writes into mapped memory. the object a storage call targets comes
+// from GlBindings. programs may be created on the shader compiler thread, so the registry is
+// under one mutex. reportLeaks() lists the objects still alive once their owners are gone.
+struct GlResources {
+    static constexpr int historySize = 240;
+
+    static inline std::mutex mutex;
+    static inline std::unordered_map<uint64_t, GlResource> objects; // kind << 32 | id
+    static inline GlUploadStats current {};
+    static inline GlUploadStats last {};
+    static inline uint64_t frame = 0;
+    static inline float uploadHistory[historySize] {}; // KB per frame
+    static inline int historyHead = 0;
+    static inline bool installed = false;
+
+    static uint64_t key(GlResourceKind kind, GLuint id) { return (uint64_t)kind << 32 | id; }
+
+    static void install();
+
+    // attach a debug name to a tracked object, the call site is kept as its origin
+    static void name(GlResourceKind kind, GLuint id, const char* name, const char* file = __builtin_FILE(), int line = __builtin_LINE())
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = objects.find(key(kind, id));
+        if (it == objects.end()) {
+            return;
+        }
+        if (name) {
+            it->second.name = name;
+        }
+        it->second.file = file;
+        it->second.line = line;
+    }
+
+    // bytes written to a buffer outside the hooked calls, through a mapping
+    static void upload(GLuint buffer, size_t bytes)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = objects.find(key(GlResourceBuffer, buffer));
+        if (it != objects.end()) {
+            it->second.uploaded += bytes;
+            it->second.frameUploaded += bytes;
+        }
+        current.bytes += bytes;
+        current.uploads++;
+    }
+
+    static void endFrame()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& [k, object] : objects) {
+            object.lastUploaded = object.frameUploaded;
+            object.frameUploaded = 0;
+        }
+        last = current;
+        current = GlUploadStats {};
+        uploadHistory[historyHead] = last.bytes / 1024.0f;
+        historyHead = (historyHead + 1) % historySize;
+        frame++;
+    }
+
+    static GlResourceTotals totals()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        GlResourceTotals t;
+        for (const auto& [k, object] : objects) {
+            t.count[object.kind]++;
+            t.bytes[object.kind] += object.bytes;
+        }
+        return t;
+    }
+
+    // copy of the tracked objects, largest first
+    static std::vector<GlResource> snapshot()
+    {
+        std::vector<GlResource> list;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            list.reserve(objects.size());
+            for (const auto& [k, object] : objects) {
+                list.push_back(object);
+            }
+        }
+        std::sort(list.begin(), list.end(), [](const GlResource& a, const GlResource& b) {
+            return a.bytes != b.bytes ? a.bytes > b.bytes : a.kind != b.kind ? a.kind < b.kind : a.id < b.id;
+        });
+        return list;
+    }
+
+    static const char* usageName(GLenum usage)
+    {
+        switch (usage) {
+        case GL_STATIC_DRAW: return "static draw";
+        case GL_DYNAMIC_DRAW: return "dynamic draw";
+        case GL_STREAM_DRAW: return "stream draw";
+        case GL_STATIC_READ: return "static read";
+        case GL_DYNAMIC_READ: return "dynamic read";
+        case GL_STREAM_READ: return "stream read";
+        case GL_STATIC_COPY: return "static copy";
+        case GL_DYNAMIC_COPY: return "dynamic copy";
+        case GL_STREAM_COPY: return "stream copy";
+        default: return "-";
+        }
+    }
+
+    static void created(GlResourceKind kind, GLsizei n, const GLuint* ids)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (GLsizei i = 0; i < n; i++) {
+            if (!ids[i]) {
+                continue;
+            }
+            GlResource& object = objects[key(kind, ids[i])];
+            object = GlResource {};
+            object.kind = kind;
+            object.id = ids[i];
+            object.createdFrame = frame;
+            current.created++;
+        }
+    }
+
+    static void deleted(GlResourceKind kind, GLsizei n, const GLuint* ids)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (GLsizei i = 0; i < n; i++) {
+            if (ids[i] && objects.erase(key(kind, ids[i]))) {
+                current.deleted++;
+            }
+            if (ids[i] && kind != GlResourceProgram && kind != GlResourceQuery) {
+                GlBindings::forget(kind, ids[i]);
+            }
+        }
+    }
+
+    // new storage for `id`, `data` uploads it right away
+    static void allocated(GlResourceKind kind, GLuint id, size_t bytes, GLenum usage, bool data, bool immutable = false)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = objects.find(key(kind, id));
+        if (it != objects.end()) {
+            GlResource& object = it->second;
+            if (object.bytes > 0) {
+                object.reallocations++;
+                current.reallocations++;
+            }
+            object.bytes = bytes;
+            object.usage = usage;
+            object.immutable = immutable;
+            if (data) {
+                object.uploaded += bytes;
+                object.frameUploaded += bytes;
+            }
+        }
+        if (data) {
+            current.bytes += bytes;
+            current.uploads++;
+        }
+    }
+
+    // estimate for the formats in use, drivers may pad
+    static size_t texelBytes(GLenum format)
+    {
+        switch (format) {
+        case GL_R8: return 1;
+        case GL_RG8: return 2;
+        case GL_RGB8: return 3;
+        case GL_RGBA16F: return 8;
+        case GL_RGBA32F: return 16;
+        default: return 4;
+        }
+    }
+
+    static void reportLeaks()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!installed || objects.empty()) {
+            return;
+        }
+
+        size_t bytes = 0;
+        for (const auto& [k, object] : objects) {
+            bytes += object.bytes;
+        }
+        fprintf(stderr, "warn: %zu GL objects leaked, %.1f KB\n", objects.size(), bytes / 1024.0);
+        for (const auto& [k, object] : objects) {
+            fprintf(stderr, "warn:   %s %u \"%s\" %zu bytes, from %s:%d\n", glResourceKindNames[object.kind], object.id,
+                object.name.empty() ? "unnamed" : object.name.c_str(), object.bytes, object.file ? object.file : "?", object.line);
+        }
+    }
+};
+
+// glGen* and glDelete* share one signature per direction
+template <auto* Ptr, GlResourceKind Kind>
+struct GlGenHook {
+    static inline void(APIENTRYP original)(GLsizei, GLuint*) = nullptr;
+
+    static void APIENTRY call(GLsizei n, GLuint* ids)
+    {
+        original(n, ids);
+        GlResources::created(Kind, n, ids);
+    }
+
+    static void install()
+    {
+        if (*Ptr && *Ptr != &call) {
+            original = *Ptr;
+            *Ptr = &call;
+        }
+    }
+};
+
+template <auto* Ptr, GlResourceKind Kind>
+struct GlDeleteHook {
+    static inline void(APIENTRYP original)(GLsizei, const GLuint*) = nullptr;
+
+    static void APIENTRY call(GLsizei n, const GLuint* ids)
+    {
+        GlResources::deleted(Kind, n, ids);
+        original(n, ids);
+    }
+
+    static void install()
+    {
+        if (*Ptr && *Ptr != &call) {
+            original = *Ptr;
+            *Ptr = &call;
+        }
+    }
+};
+
+#define GL_RESOURCE_HOOKS(gen, del, kind)                    \
+    GlGenHook<&glad_##gen, kind>::install();                 \
+    GlDeleteHook<&glad_##del, kind>::install()
+
+// calls that create programs or storage
+struct GlResourceHooks {
+    static inline PFNGLCREATEPROGRAMPROC createProgram = nullptr;
+    static inline PFNGLDELETEPROGRAMPROC deleteProgram = nullptr;
+    static inline PFNGLBUFFERDATAPROC bufferData = nullptr;
+    static inline PFNGLBUFFERSTORAGEPROC bufferStorage = nullptr;
+    static inline PFNGLBUFFERSUBDATAPROC bufferSubData = nullptr;
+    static inline PFNGLTEXIMAGE2DPROC texImage2D = nullptr;
+    static inline PFNGLRENDERBUFFERSTORAGEPROC renderbufferStorage = nullptr;
+    static inline PFNGLBINDBUFFERPROC bindBuffer = nullptr;
+    static inline PFNGLBINDBUFFERBASEPROC bindBufferBase = nullptr;
+    static inline PFNGLBINDBUFFERRANGEPROC bindBufferRange = nullptr;
+    static inline PFNGLBINDVERTEXARRAYPROC bindVertexArray = nullptr;
+    static inline PFNGLACTIVETEXTUREPROC activeTexture = nullptr;
+    static inline PFNGLBINDTEXTUREPROC bindTexture = nullptr;
+    static inline PFNGLBINDRENDERBUFFERPROC bindRenderbuffer = nullptr;
+
+    static void APIENTRY onBindBuffer(GLenum target, GLuint id)
+    {
+        GlBindings::bindBuffer(target, id);
+        bindBuffer(target, id);
+    }
+
+    // the indexed binds also replace the generic binding of their target
+    static void APIENTRY onBindBufferBase(GLenum target, GLuint index, GLuint id)
+    {
+        GlBindings::bindBuffer(target, id);
+        bindBufferBase(target, index, id);
+    }
+
+    static void APIENTRY onBindBufferRange(GLenum target, GLuint index, GLuint id, GLintptr offset, GLsizeiptr size)
+    {
+        GlBindings::bindBuffer(target, id);
+        bindBufferRange(target, index, id, offset, size);
+    }
+
+    static void APIENTRY onBindVertexArray(GLuint id)
+    {
+        GlBindings::vertexArray = id;
+        bindVertexArray(id);
+    }
+
+    static void APIENTRY onActiveTexture(GLenum unit)
+    {
+        GlBindings::activeUnit = std::clamp((int)(unit - GL_TEXTURE0), 0, GlBindings::textureUnits - 1);
+        activeTexture(unit);
+    }
+
+    static void APIENTRY onBindTexture(GLenum target, GLuint id)
+    {
+        if (target == GL_TEXTURE_2D) {
+            GlBindings::textures2D[GlBindings::activeUnit] = id;
+        }
+        bindTexture(target, id);
+    }
+
+    static void APIENTRY onBindRenderbuffer(GLenum target, GLuint id)
+    {
+        GlBindings::renderbuffer = id;
+        bindRenderbuffer(target, id);
+    }
+
+    static GLuint APIENTRY onCreateProgram()
+    {
+        GLuint id = createProgram();
+        GlResources::created(GlResourceProgram, 1, &id);
+        return id;
+    }
+
+    static void APIENTRY onDeleteProgram(GLuint id)
+    {
+        GlResources::deleted(GlResourceProgram, 1, &id);
+        deleteProgram(id);
+    }
+
+    static void APIENTRY onBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage)
+    {
+        bufferData(target, size, data, usage);
+        GlResources::allocated(GlResourceBuffer, GlBindings::buffer(target), size, usage, data != nullptr);
+    }
+
+    static void APIENTRY onBufferStorage(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags)
+    {
+        bufferStorage(target, size, data, flags);
+        GlResources::allocated(GlResourceBuffer, GlBindings::buffer(target), size, 0, data != nullptr, true);
+    }
+
+    static void APIENTRY onBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data)
+    {
+        bufferSubData(target, offset, size, data);
+        GlResources::upload(GlBindings::buffer(target), size);
+    }
+
+    // only the base level of 2d textures is accounted
+    static void APIENTRY onTexImage2D(GLenum target, GLint level, GLint format, GLsizei width, GLsizei height, GLint border, GLenum pixelFormat,
+        GLenum type, const void* pixels)
+    {
+        texImage2D(target, level, format, width, height, border, pixelFormat, type, pixels);
+        if (target == GL_TEXTURE_2D && level == 0) {
+            size_t bytes = (size_t)width * height * GlResources::texelBytes(format);
+            GlResources::allocated(GlResourceTexture, GlBindings::texture2D(), bytes, 0, pixels != nullptr);
+        }
+    }
+
+    static void APIENTRY onRenderbufferStorage(GLenum target, GLenum format, GLsizei width, GLsizei height)
+    {
+        renderbufferStorage(target, format, width, height);
+        GlResources::allocated(GlResourceRenderbuffer, GlBindings::renderbuffer, (size_t)width * height * GlResources::texelBytes(format), 0, false);
+    }
+
+    template <typename Fn>
+    static void swap(Fn& fn, Fn& original, Fn hook)
+    {
+        if (fn && fn != hook) {
+            original = fn;
+            fn = hook;
+        }
+    }
+};
+
+// call after GlStats::install so the counting hooks stay underneath
+inline void GlResources::install()
+{
+    GL_RESOURCE_HOOKS(glGenBuffers, glDeleteBuffers, GlResourceBuffer);
+    GL_RESOURCE_HOOKS(glGenVertexArrays, glDeleteVertexArrays, GlResourceVertexArray);
+    GL_RESOURCE_HOOKS(glGenFramebuffers, glDeleteFramebuffers, GlResourceFramebuffer);
+    GL_RESOURCE_HOOKS(glGenTextures, glDeleteTextures, GlResourceTexture);
+    GL_RESOURCE_HOOKS(glGenRenderbuffers, glDeleteRenderbuffers, GlResourceRenderbuffer);
+    GL_RESOURCE_HOOKS(glGenQueries, glDeleteQueries, GlResourceQuery);
+
+    GlResourceHooks::swap(glad_glCreateProgram, GlResourceHooks::createProgram, &GlResourceHooks::onCreateProgram);
+    GlResourceHooks::swap(glad_glDeleteProgram, GlResourceHooks::deleteProgram, &GlResourceHooks::onDeleteProgram);
+    GlResourceHooks::swap(glad_glBufferData, GlResourceHooks::bufferData, &GlResourceHooks::onBufferData);
+    GlResourceHooks::swap(glad_glBufferStorage, GlResourceHooks::bufferStorage, &GlResourceHooks::onBufferStorage);
+    GlResourceHooks::swap(glad_glBufferSubData, GlResourceHooks::bufferSubData, &GlResourceHooks::onBufferSubData);
+    GlResourceHooks::swap(glad_glTexImage2D, GlResourceHooks::texImage2D, &GlResourceHooks::onTexImage2D);
+    GlResourceHooks::swap(glad_glRenderbufferStorage, GlResourceHooks::renderbufferStorage, &GlResourceHooks::onRenderbufferStorage);
+
+    GlResourceHooks::swap(glad_glBindBuffer, GlResourceHooks::bindBuffer, &GlResourceHooks::onBindBuffer);
+    GlResourceHooks::swap(glad_glBindBufferBase, GlResourceHooks::bindBufferBase, &GlResourceHooks::onBindBufferBase);
+    GlResourceHooks::swap(glad_glBindBufferRange, GlResourceHooks::bindBufferRange, &GlResourceHooks::onBindBufferRange);
+    GlResourceHooks::swap(glad_glBindVertexArray, GlResourceHooks::bindVertexArray, &GlResourceHooks::onBindVertexArray);
+    GlResourceHooks::swap(glad_glActiveTexture, GlResourceHooks::activeTexture, &GlResourceHooks::onActiveTexture);
+    GlResourceHooks::swap(glad_glBindTexture, GlResourceHooks::bindTexture, &GlResourceHooks::onBindTexture);
+    GlResourceHooks::swap(glad_glBindRenderbuffer, GlResourceHooks::bindRenderbuffer, &GlResourceHooks::onBindRenderbuffer);
+
+    installed = true;
+}
+
+#endif // GL_RESOURCES_H
@@ -0,0 +1,205 @@
+#ifndef GL_STATE_H
+#define GL_STATE_H
+
+#define GLAD_IMPLEMENTATION
+#include "glad/glad.h"
+
+#include "gl_buffer.h"
+#include "instance.h"
+
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+
+enum UniformKind : uint8_t {
+    UniformFloat,
+    UniformInt,
+    UniformVec3,
+    UniformVec4,
+    UniformMat4,
+};
+
+inline constexpr int uniformKindFloats[] = { 1, 1, 3, 4, 16 };
+
+// remembers the bindings and uniform values it issued and drops changes that would not
+// change anything. bindings made around it are unknown to it, so invalidate() before use
+// whenever other code may have touched them.
+struct GlStateCache {
+    static constexpr GLuint unknown = ~0u;
+
+    struct Counters {
+        uint64_t requested = 0;
+        uint64_t filtered = 0;
+
+        uint64_t applied() const { return requested - filtered; }
+    };
+
+    Counters binds; // programs, vertex arrays, buffers and toggles
+    Counters uniforms;
+
+    GLuint program = unknown;
+    GLuint vao = unknown;
+    GLuint arrayBuffer = unknown;
+    int blend = -1;
+
+    // last value written per program and location, uniforms persist in the program object
+    struct UniformValue {
+        UniformKind kind;
+        float data[16];
+    };
+    std::unordered_map<uint64_t, UniformValue> uniformValues;
+
+    // where each vertex array's instance attributes point, part of the vao state like the
+    // element buffer. meshes of a pool share a vao, so draws reading different instance
+    // buffers re-point them.
+    struct InstanceBinding {
+        GLuint buffer;
+        GLintptr offset;
+    };
+    std::unordered_map<GLuint, InstanceBinding> instanceBindings;
+
+    // bindings only, uniform values stay valid until their program is deleted
+    void invalidate()
+    {
+        program = unknown;
+        vao = unknown;
+        arrayBuffer = unknown;
+        blend = -1;
+    }
+
+    // the program is about to be deleted, its name may be reused by a new one
+    void forget(GLuint id)
+    {
+        for (auto it = uniformValues.begin(); it != uniformValues.end();) {
+            it = (it->first >> 32) == id ? uniformValues.erase(it) : std::next(it);
+        }
+        if (program == id) {
+            program = unknown;
+        }
+    }
+
+    // an instance buffer was recreated and its name may come back for a different buffer
+    void forgetInstances() { instanceBindings.clear(); }
+
+    void resetCounters()
+    {
+        binds = Counters {};
+        uniforms = Counters {};
+    }
+
+    void useProgram(GLuint id)
+    {
+        binds.requested++;
+        if (program == id) {
+            binds.filtered++;
+            return;
+        }
+        glUseProgram(id);
+        program = id;
+    }
+
+    // the vertex array also carries the element buffer binding, there is no separate ebo state
+    void bindVao(GLuint id)
+    {
+        binds.requested++;
+        if (vao == id) {
+            binds.filtered++;
+            return;
+        }
+        glBindVertexArray(id);
+        vao = id;
+    }
+
+    void bindVao(const Vao& v) { bindVao(v.id); }
+
+    void bindArrayBuffer(GLuint id)
+    {
+        binds.requested++;
+        if (arrayBuffer == id) {
+            binds.filtered++;
+            return;
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, id);
+        arrayBuffer = id;
+    }
+
+    void bindArrayBuffer(const Vbo& v) { bindArrayBuffer(v.id); }
+
+    // point the instance attributes of the bound vao at `offset` bytes into `buffer`
+    void bindInstances(GLuint buffer, GLintptr offset)
+    {
+        binds.requested++;
+        auto it = instanceBindings.find(vao);
+        if (vao == unknown || (it != instanceBindings.end() && it->second.buffer == buffer && it->second.offset == offset)) {
+            binds.filtered++;
+            return;
+        }
+
+        bindArrayBuffer(buffer);
+        InstanceData::attribs(offset);
+        instanceBindings[vao] = { buffer, offset };
+    }
+
+    // straight alpha blending, the only mode drawn with
+    void setBlend(bool enabled)
+    {
+        binds.requested++;
+        if (blend == (int)enabled) {
+            binds.filtered++;
+            return;
+        }
+
+        if (enabled) {
+            glEnable(GL_BLEND);
+            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        } else {
+            glDisable(GL_BLEND);
+        }
+        blend = enabled;
+    }
+
+    // writes to the program in use. `data` holds the value as floats, ints bit-copied
+    void setUniform(GLint location, UniformKind kind, const float* data)
+    {
+        if (location < 0 || program == unknown) {
+            return;
+        }
+
+        uniforms.requested++;
+        size_t bytes = uniformKindFloats[kind] * sizeof(float);
+        uint64_t key = ((uint64_t)program << 32) | (uint32_t)location;
+
+        auto it = uniformValues.find(key);
+        if (it != uniformValues.end() && it->second.kind == kind && memcmp(it->second.data, data, bytes) == 0) {
+            uniforms.filtered++;
+            return;
+        }
+
+        UniformValue& value = uniformValues[key];
+        value.kind = kind;
+        memcpy(value.data, data, bytes);
+
+        switch (kind) {
+        case UniformFloat:
+            glUniform1f(location, data[0]);
+            break;
+        case UniformInt: {
+            GLint i;
+            memcpy(&i, data, sizeof(i));
+            glUniform1i(location, i);
+            break;
+        }
+        case UniformVec3:
+            glUniform3fv(location, 1, data);
+            break;
+        case UniformVec4:
+            glUniform4fv(location, 1, data);
+            break;
+        case UniformMat4:
+            glUniformMatrix4fv(location, 1, GL_FALSE, data);
+            break;
+        }
+    }
+};
+
+#endif // GL_STATE_H
@@ -0,0 +1,160 @@
+#ifndef GL_STATS_H
+#define GL_STATS_H
+
+#define GLAD_IMPLEMENTATION
+#include "glad/glad.h"
+
+#include <cstdint>
+
+struct GlFrameStats {
+    uint64_t calls = 0;
+    uint64_t drawCalls = 0;
+    uint64_t vertices = 0;
+};
+
+// counts GL calls made through glad's function pointers by swapping them for counting
+// trampolines after the loader ran. ImGui's OpenGL backend uses its own loader, so its
+// calls are not included.
+struct GlStats {
+    static inline GlFrameStats current {};
+    static inline GlFrameStats last {};
+
+    static void endFrame()
+    {
+        last = current;
+        current = GlFrameStats {};
+    }
+
+    static void install();
+};
+
+template <auto* Ptr, typename Fn>
+struct GlHook;
+
+template <auto* Ptr, typename R, typename... Args>
+struct GlHook<Ptr, R(APIENTRYP)(Args...)> {
+    static inline R(APIENTRYP original)(Args...) = nullptr;
+
+    static R APIENTRY call(Args... args)
+    {
+        GlStats::current.calls++;
+        return original(args...);
+    }
+
+    static void install()
+    {
+        if (*Ptr && *Ptr != &call) {
+            original = *Ptr;
+            *Ptr = &call;
+        }
+    }
+};
+
+#define GL_STATS_HOOK(fn) GlHook<&glad_##fn, decltype(glad_##fn)>::install()
+
+// draw calls also record how many vertices they submit
+struct GlDrawHooks {
+    static inline PFNGLDRAWARRAYSPROC drawArrays = nullptr;
+    static inline PFNGLDRAWELEMENTSPROC drawElements = nullptr;
+    static inline PFNGLDRAWELEMENTSINSTANCEDPROC drawElementsInstanced = nullptr;
+    static inline PFNGLDRAWELEMENTSBASEVERTEXPROC drawElementsBaseVertex = nullptr;
+    static inline PFNGLDRAWELEMENTSINSTANCEDBASEVERTEXPROC drawElementsInstancedBaseVertex = nullptr;
+    static inline PFNGLMULTIDRAWELEMENTSINDIRECTPROC multiDrawElementsIndirect = nullptr;
+
+    static void count(uint64_t vertices)
+    {
+        GlStats::current.calls++;
+        GlStats::current.drawCalls++;
+        GlStats::current.vertices += vertices;
+    }
+
+    static void APIENTRY onDrawArrays(GLenum mode, GLint first, GLsizei count)
+    {
+        GlDrawHooks::count(count);
+        drawArrays(mode, first, count);
+    }
+
+    static void APIENTRY onDrawElements(GLenum mode, GLsizei count, GLenum type, const void* indices)
+    {
+        GlDrawHooks::count(count);
+        drawElements(mode, count, type, indices);
+    }
+
+    static void APIENTRY onDrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instances)
+    {
+        GlDrawHooks::count((uint64_t)count * instances);
+        drawElementsInstanced(mode, count, type, indices, instances);
+    }
+
+    static void APIENTRY onDrawElementsBaseVertex(GLenum mode, GLsizei count, GLenum type, const void* indices, GLint baseVertex)
+    {
+        GlDrawHooks::count(count);
+        drawElementsBaseVertex(mode, count, type, indices, baseVertex);
+    }
+
+    static void APIENTRY onDrawElementsInstancedBaseVertex(GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instances, GLint baseVertex)
+    {
+        GlDrawHooks::count((uint64_t)count * instances);
+        drawElementsInstancedBaseVertex(mode, count, type, indices, instances, baseVertex);
+    }
+
+    // the vertex count of indirect draws is only known to the gpu
+    static void APIENTRY onMultiDrawElementsIndirect(GLenum mode, GLenum type, const void* indirect, GLsizei drawCount, GLsizei stride)
+    {
+        GlDrawHooks::count(0);
+        multiDrawElementsIndirect(mode, type, indirect, drawCount, stride);
+    }
+
+    template <typename Fn>
+    static void swap(Fn& fn, Fn& original, Fn hook)
+    {
+        if (fn && fn != hook) {
+            original = fn;
+            fn = hook;
+        }
+    }
+};
+
+inline void GlStats::install()
+{
+    GlDrawHooks::swap(glad_glDrawArrays, GlDrawHooks::drawArrays, &GlDrawHooks::onDrawArrays);
+    GlDrawHooks::swap(glad_glDrawElements, GlDrawHooks::drawElements, &GlDrawHooks::onDrawElements);
+    GlDrawHooks::swap(glad_glDrawElementsInstanced, GlDrawHooks::drawElementsInstanced, &GlDrawHooks::onDrawElementsInstanced);
+    GlDrawHooks::swap(glad_glDrawElementsBaseVertex, GlDrawHooks::drawElementsBaseVertex, &GlDrawHooks::onDrawElementsBaseVertex);
+    GlDrawHooks::swap(glad_glDrawElementsInstancedBaseVertex, GlDrawHooks::drawElementsInstancedBaseVertex, &GlDrawHooks::onDrawElementsInstancedBaseVertex);
+    GlDrawHooks::swap(glad_glMultiDrawElementsIndirect, GlDrawHooks::multiDrawElementsIndirect, &GlDrawHooks::onMultiDrawElementsIndirect);
+
+    // state
+    GL_STATS_HOOK(glClear);
+    GL_STATS_HOOK(glEnable);
+    GL_STATS_HOOK(glDisable);
+    GL_STATS_HOOK(glViewport);
+    GL_STATS_HOOK(glUseProgram);
+    GL_STATS_HOOK(glBindVertexArray);
+    GL_STATS_HOOK(glBindBuffer);
+    GL_STATS_HOOK(glBindBufferBase);
+    GL_STATS_HOOK(glBindBufferRange);
+
+    // uploads
+    GL_STATS_HOOK(glBufferData);
+    GL_STATS_HOOK(glBufferSubData);
+    GL_STATS_HOOK(glCopyBufferSubData);
+
+    // compute
+    GL_STATS_HOOK(glDispatchCompute);
+    GL_STATS_HOOK(glMemoryBarrier);
+    GL_STATS_HOOK(glMapBufferRange);
+    GL_STATS_HOOK(glUnmapBuffer);
+    GL_STATS_HOOK(glFlushMappedBufferRange);
+    GL_STATS_HOOK(glReadPixels);
+
+    // uniforms
+    GL_STATS_HOOK(glGetUniformLocation);
+    GL_STATS_HOOK(glUniform1i);
+    GL_STATS_HOOK(glUniform1f);
+    GL_STATS_HOOK(glUniform3fv);
+    GL_STATS_HOOK(glUniform4fv);
+    GL_STATS_HOOK(glUniformMatrix4fv);
+}
+
+#endif // GL_STATS_H
@@ -0,0 +1,238 @@
+#ifndef GPU_CULLING_H
+#define GPU_CULLING_H
+
+#define GLAD_IMPLEMENTATION
+#include "glad/glad.h"
+
+#include "bounds.h"
+#include "frame_uniforms.h"
+#include "gl_buffer.h"
+#include "instance.h"
+#include "mesh_pool.h"
+#include "shader.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <string>
+
+// the record glMultiDrawElementsIndirect reads per draw
+struct DrawElementsIndirectCommand {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex; // in indices, not bytes
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+
+static_assert(sizeof(Aabb) == 6 * sizeof(float), "the bounds buffer is read as six floats per object");
+
+// gpu-driven instance submission for GL 4.3 class drivers. the instance and bounds buffers
+// stay on the gpu as storage buffers, shaders/cull_compute.glsl frustum culls them, picks a
+// lod per object and appends the survivors to one range per lod while counting them into the
+// indirect draw records. the whole set is then drawn by a single glMultiDrawElementsIndirect.
+//
+// every lod is a range of the same mesh pool with the same index type, so they share the vao
+// and one element type. each lod owns `capacity` instance slots of the output buffer, the
+// draw records point there through their base instance.
+struct GpuCulling {
+    static constexpr int maxLods = 4;
+    static constexpr GLuint groupSize = 64;
+    static constexpr int readbackFrames = 3;
+
+    // storage buffer bindings of the compute shader
+    static constexpr GLuint instanceBinding = 0;
+    static constexpr GLuint boundsBinding = 1;
+    static constexpr GLuint visibleBinding = 2;
+    static constexpr GLuint commandBinding = 3;
+
+    // host mirror of the Commands block
+    struct CommandBlock {
+        DrawElementsIndirectCommand draws[maxLods];
+        GLuint visibleCount;
+    };
+
+    Shader shader;
+    Uniform<int> objectCount;
+    Uniform<int> lodCountUniform;
+    Uniform<float> lodDistance;
+    Uniform<glm::vec3> cameraPos;
+    Uniform<bool> cull;
+    Uniform<bool> animate;
+
+    DirtyBuffer bounds { GL_ARRAY_BUFFER, "cull bounds" }; // world aabb per object, written from the snapshot deltas
+    Vbo visible { GL_ARRAY_BUFFER, "cull visible instances" }; // culled instances, read as instance attributes
+    Vbo commands { GL_DRAW_INDIRECT_BUFFER, "cull commands" };
+    Vbo readback[readbackFrames];
+    GLsync readbackFences[readbackFrames] {}; // signaled once the copy into the slot landed
+    uint32_t capacity = 0; // instance slots per lod
+
+    CommandBlock block {};
+    int lodCount = 0;
+    GLenum mode = GL_TRIANGLES;
+    GLenum indexType = GL_UNSIGNED_INT;
+
+    // objects that passed the cull a few frames ago, read back without waiting for the gpu
+    uint32_t visibleCount = 0;
+    uint64_t frame = 0;
+
+    ~GpuCulling()
+    {
+        for (GLsync& fence : readbackFences) {
+            if (fence) {
+                glDeleteSync(fence);
+                fence = 0;
+            }
+        }
+    }
+
+    // core in 4.3, llvmpipe exposes all of them
+    static bool supported()
+    {
+        return GLAD_GL_ARB_compute_shader && GLAD_GL_ARB_shader_storage_buffer_object && GLAD_GL_ARB_shader_image_load_store
+            && GLAD_GL_ARB_draw_indirect && GLAD_GL_ARB_multi_draw_indirect && GLAD_GL_ARB_base_instance;
+    }
+
+    // the shader classes build vertex and fragment pairs, the compute program is linked here
+    bool init(const std::string& source)
+    {
+        if (!supported()) {
+            fprintf(stderr, "err: gpu culling needs compute shaders, storage buffers and multi draw indirect\n");
+            return false;
+        }
+
+        const char* text = source.c_str();
+        GLuint compute = glCreateShader(GL_COMPUTE_SHADER);
+        glShaderSource(compute, 1, &text, NULL);
+        glCompileShader(compute);
+
+        GLuint program = glCreateProgram();
+        glAttachShader(program, compute);
+        glLinkProgram(program);
+
+        bool ok = ShaderCompiler::compiled(compute, "compute") && ShaderCompiler::linked(program);
+        glDeleteShader(compute);
+        if (!ok) {
+            glDeleteProgram(program);
+            return false;
+        }
+
+        shader.program = program;
+        GlResources::name(GlResourceProgram, program, "gpu cull");
+        shader.reflect();
+        if (!shader.bindBlock("Frame", FrameUniforms::binding, sizeof(FrameUniforms))) {
+            return false;
+        }
+
+        objectCount = shader.uniform<int>("uObjectCount");
+        lodCountUniform = shader.uniform<int>("uLodCount");
+        lodDistance = shader.uniform<float>("uLodDistance");
+        cameraPos = shader.uniform<glm::vec3>("uCameraPos");
+        cull = shader.uniform<bool>("uCull");
+        animate = shader.uniform<bool>("uAnimate");
+
+        commands.bind();
+        commands.fill(sizeof(CommandBlock), nullptr, GL_DYNAMIC_DRAW);
+        commands.unbind();
+
+        for (Vbo& buffer : readback) {
+            GlResources::name(GlResourceBuffer, buffer.id, "cull readback");
+            glBindBuffer(GL_COPY_WRITE_BUFFER, buffer.id);
+            glBufferData(GL_COPY_WRITE_BUFFER, sizeof(GLuint), nullptr, GL_STREAM_READ);
+        }
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        return true;
+    }
+
+    // meshes drawn from near to far, all from one pool with one index type
+    void setLods(const PoolRange* const* ranges, int count)
+    {
+        lodCount = std::min(count, maxLods);
+        mode = ranges[0]->mode;
+        indexType = ranges[0]->indexType;
+
+        for (int i = 0; i < lodCount; i++) {
+            DrawElementsIndirectCommand& draw = block.draws[i];
+            draw.count = ranges[i]->indexCount;
+            draw.firstIndex = (GLuint)(ranges[i]->indexOffset / indexSize(ranges[i]->indexType));
+            draw.baseVertex = ranges[i]->baseVertex;
+            if (ranges[i]->indexType != indexType) {
+                fprintf(stderr, "err: lod %d has a different index type than lod 0\n", i);
+                lodCount = i;
+                break;
+            }
+        }
+    }
+
+    // cull `count` objects of `instanceBuffer` against the view projection of the bound
+    // Frame block and write this frame's draw records
+    void dispatch(GLuint instanceBuffer, int count, const glm::vec3& eye, float lodStep, bool frustumCull, bool composeAnim)
+    {
+        if (lodCount == 0) {
+            return;
+        }
+
+        // storage is reallocated in place, the buffer name and the vao bindings stay valid
+        if ((uint32_t)count > capacity) {
+            capacity = std::max<uint32_t>(count, capacity * 2);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, visible.id);
+            glBufferData(GL_COPY_WRITE_BUFFER, (GLsizeiptr)capacity * maxLods * sizeof(InstanceData), nullptr, GL_DYNAMIC_COPY);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        }
+
+        for (int i = 0; i < lodCount; i++) {
+            block.draws[i].instanceCount = 0;
+            block.draws[i].baseInstance = i * capacity;
+        }
+        block.visibleCount = 0;
+
+        commands.bind();
+        glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, sizeof(CommandBlock), &block);
+        commands.unbind();
+
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, instanceBinding, instanceBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, boundsBinding, bounds.id);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, visibleBinding, visible.id);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, commandBinding, commands.id);
+
+        glUseProgram(shader.program);
+        objectCount.set(count);
+        lodCountUniform.set(lodCount);
+        lodDistance.set(lodStep);
+        cameraPos.set(eye);
+        cull.set(frustumCull);
+        animate.set(composeAnim);
+        glDispatchCompute((count + groupSize - 1) / groupSize, 1, 1);
+
+        // the draw reads the records and the instances the dispatch wrote, the copy below the
+        // count it incremented atomically
+        glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+
+        // the visible count of this frame is copied aside and read back once the gpu is done
+        // with it, the oldest copy in the ring was written readbackFrames - 1 frames ago. a copy
+        // whose fence has not signaled yet is skipped and the previous count kept
+        int slot = (int)(frame % readbackFrames);
+        glBindBuffer(GL_COPY_READ_BUFFER, commands.id);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, readback[slot].id);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, offsetof(CommandBlock, visibleCount), 0, sizeof(GLuint));
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        if (readbackFences[slot]) {
+            glDeleteSync(readbackFences[slot]);
+        }
+        readbackFences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+        frame++;
+        slot = (int)(frame % readbackFrames);
+        GLsync fence = readbackFences[slot];
+        if (fence && glClientWaitSync(fence, 0, 0) != GL_TIMEOUT_EXPIRED) {
+            glBindBuffer(GL_COPY_READ_BUFFER, readback[slot].id);
+            glGetBufferSubData(GL_COPY_READ_BUFFER, 0, sizeof(GLuint), &visibleCount);
+            glBindBuffer(GL_COPY_READ_BUFFER, 0);
+            glDeleteSync(fence);
+            readbackFences[slot] = 0;
+        }
+    }
+};
+
+#endif // GPU_CULLING_H
@@ -0,0 +1,110 @@
+#ifndef GRID_H
+#define GRID_H
+
+#include "frame_uniforms.h"
+#include "gl_buffer.h"
+#include "render_queue.h"
+#include "shader.h"
+
+#include <glm/glm.hpp>
+
+enum GridMode {
+    GridModeLines,
+    GridModeProcedural,
+};
+
+inline constexpr const char* gridModeNames[] = { "lines", "procedural" };
+
+// ground grid computed per pixel from a single full-screen triangle, its cost depends on the
+// covered pixels only and not on the grid extent
+struct ProceduralGrid {
+    Shader shader;
+    Shader next; // rebuild in flight, replaces `shader` once linked
+    Vao vao { "procedural grid" }; // core profile needs a bound vao even without attributes
+
+    Uniform<glm::mat4> model;
+    Uniform<glm::mat4> modelInv;
+    Uniform<glm::vec4> color;
+    Uniform<float> spacing;
+    Uniform<float> fadeDistance;
+
+    bool init(const std::string& vertSource, const std::string& fragSource)
+    {
+        shader.label = "procedural grid";
+        if (!shader.initFromSource(vertSource, fragSource)) {
+            return false;
+        }
+
+        return resolve(shader);
+    }
+
+    // binds the block and looks up the handles of `program`, which draws from then on. the
+    // handles are left alone when any of it fails
+    bool resolve(const Shader& program)
+    {
+        if (!program.bindBlock("Frame", FrameUniforms::binding, sizeof(FrameUniforms))) {
+            return false;
+        }
+
+        Uniform<glm::mat4> newModel = program.uniform<glm::mat4>("uGridModel");
+        Uniform<glm::mat4> newModelInv = program.uniform<glm::mat4>("uGridModelInv");
+        Uniform<glm::vec4> newColor = program.uniform<glm::vec4>("uGridColor");
+        Uniform<float> newSpacing = program.uniform<float>("uGridSpacing");
+        Uniform<float> newFade = program.uniform<float>("uFadeDistance");
+        if (!newModel.valid() || !newModelInv.valid() || !newColor.valid() || !newSpacing.valid() || !newFade.valid()) {
+            fprintf(stderr, "err: grid shader is missing one of its uniforms\n");
+            return false;
+        }
+
+        model = newModel;
+        modelInv = newModelInv;
+        color = newColor;
+        spacing = newSpacing;
+        fadeDistance = newFade;
+        return true;
+    }
+
+    // rebuild in the background, the current program keeps drawing until the new one links
+    void reload(const std::string& vertSource, const std::string& fragSource)
+    {
+        next.release();
+        next.label = "procedural grid";
+        next.begin(vertSource, fragSource);
+    }
+
+    // swap in a finished rebuild, call once per frame. returns true when a build completed
+    bool poll()
+    {
+        if (!next.pending() || !next.ready()) {
+            return false;
+        }
+
+        if (!next.finish() || !resolve(next)) {
+            fprintf(stderr, "err: failed to rebuild grid shader, keeping the previous program\n");
+            next.release();
+            return true;
+        }
+
+        shader.release();
+        shader = std::move(next);
+        next = Shader {};
+        return true;
+    }
+
+    // lines are blended over the scene and depth tested against it
+    void submit(RenderQueue& queue, const glm::mat4& gridModel, const glm::vec4& gridColor, float gridSpacing, float fade) const
+    {
+        // an unbounded plane has no meaningful distance, it is the only blended draw anyway
+        RenderCommand& cmd = queue.submit(RenderPassBlended, shader, vao.id, 0, 0.0f, 1.0f);
+        cmd.mode = GL_TRIANGLES;
+        cmd.count = 3;
+
+        queue.uniform(model, gridModel);
+        queue.uniform(modelInv, glm::inverse(gridModel));
+        queue.uniform(color, gridColor);
+        queue.uniform(spacing, gridSpacing);
+        queue.uniform(fadeDistance, fade);
+    }
+};
+
+#endif // GRID_H
@@ -8,6 +8,9 @@
 #include "imgui_impl_opengl3.h"
 
 struct Gui {
+    bool m_headless = false;
+    ImVec2 m_displaySize {};
+
     bool init(GLFWwindow* window, const std::string& glslVersion)
     {
         IMGUI_CHECKVERSION();
@@ -29,10 +32,42 @@ struct Gui {
         return true;
     }
 
-    void newFrame()
+    // renderer backend only, display size and time step are fed manually
+    bool initHeadless(int width, int height, const std::string& glslVersion)
     {
-        ImGui_ImplGlfw_NewFrame();
+        IMGUI_CHECKVERSION();
+        if (!ImGui::CreateContext()) {
+            fprintf(stderr, "err: failed to create imgui context\n");
+            return false;
+        }
+
+        if (!ImGui_ImplOpenGL3_Init(glslVersion.c_str())) {
+            fprintf(stderr, "err: failed to initialize ImGui_ImplOpenGL3_Init\n");
+            return false;
+        }
+
+        ImGui::GetIO().IniFilename = nullptr;
+        m_headless = true;
+        m_displaySize = ImVec2((float)width, (float)height);
+        return true;
+    }
+
+    // backends only, the platform input of the frame is queued but not processed yet
+    void beginFrame()
+    {
+        if (m_headless) {
+            ImGuiIO& io = ImGui::GetIO();
+            io.DisplaySize = m_displaySize;
+            io.DeltaTime = 1.0f / 60.0f;
+        } else {
+            ImGui_ImplGlfw_NewFrame();
+        }
         ImGui_ImplOpenGL3_NewFrame();
+    }
+
+    void newFrame()
+    {
+        beginFrame();
         ImGui::NewFrame();
     }
 
@@ -44,7 +79,9 @@ struct Gui {
 
     void shutdown()
     {
-        ImGui_ImplGlfw_Shutdown();
+        if (!m_headless) {
+            ImGui_ImplGlfw_Shutdown();
+        }
         ImGui_ImplOpenGL3_Shutdown();
         ImGui::DestroyContext();
     }
@@ -0,0 +1,151 @@
+#ifndef HEADLESS_CONTEXT_H
+#define HEADLESS_CONTEXT_H
+
+#include <cstdio>
+
+#ifdef __linux__
+#include <dlfcn.h>
+#endif
+
+// surfaceless EGL context for machines without a display, e.g. mesa llvmpipe on a build
+// machine. libEGL is loaded at runtime so the regular build does not depend on it.
+struct HeadlessContext {
+#ifdef __linux__
+    using EGLDisplay = void*;
+    using EGLContext = void*;
+    using EGLConfig = void*;
+    using EGLint = int;
+    using EGLenum = unsigned int;
+    using EGLBoolean = unsigned int;
+
+    static constexpr EGLint EGL_NONE = 0x3038;
+    static constexpr EGLint EGL_EXTENSIONS = 0x3055;
+    static constexpr EGLenum EGL_OPENGL_API = 0x30A2;
+    static constexpr EGLint EGL_CONTEXT_MAJOR_VERSION = 0x3098;
+    static constexpr EGLint EGL_CONTEXT_MINOR_VERSION = 0x30FB;
+    static constexpr EGLint EGL_CONTEXT_OPENGL_PROFILE_MASK = 0x30FD;
+    static constexpr EGLint EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT = 0x00000001;
+    static constexpr EGLenum EGL_PLATFORM_SURFACELESS_MESA = 0x31DD;
+
+    using GetProcAddressFn = void* (*)(const char*);
+    using GetPlatformDisplayFn = EGLDisplay (*)(EGLenum, void*, const EGLint*);
+    using GetDisplayFn = EGLDisplay (*)(void*);
+    using InitializeFn = EGLBoolean (*)(EGLDisplay, EGLint*, EGLint*);
+    using BindAPIFn = EGLBoolean (*)(EGLenum);
+    using CreateContextFn = EGLContext (*)(EGLDisplay, EGLConfig, EGLContext, const EGLint*);
+    using MakeCurrentFn = EGLBoolean (*)(EGLDisplay, void*, void*, EGLContext);
+    using DestroyContextFn = EGLBoolean (*)(EGLDisplay, EGLContext);
+    using TerminateFn = EGLBoolean (*)(EGLDisplay);
+    using GetErrorFn = EGLint (*)();
+
+    static inline void* library = nullptr;
+    static inline GetProcAddressFn eglGetProcAddress = nullptr;
+
+    EGLDisplay display = nullptr;
+    EGLContext context = nullptr;
+    DestroyContextFn eglDestroyContext = nullptr;
+    TerminateFn eglTerminate = nullptr;
+
+    bool init(int major = 3, int minor = 3)
+    {
+        if (!library) {
+            library = dlopen("libEGL.so.1", RTLD_NOW | RTLD_LOCAL);
+        }
+
+        if (!library) {
+            fprintf(stderr, "err: failed to load libEGL.so.1\n");
+            return false;
+        }
+
+        eglGetProcAddress = (GetProcAddressFn)dlsym(library, "eglGetProcAddress");
+        auto eglGetDisplay = (GetDisplayFn)dlsym(library, "eglGetDisplay");
+        auto eglInitialize = (InitializeFn)dlsym(library, "eglInitialize");
+        auto eglBindAPI = (BindAPIFn)dlsym(library, "eglBindAPI");
+        auto eglCreateContext = (CreateContextFn)dlsym(library, "eglCreateContext");
+        auto eglMakeCurrent = (MakeCurrentFn)dlsym(library, "eglMakeCurrent");
+        auto eglGetError = (GetErrorFn)dlsym(library, "eglGetError");
+        eglDestroyContext = (DestroyContextFn)dlsym(library, "eglDestroyContext");
+        eglTerminate = (TerminateFn)dlsym(library, "eglTerminate");
+
+        if (!eglGetProcAddress || !eglGetDisplay || !eglInitialize || !eglBindAPI || !eglCreateContext
+            || !eglMakeCurrent || !eglGetError || !eglDestroyContext || !eglTerminate) {
+            fprintf(stderr, "err: libEGL.so.1 is missing core entry points\n");
+            return false;
+        }
+
+        // prefer the surfaceless platform, it needs neither a display server nor a gpu
+        auto eglGetPlatformDisplayEXT = (GetPlatformDisplayFn)eglGetProcAddress("eglGetPlatformDisplayEXT");
+        if (eglGetPlatformDisplayEXT) {
+            display = eglGetPlatformDisplayEXT(EGL_PLATFORM_SURFACELESS_MESA, nullptr, nullptr);
+        }
+        if (!display) {
+            display = eglGetDisplay(nullptr);
+        }
+
+        EGLint eglMajor = 0, eglMinor = 0;
+        if (!display || !eglInitialize(display, &eglMajor, &eglMinor)) {
+            fprintf(stderr, "err: failed to initialize EGL display (0x%x)\n", eglGetError());
+            return false;
+        }
+
+        if (!eglBindAPI(EGL_OPENGL_API)) {
+            fprintf(stderr, "err: EGL does not support desktop OpenGL (0x%x)\n", eglGetError());
+            shutdown();
+            return false;
+        }
+
+        // configless and surfaceless, all rendering goes to framebuffer objects
+        const EGLint attribs[] = {
+            EGL_CONTEXT_MAJOR_VERSION, major,
+            EGL_CONTEXT_MINOR_VERSION, minor,
+            EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+            EGL_NONE
+        };
+
+        context = eglCreateContext(display, nullptr, nullptr, attribs);
+        if (!context) {
+            fprintf(stderr, "err: failed to create EGL context (0x%x)\n", eglGetError());
+            shutdown();
+            return false;
+        }
+
+        if (!eglMakeCurrent(display, nullptr, nullptr, context)) {
+            fprintf(stderr, "err: failed to make EGL context current (0x%x)\n", eglGetError());
+            shutdown();
+            return false;
+        }
+
+        return true;
+    }
+
+    static void* getProcAddress(const char* name)
+    {
+        return eglGetProcAddress ? eglGetProcAddress(name) : nullptr;
+    }
+
+    void shutdown()
+    {
+        if (context) {
+            eglDestroyContext(display, context);
+            context = nullptr;
+        }
+
+        if (display) {
+            eglTerminate(display);
+            display = nullptr;
+        }
+    }
+#else
+    bool init(int = 3, int = 3)
+    {
+        fprintf(stderr, "err: surfaceless EGL contexts are only supported on linux\n");
+        return false;
+    }
+
+    static void* getProcAddress(const char*) { return nullptr; }
+
+    void shutdown() { }
+#endif
+};
+
+#endif // HEADLESS_CONTEXT_H
@@ -0,0 +1,409 @@
+#ifndef INPUT_LOG_H
+#define INPUT_LOG_H
+
+#include "file.h"
+#include "simulation.h"
+
+#include "imgui.h"
+#include "imgui_internal.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// widget state held by the main loop, logged whole whenever a widget changed it
+struct UiState {
+    SimSettings settings;
+    int selected = 0;
+    int gridMode = 0;
+    float gridFade = 0.0f;
+    float lodDistance = 0.0f;
+    int denseFormat = 0;
+
+    bool operator==(const UiState& o) const
+    {
+        return settings == o.settings && selected == o.selected && gridMode == o.gridMode && gridFade == o.gridFade
+            && lodDistance == o.lodDistance && denseFormat == o.denseFormat;
+    }
+    bool operator!=(const UiState& o) const { return !(*this == o); }
+};
+
+// one imgui input event, see ImGuiInputEvent
+struct LoggedEvent {
+    uint8_t type = 0; // ImGuiInputEventType
+    uint8_t down = 0; // button, key or focus state
+    uint8_t source = 0; // ImGuiMouseSource of mouse events
+    uint8_t pad = 0;
+    uint32_t code = 0; // mouse button, ImGuiKey or character
+    float x = 0.0f; // position, wheel or analog key value
+    float y = 0.0f;
+};
+
+// everything the user did during one drawn frame
+struct InputFrame {
+    float cursorX = 0.0f;
+    float cursorY = 0.0f;
+    uint8_t buttons = 0; // bit per glfw mouse button, left, right and middle
+
+    std::vector<LoggedEvent> events;
+
+    // results of the widgets, applied as recorded so a replay does not depend on the layout
+    bool hasState = false;
+    UiState state;
+    bool setCamera = false;
+    CameraPose camera;
+    std::vector<NodeEdit> edits;
+};
+
+static_assert(std::is_trivially_copyable_v<UiState> && std::is_trivially_copyable_v<CameraPose> && std::is_trivially_copyable_v<NodeEdit>,
+    "logged state is written as raw bytes");
+
+// per-frame interaction log for reproducible performance runs. recording keeps the scene on a
+// fixed clock, stores the polled mouse for the camera, the raw imgui input events and the
+// values widgets produced. a replay feeds the same events back, so the ui does the same work,
+// and then applies the recorded values on top.
+//
+// frames only store what changed since the previous one, an idle frame is a single byte. the
+// header carries the sizes of the raw structs, a log from a build with a different layout is
+// rejected instead of misread.
+struct InputLog {
+    struct FileHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t frameCount; // written when the recording is closed
+        uint32_t width;
+        uint32_t height;
+        float timestep;
+        uint16_t stateSize;
+        uint16_t cameraSize;
+        uint16_t editSize;
+        uint16_t eventSize;
+    };
+
+    static constexpr uint32_t fileMagic = 0x4c494350; // "PCIL"
+    static constexpr uint32_t fileVersion = 1;
+
+    enum Mode {
+        Off,
+        Recording,
+        Replaying,
+    };
+
+    enum FrameFlags : uint8_t {
+        FrameCursor = 1 << 0,
+        FrameButtons = 1 << 1,
+        FrameEvents = 1 << 2,
+        FrameState = 1 << 3,
+        FrameCamera = 1 << 4,
+        FrameEdits = 1 << 5,
+    };
+
+    Mode mode = Off;
+    std::string path;
+    int width = 0;
+    int height = 0;
+    float timestep = 1.0f / 60.0f;
+
+    // initial widget state, applied before the first frame of a replay
+    UiState initial;
+    std::vector<InputFrame> frames; // replay: the whole log
+
+    // recording
+    FILE* file = nullptr;
+    InputFrame current;
+    InputFrame previous;
+    UiState lastState;
+    ImU32 lastEventId = 0;
+    uint32_t frameCount = 0;
+    uint64_t bytes = 0;
+
+    ~InputLog() { close(); }
+
+    bool record(const std::string& logPath, int w, int h, const UiState& state)
+    {
+        file = fopen(logPath.c_str(), "wb");
+        if (!file) {
+            fprintf(stderr, "err: failed to open input log for writing: %s\n", logPath.c_str());
+            return false;
+        }
+
+        mode = Recording;
+        path = logPath;
+        width = w;
+        height = h;
+        initial = lastState = state;
+
+        FileHeader header = makeHeader();
+        put(&header, sizeof(header));
+        put(&initial, sizeof(initial));
+        return true;
+    }
+
+    bool load(const std::string& logPath)
+    {
+        auto data = File::readFile(logPath);
+        if (!data) {
+            fprintf(stderr, "err: failed to read input log: %s\n", logPath.c_str());
+            return false;
+        }
+
+        const uint8_t* p = (const uint8_t*)data->data();
+        const uint8_t* end = p + data->size();
+        auto take = [&](void* out, size_t size) {
+            if ((size_t)(end - p) < size) {
+                return false;
+            }
+            memcpy(out, p, size);
+            p += size;
+            return true;
+        };
+
+        FileHeader header {};
+        FileHeader expected = makeHeader();
+        if (!take(&header, sizeof(header)) || header.magic != fileMagic) {
+            fprintf(stderr, "err: %s is not an input log\n", logPath.c_str());
+            return false;
+        }
+        if (header.version != fileVersion || header.stateSize != expected.stateSize || header.cameraSize != expected.cameraSize
+            || header.editSize != expected.editSize || header.eventSize != expected.eventSize) {
+            fprintf(stderr, "err: input log %s was recorded by an incompatible build\n", logPath.c_str());
+            return false;
+        }
+
+        mode = Replaying;
+        path = logPath;
+        width = (int)header.width;
+        height = (int)header.height;
+        timestep = header.timestep;
+
+        // every frame takes at least its flags byte, a larger count means a corrupt file
+        bool ok = take(&initial, sizeof(initial)) && header.frameCount <= (size_t)(end - p);
+        frames.resize(ok ? header.frameCount : 0);
+        for (uint32_t i = 0; ok && i < header.frameCount; i++) {
+            InputFrame& frame = frames[i];
+            if (i > 0) {
+                frame.cursorX = frames[i - 1].cursorX;
+                frame.cursorY = frames[i - 1].cursorY;
+                frame.buttons = frames[i - 1].buttons;
+            }
+
+            uint8_t flags = 0;
+            ok = take(&flags, 1);
+            if (ok && (flags & FrameCursor)) {
+                ok = take(&frame.cursorX, sizeof(float)) && take(&frame.cursorY, sizeof(float));
+            }
+            if (ok && (flags & FrameButtons)) {
+                ok = take(&frame.buttons, 1);
+            }
+            if (ok && (flags & FrameEvents)) {
+                uint16_t count = 0;
+                ok = take(&count, sizeof(count)) && (size_t)(end - p) >= count * sizeof(LoggedEvent);
+                frame.events.resize(ok ? count : 0);
+                ok = ok && take(frame.events.data(), count * sizeof(LoggedEvent));
+            }
+            if (ok && (flags & FrameState)) {
+                frame.hasState = true;
+                ok = take(&frame.state, sizeof(UiState));
+            }
+            if (ok && (flags & FrameCamera)) {
+                frame.setCamera = true;
+                ok = take(&frame.camera, sizeof(CameraPose));
+            }
+            if (ok && (flags & FrameEdits)) {
+                uint16_t count = 0;
+                ok = take(&count, sizeof(count)) && (size_t)(end - p) >= count * sizeof(NodeEdit);
+                frame.edits.resize(ok ? count : 0);
+                ok = ok && take(frame.edits.data(), count * sizeof(NodeEdit));
+            }
+        }
+
+        if (!ok) {
+            fprintf(stderr, "err: input log %s is truncated\n", logPath.c_str());
+            mode = Off;
+            return false;
+        }
+        return true;
+    }
+
+    // mouse polled for the camera this frame
+    void setCursor(double x, double y, uint8_t buttons)
+    {
+        current.cursorX = (float)x;
+        current.cursorY = (float)y;
+        current.buttons = buttons;
+    }
+
+    // events the platform backend queued since the last frame. call between the backend's new
+    // frame and ImGui::NewFrame, events imgui trickles into a later frame are only taken once.
+    void captureEvents()
+    {
+        for (const ImGuiInputEvent& e : ImGui::GetCurrentContext()->InputEventsQueue) {
+            if (e.EventId <= lastEventId) {
+                continue;
+            }
+            lastEventId = e.EventId;
+
+            LoggedEvent logged;
+            logged.type = (uint8_t)e.Type;
+            switch (e.Type) {
+            case ImGuiInputEventType_MousePos:
+                logged.x = e.MousePos.PosX;
+                logged.y = e.MousePos.PosY;
+                logged.source = (uint8_t)e.MousePos.MouseSource;
+                break;
+            case ImGuiInputEventType_MouseWheel:
+                logged.x = e.MouseWheel.WheelX;
+                logged.y = e.MouseWheel.WheelY;
+                logged.source = (uint8_t)e.MouseWheel.MouseSource;
+                break;
+            case ImGuiInputEventType_MouseButton:
+                logged.code = (uint32_t)e.MouseButton.Button;
+                logged.down = e.MouseButton.Down;
+                logged.source = (uint8_t)e.MouseButton.MouseSource;
+                break;
+            case ImGuiInputEventType_Key:
+                logged.code = (uint32_t)e.Key.Key;
+                logged.down = e.Key.Down;
+                logged.x = e.Key.AnalogValue;
+                break;
+            case ImGuiInputEventType_Text:
+                logged.code = e.Text.Char;
+                break;
+            case ImGuiInputEventType_Focus:
+                logged.down = e.AppFocused.Focused;
+                break;
+            default:
+                continue;
+            }
+            current.events.push_back(logged);
+        }
+    }
+
+    // queue a recorded frame's events as if the platform backend had sent them
+    static void replayEvents(const InputFrame& frame)
+    {
+        ImGuiIO& io = ImGui::GetIO();
+        for (const LoggedEvent& e : frame.events) {
+            switch (e.type) {
+            case ImGuiInputEventType_MousePos:
+                io.AddMouseSourceEvent((ImGuiMouseSource)e.source);
+                io.AddMousePosEvent(e.x, e.y);
+                break;
+            case ImGuiInputEventType_MouseWheel:
+                io.AddMouseSourceEvent((ImGuiMouseSource)e.source);
+                io.AddMouseWheelEvent(e.x, e.y);
+                break;
+            case ImGuiInputEventType_MouseButton:
+                io.AddMouseSourceEvent((ImGuiMouseSource)e.source);
+                io.AddMouseButtonEvent((int)e.code, e.down != 0);
+                break;
+            case ImGuiInputEventType_Key:
+                io.AddKeyAnalogEvent((ImGuiKey)e.code, e.down != 0, e.x);
+                break;
+            case ImGuiInputEventType_Text:
+                io.AddInputCharacter(e.code);
+                break;
+            case ImGuiInputEventType_Focus:
+                io.AddFocusEvent(e.down != 0);
+                break;
+            }
+        }
+    }
+
+    // finish the recorded frame once the widgets ran, `input` holds the edits they made
+    void endFrame(const UiState& state, const SimInput& input)
+    {
+        if (mode != Recording) {
+            return;
+        }
+
+        uint8_t flags = 0;
+        bool first = frameCount == 0;
+        if (first || current.cursorX != previous.cursorX || current.cursorY != previous.cursorY) {
+            flags |= FrameCursor;
+        }
+        if (first || current.buttons != previous.buttons) {
+            flags |= FrameButtons;
+        }
+        flags |= current.events.empty() ? 0 : FrameEvents;
+        flags |= state != lastState ? FrameState : 0;
+        flags |= input.setCamera ? FrameCamera : 0;
+        flags |= input.edits.empty() ? 0 : FrameEdits;
+
+        put(&flags, 1);
+        if (flags & FrameCursor) {
+            put(&current.cursorX, sizeof(float));
+            put(&current.cursorY, sizeof(float));
+        }
+        if (flags & FrameButtons) {
+            put(&current.buttons, 1);
+        }
+        if (flags & FrameEvents) {
+            uint16_t count = (uint16_t)std::min<size_t>(current.events.size(), UINT16_MAX);
+            put(&count, sizeof(count));
+            put(current.events.data(), count * sizeof(LoggedEvent));
+        }
+        if (flags & FrameState) {
+            put(&state, sizeof(UiState));
+            lastState = state;
+        }
+        if (flags & FrameCamera) {
+            put(&input.camera, sizeof(CameraPose));
+        }
+        if (flags & FrameEdits) {
+            uint16_t count = (uint16_t)std::min<size_t>(input.edits.size(), UINT16_MAX);
+            put(&count, sizeof(count));
+            put(input.edits.data(), count * sizeof(NodeEdit));
+        }
+
+        frameCount++;
+        previous = current;
+        current.events.clear();
+    }
+
+    // a recording is only readable once the frame count is patched into the header
+    bool close()
+    {
+        if (!file) {
+            return true;
+        }
+
+        FileHeader header = makeHeader();
+        header.frameCount = frameCount;
+        bool ok = fseek(file, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, file) == 1;
+        ok = fclose(file) == 0 && ok;
+        file = nullptr;
+
+        if (!ok) {
+            fprintf(stderr, "err: failed to write input log %s\n", path.c_str());
+        }
+        return ok;
+    }
+
+    FileHeader makeHeader() const
+    {
+        FileHeader header {};
+        header.magic = fileMagic;
+        header.version = fileVersion;
+        header.width = (uint32_t)width;
+        header.height = (uint32_t)height;
+        header.timestep = timestep;
+        header.stateSize = sizeof(UiState);
+        header.cameraSize = sizeof(CameraPose);
+        header.editSize = sizeof(NodeEdit);
+        header.eventSize = sizeof(LoggedEvent);
+        return header;
+    }
+
+    void put(const void* data, size_t size)
+    {
+        fwrite(data, 1, size, file);
+        bytes += size;
+    }
+};
+
+#endif // INPUT_LOG_H
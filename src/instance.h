@@ -0,0 +1,106 @@
+#ifndef INSTANCE_H
+#define INSTANCE_H
+
+#include "gl_buffer.h"
+#include "job_system.h"
+
+#include <cmath>
+#include <cstddef>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <vector>
+
+// per-instance vertex data, read by shaders/vertex.glsl at locations 2..7
+struct InstanceData {
+    glm::mat4 model { 1.0f };
+    glm::vec4 tint { 1.0f, 1.0f, 1.0f, 1.0f };
+    glm::vec4 anim { 0.0f, 0.0f, 1.0f, 0.0f }; // x = animated, y = phase, z = speed multiplier
+
+    // first attribute location, a mat4 takes four consecutive slots
+    static constexpr GLuint location = 2;
+
+    // configure instanced attributes on the bound vao with the instance buffer bound to GL_ARRAY_BUFFER,
+    // `base` is the byte offset of the first instance in that buffer
+    static void attribs(GLintptr base = 0)
+    {
+        for (GLuint col = 0; col < 4; col++) {
+            Vao::attrib(location + col, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), base + offsetof(InstanceData, model) + col * sizeof(glm::vec4));
+            Vao::divisor(location + col, 1);
+        }
+
+        Vao::attrib(location + 4, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), base + offsetof(InstanceData, tint));
+        Vao::divisor(location + 4, 1);
+
+        Vao::attrib(location + 5, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), base + offsetof(InstanceData, anim));
+        Vao::divisor(location + 5, 1);
+    }
+};
+
+// the rotation the ROTATE_X/Y/Z shader variants apply per vertex, X first then Y then Z
+inline glm::mat4 animRotation(float angle, bool x, bool y, bool z)
+{
+    glm::mat4 rot(1.0f);
+    if (z) {
+        rot = glm::rotate(rot, -angle, glm::vec3(0.0f, 0.0f, 1.0f));
+    }
+    if (y) {
+        rot = glm::rotate(rot, -angle, glm::vec3(0.0f, 1.0f, 0.0f));
+    }
+    if (x) {
+        rot = glm::rotate(rot, -angle, glm::vec3(1.0f, 0.0f, 0.0f));
+    }
+    return rot;
+}
+
+// compose the animation rotation into each instance matrix once per frame on the cpu
+inline void animateInstances(const std::vector<InstanceData>& in, std::vector<InstanceData>& out, float time, float speed, bool x, bool y, bool z, JobSystem* jobs = nullptr)
+{
+    out.resize(in.size());
+    parallelFor(jobs, 0, in.size(), 1024, [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; i++) {
+            const InstanceData& src = in[i];
+            out[i] = src;
+            if (src.anim.x > 0.5f) {
+                out[i].model = src.model * animRotation(time * speed * src.anim.z + src.anim.y, x, y, z);
+            }
+        }
+    });
+}
+
+// position of instance `i` on a square lattice in the XZ plane centered on the origin,
+// a single instance sits at the origin
+inline glm::vec3 latticeOffset(int i, int count, float spacing)
+{
+    if (count == 1) {
+        return glm::vec3(0.0f);
+    }
+
+    int side = (int)std::ceil(std::sqrt((float)count));
+    float half = (side - 1) * spacing * 0.5f;
+    return glm::vec3((i % side) * spacing - half, 0.0f, (i / side) * spacing - half);
+}
+
+// per-instance tint and animation parameters, the model matrices come from the scene graph.
+// instance 0 is the untinted original so a count of 1 matches the single object.
+inline void buildInstanceLattice(std::vector<InstanceData>& out, int count, bool animated)
+{
+    out.resize(count);
+
+    for (int i = 0; i < count; i++) {
+        // cheap integer hash for stable per-instance variation
+        uint32_t h = (uint32_t)i * 2654435761u;
+        float r0 = ((h >> 8) & 0xff) / 255.0f;
+        float r1 = ((h >> 16) & 0xff) / 255.0f;
+        float r2 = ((h >> 24) & 0xff) / 255.0f;
+
+        InstanceData& inst = out[i];
+        inst.tint = glm::vec4(0.5f + 0.5f * r0, 0.5f + 0.5f * r1, 0.5f + 0.5f * r2, 1.0f);
+        inst.anim = glm::vec4(animated ? 1.0f : 0.0f, i * 0.37f, 0.5f + r2, 0.0f);
+        if (i == 0) {
+            inst.tint = glm::vec4(1.0f);
+            inst.anim = glm::vec4(animated ? 1.0f : 0.0f, 0.0f, 1.0f, 0.0f);
+        }
+    }
+}
+
+#endif // INSTANCE_H
@@ -0,0 +1,246 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// counts the jobs spawned against it that have not finished. jobs spawned after a counter
+// are parked on it and released by whichever job brings it to zero.
+struct JobCounter {
+    std::atomic<int> pending { 0 };
+    std::mutex mutex;
+    std::vector<std::function<void()>> continuations;
+
+    bool done() const { return pending.load(std::memory_order_acquire) == 0; }
+};
+
+// fork/join job pool for the per-frame cpu work. every worker owns a deque, it pushes and pops
+// at the back so the jobs it spawned run while their data is still in cache, idle workers
+// steal from the front of the others. threads outside the pool share queue 0 and help run
+// jobs while they wait on a counter, so a pool without workers still completes everything.
+//
+// with `inlineJobs` set every job runs on the spawning thread before spawn() returns, in
+// submission order, the deterministic reference when a parallel run misbehaves.
+struct JobSystem {
+    struct Job {
+        std::function<void()> fn;
+        JobCounter* counter = nullptr;
+    };
+
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues; // 0 is shared by threads outside the pool
+    std::vector<std::thread> workers;
+    std::atomic<int> queued { 0 };
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    bool quit = false;
+
+    bool inlineJobs = false;
+
+    // queue of the calling thread, workers set theirs on start
+    static inline thread_local int threadQueue = 0;
+
+    ~JobSystem() { shutdown(); }
+
+    // `threadCount` < 0 leaves one hardware thread to the caller, 0 runs everything on the
+    // threads that wait
+    void init(int threadCount, bool runInline = false)
+    {
+        if (threadCount < 0) {
+            threadCount = std::max(0, (int)std::thread::hardware_concurrency() - 1);
+        }
+        inlineJobs = runInline;
+
+        queues.push_back(std::make_unique<Queue>());
+        for (int i = 0; i < threadCount && !inlineJobs; i++) {
+            queues.push_back(std::make_unique<Queue>());
+        }
+        for (int i = 1; i < (int)queues.size(); i++) {
+            workers.emplace_back([this, i] { run(i); });
+        }
+    }
+
+    void shutdown()
+    {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            quit = true;
+        }
+        wake.notify_all();
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+        workers.clear();
+    }
+
+    // threads that run jobs, the waiting caller included
+    int threadCount() const { return (int)workers.size() + 1; }
+
+    void spawn(std::function<void()> fn, JobCounter& counter)
+    {
+        counter.pending.fetch_add(1, std::memory_order_relaxed);
+        push({ std::move(fn), &counter });
+    }
+
+    // `fn` is queued once every job spawned against `dependency` so far has finished
+    void spawnAfter(JobCounter& dependency, std::function<void()> fn, JobCounter& counter)
+    {
+        counter.pending.fetch_add(1, std::memory_order_relaxed);
+        Job job { std::move(fn), &counter };
+        {
+            std::lock_guard<std::mutex> lock(dependency.mutex);
+            if (!dependency.done()) {
+                auto shared = std::make_shared<Job>(std::move(job));
+                dependency.continuations.push_back([this, shared] { push(std::move(*shared)); });
+                return;
+            }
+        }
+        push(std::move(job));
+    }
+
+    // runs queued jobs until the counter drops to zero
+    void wait(JobCounter& counter)
+    {
+        while (!counter.done()) {
+            Job job;
+            if (take(job)) {
+                execute(job);
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        // the job that finished it may still hold the lock, the counter can go away after this
+        std::lock_guard<std::mutex> lock(counter.mutex);
+    }
+
+    // fn(first, last) over [begin, end) split into chunks of at least `grain` items, returns
+    // once every chunk ran. the caller runs the first chunk itself.
+    template <typename F>
+    void parallelFor(size_t begin, size_t end, size_t grain, F&& fn)
+    {
+        size_t count = end > begin ? end - begin : 0;
+        grain = std::max<size_t>(grain, 1);
+        if (inlineJobs || workers.empty() || count <= grain) {
+            if (count > 0) {
+                fn(begin, end);
+            }
+            return;
+        }
+
+        // a few chunks per thread so a stolen or slow chunk does not hold up the rest
+        size_t chunk = std::max(grain, (count + threadCount() * 4 - 1) / (threadCount() * 4));
+        JobCounter counter;
+        for (size_t first = begin + chunk; first < end; first += chunk) {
+            size_t last = std::min(end, first + chunk);
+            spawn([&fn, first, last] { fn(first, last); }, counter);
+        }
+        fn(begin, std::min(end, begin + chunk));
+        wait(counter);
+    }
+
+    void push(Job job)
+    {
+        if (inlineJobs) {
+            execute(job);
+            return;
+        }
+
+        Queue& queue = *queues[threadQueue];
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.jobs.push_back(std::move(job));
+        }
+        queued.fetch_add(1, std::memory_order_release);
+        {
+            // a worker between its empty check and the wait cannot miss the notify
+            std::lock_guard<std::mutex> lock(sleepMutex);
+        }
+        wake.notify_one();
+    }
+
+    // newest job of the own queue, otherwise the oldest of another one
+    bool take(Job& job)
+    {
+        if (queued.load(std::memory_order_acquire) == 0) {
+            return false;
+        }
+
+        int own = threadQueue;
+        for (int i = 0; i < (int)queues.size(); i++) {
+            int index = (own + i) % (int)queues.size();
+            Queue& queue = *queues[index];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (queue.jobs.empty()) {
+                continue;
+            }
+            if (index == own) {
+                job = std::move(queue.jobs.back());
+                queue.jobs.pop_back();
+            } else {
+                job = std::move(queue.jobs.front());
+                queue.jobs.pop_front();
+            }
+            queued.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+        return false;
+    }
+
+    void execute(Job& job)
+    {
+        job.fn();
+
+        std::vector<std::function<void()>> released;
+        {
+            std::lock_guard<std::mutex> lock(job.counter->mutex);
+            if (job.counter->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                released.swap(job.counter->continuations);
+            }
+        }
+        for (auto& release : released) {
+            release();
+        }
+    }
+
+    void run(int index)
+    {
+        threadQueue = index;
+        while (true) {
+            Job job;
+            if (take(job)) {
+                execute(job);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            wake.wait(lock, [this] { return quit || queued.load(std::memory_order_acquire) > 0; });
+            if (quit) {
+                return;
+            }
+        }
+    }
+};
+
+// parallelFor on the pool, or inline without one
+template <typename F>
+inline void parallelFor(JobSystem* jobs, size_t begin, size_t end, size_t grain, F&& fn)
+{
+    if (jobs) {
+        jobs->parallelFor(begin, end, grain, fn);
+    } else if (end > begin) {
+        fn(begin, end);
+    }
+}
+
+#endif // JOB_SYSTEM_H
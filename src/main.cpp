@@ -1,21 +1,43 @@
+#include "asset_pack.h"
+#include "bench.h"
+#include "bvh.h"
+#include "dynamic_resolution.h"
+#include "file_watcher.h"
+#include "frame_uniforms.h"
+#include "frame_pacer.h"
+#include "frame_pipeline.h"
+#include "frame_capture.h"
+#include "framebuffer.h"
 #include "gl_buffer.h"
+#include "gl_stats.h"
+#include "gpu_culling.h"
+#include "grid.h"
 #include "gui.h"
-#include "shader.h"
+#include "input_log.h"
+#include "instance.h"
+#include "job_system.h"
+#include "mesh.h"
+#include "mesh_gen.h"
+#include "mesh_loader.h"
+#include "options.h"
+#include "profiler.h"
+#include "render_queue.h"
+#include "scene_graph.h"
+#include "shader_variants.h"
+#include "simulation.h"
 #include "timer.h"
 #include "vertex.h"
 #include "window.h"
+#include <chrono>
+#include <cfloat>
 #include <cstddef>
+#include <cstring>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+// middle mouse state, the camera pose itself belongs to the update stage
 struct CameraContext {
-    glm::vec3 pos;
-    glm::vec3 target;
-    glm::vec3 up;
-    float fov;
-    float zNear;
-    float zFar;
     double lastMouseX;
     double lastMouseY;
     bool middleMousePressed;
@@ -42,89 +64,201 @@ void drawMat4(const glm::mat4& m, ImVec2 startPos)
     }
 }
 
-int main()
+// helper function to edit the local transform of a scene graph node, the edit is sent with
+// the next update input. `id` keeps widget ids unique
+bool editNodeTransform(const NodeView& view, PendingEdit<NodeTransform>& pending, uint64_t applied, SimInput& input, const char* id)
 {
-    // initialize window
-    Window window;
-    if (!window.init("LearnOpenGL")) {
-        return EXIT_FAILURE;
+    char label[64];
+    bool changed = false;
+    NodeTransform& transform = pending.show(view.transform, applied, view.node);
+
+    snprintf(label, sizeof(label), "Translate##%s", id);
+    changed |= ImGui::DragFloat3(label, glm::value_ptr(transform.translation), 1.0f);
+    snprintf(label, sizeof(label), "Rotation##%s", id);
+    changed |= ImGui::DragFloat3(label, glm::value_ptr(transform.rotation), 1.0f);
+    snprintf(label, sizeof(label), "Scale##%s", id);
+    changed |= ImGui::DragFloat3(label, glm::value_ptr(transform.scale), 0.1f);
+
+    if (changed) {
+        input.edits.push_back({ view.node, transform });
+        pending.edited(input.sequence);
     }
+    return changed;
+}
+
+// text asset from the pack when one is open, otherwise from disk
+std::optional<std::string> readAsset(const AssetPack& pack, const std::string& path)
+{
+    auto text = pack.isOpen() ? pack.text(path) : File::readFile(path);
+    if (!text.has_value()) {
+        fprintf(stderr, "err: failed to read %s%s\n", path.c_str(), pack.isOpen() ? " from the asset pack" : "");
+    }
+    return text;
+}
+
+// everything that owns GL objects lives here, so it is released while the context is current
+int run(Options& opts, InputLog& inputLog, Window& window, std::chrono::steady_clock::time_point startupStart)
+{
+    const bool replaying = inputLog.mode == InputLog::Replaying;
 
     // set window resize callback
-    glfwSetWindowUserPointer(window.get(), &window);
-    glfwSetWindowSizeCallback(window.get(), Window::onResize);
+    if (window.get()) {
+        glfwSetWindowUserPointer(window.get(), &window);
+        glfwSetWindowSizeCallback(window.get(), Window::onResize);
+    }
+
+    // rebuilds compile off the render loop, on driver threads or a shared-context worker
+    ShaderCompiler shaderCompiler;
+    shaderCompiler.init(window.createSharedContext());
+    Shader::compiler = &shaderCompiler;
 
-    // initialize shader
-    Shader shader;
-    if (!shader.init("shaders/vertex.glsl", "shaders/fragment.glsl")) {
+    // cooked shaders and meshes, mapped for the lifetime of the program
+    AssetPack pack;
+    if (!opts.pack.empty() && !pack.open(opts.pack)) {
         return EXIT_FAILURE;
     }
 
+    // draws are sorted and issued through a cache that filters redundant state changes
+    GlStateCache glState;
+    RenderQueue renderQueue;
+    Shader::state = &glState;
+
+    // linked programs are cached on disk, shader setup time shows the cold/warm difference
+    ProgramCache programCache;
+    if (!opts.shaderCache.empty() && programCache.init(opts.shaderCache)) {
+        Shader::cache = &programCache;
+    }
+    auto shaderStart = std::chrono::steady_clock::now();
+
+    // load shader sources, programs are compiled per feature set on first use
+    ShaderVariants shaders;
+    auto vertSource = readAsset(pack, "shaders/vertex.glsl");
+    auto fragSource = readAsset(pack, "shaders/fragment.glsl");
+    if (!vertSource || !fragSource) {
+        return EXIT_FAILURE;
+    }
+    shaders.initFromSource(vertSource.value(), fragSource.value());
+
+    // bind the per-frame uniform block, per-object data comes from instance attributes
+    shaders.bindBlock("Frame", FrameUniforms::binding, sizeof(FrameUniforms));
+
+    // make sure the default variants build before entering the main loop
+    if (!shaders.get(ShaderFeatureTint) || !shaders.get(0)) {
+        return EXIT_FAILURE;
+    }
+    double shaderSetupMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - shaderStart).count();
+
+    // per-frame uniform buffer, written once per frame into a fenced ring and shared by every program
+    GLint uboAlignment = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uboAlignment);
+
+    FrameUniforms frameUniforms {};
+    StreamBuffer frameUbo(GL_UNIFORM_BUFFER, "frame uniforms");
+    frameUbo.init((sizeof(FrameUniforms) + uboAlignment - 1) / uboAlignment * uboAlignment);
+
     // initialize gui
     Gui gui;
-    if (!gui.init(window.get(), "#version 330 core")) {
+    if (opts.bench ? !gui.initHeadless(opts.width, opts.height, "#version 330 core") : !gui.init(window.get(), "#version 330 core")) {
+        return EXIT_FAILURE;
+    }
+
+    // bench mode renders into an offscreen framebuffer
+    Fbo benchFbo;
+    if (opts.bench && !benchFbo.init(opts.width, opts.height, "bench target")) {
         return EXIT_FAILURE;
     }
+    BenchStats benchStats;
+    int frameIndex = 0;
+
+    // screenshots and frame sequences, read back through fenced pixel buffers and encoded on a
+    // worker thread
+    FrameCapture frameCapture;
+    frameCapture.init();
+    bool captureUi = false;
+    int captureFormat = opts.captureFormat;
+    char captureDir[256];
+    snprintf(captureDir, sizeof(captureDir), "%s", opts.capture.empty() ? "capture" : opts.capture.c_str());
+    int screenshotCount = 0;
+
+    // reads the framebuffer drawn this frame, the default one or the bench target
+    auto captureFrame = [&]() {
+        frameCapture.capture(opts.bench ? benchFbo.width : window.m_width, opts.bench ? benchFbo.height : window.m_height);
+        frameCapture.poll();
+    };
+
+    // cpu scopes and gpu timer queries for the profiler panel and chrome traces
+    Profiler profiler;
+
+    // startup generation and the per-object loops of the update stage are split across a
+    // work-stealing pool
+    JobSystem jobs;
+    jobs.init(opts.jobs, opts.jobsInline);
 
     // create timer
     Timer timer;
     timer.reset();
 
+    // every static mesh lives in the shared buffers of its vertex format and is drawn from
+    // that format's vao, declared before the meshes so it outlives them
+    MeshPools meshPools;
+    meshPools.init();
+
     // --- Grid Begin ---
     std::vector<Vertex> gridVertices;
     std::vector<GLuint> gridIndices;
 
-    const int gridSize = 20;
-    const float gridSpacing = 20.0f;
+    const int gridSize = opts.gridSize;
+    const float gridSpacing = opts.gridSpacing;
     glm::vec4 gridColor(0.7f, 0.7f, 0.7f, 1.0f);
 
-    // generate vertices for grid lines on XZ plane at y=0
-    for (int i = -gridSize; i <= gridSize; ++i) {
-        // lines parallel to Z-axis
-        gridVertices.push_back(Vertex(glm::vec3(i * gridSpacing, 0.0f, -gridSize * gridSpacing), gridColor));
-        gridVertices.push_back(Vertex(glm::vec3(i * gridSpacing, 0.0f, gridSize * gridSpacing), gridColor));
-
-        // lines parallel to X-axis
-        gridVertices.push_back(Vertex(glm::vec3(-gridSize * gridSpacing, 0.0f, i * gridSpacing), gridColor));
-        gridVertices.push_back(Vertex(glm::vec3(gridSize * gridSpacing, 0.0f, i * gridSpacing), gridColor));
-    }
+    // reference line geometry, grows with the grid extent. built the first time lines mode is
+    // drawn, the procedural grid needs none of it
+    Mesh gridMesh;
+    auto buildGridLines = [&]() {
+        generateGridLines(gridVertices, gridIndices, gridSize, gridSpacing, gridColor, &jobs);
+        gridMesh.build(meshPools, gridVertices, gridIndices, VertexFormatFloat, GL_LINES);
+        if (!gridMesh.valid()) {
+            fprintf(stderr, "err: failed to upload the grid lines\n");
+        }
+    };
 
-    // indices are sequential since each pair of vertices form a line
-    for (GLuint i = 0; i < gridVertices.size(); i += 2) {
-        gridIndices.push_back(i);
-        gridIndices.push_back(i + 1);
+    // the grid is drawn as a single instance
+    InstanceData gridInstance;
+    DirtyBuffer gridInstanceVbo(GL_ARRAY_BUFFER, "grid instance");
+    gridInstanceVbo.bind();
+    gridInstanceVbo.fill(sizeof(InstanceData), &gridInstance, GL_DYNAMIC_DRAW);
+    gridInstanceVbo.unbind();
+
+    // procedural grid, constant cost at any extent
+    int gridMode = opts.gridMode;
+    float gridFade = gridSize * gridSpacing;
+    ProceduralGrid proceduralGrid;
+    shaderStart = std::chrono::steady_clock::now();
+    auto gridVertSource = readAsset(pack, "shaders/grid_vertex.glsl");
+    auto gridFragSource = readAsset(pack, "shaders/grid_fragment.glsl");
+    if (!gridVertSource || !gridFragSource || !proceduralGrid.init(gridVertSource.value(), gridFragSource.value())) {
+        return EXIT_FAILURE;
     }
-
-    // generate grid buffer objects
-    Vao gridVao;
-    Vbo gridVbo;
-    Ebo gridEbo;
-
-    // bind grid buffer objects
-    gridVao.bind();
-    gridVbo.bind();
-    gridEbo.bind();
-
-    // fill grid vertex buffer object and element buffer object with data
-    gridVbo.fill(gridVertices.size() * sizeof(Vertex), gridVertices.data(), GL_STATIC_DRAW);
-    gridEbo.fill(gridIndices.size() * sizeof(GLuint), gridIndices.data(), GL_STATIC_DRAW);
-
-    // configure grid vertex attaributes
-    gridVao.attrib(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), 0);
-    gridVao.attrib(1, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), offsetof(Vertex, color));
-
-    // unbind grid buffer objects
-    gridVao.unbind();
-    gridVbo.unbind();
-    gridEbo.unbind();
-
-    // pyramid transform variables
-    glm::vec3 gridTranslate = glm::vec3(0.0f, 0.0f, 0.0f);
-    glm::vec3 gridRotation = glm::vec3(0.0f, 0.0f, 0.0f);
-    glm::vec3 gridScale = glm::vec3(1.0f, 1.0f, 1.0f);
+    shaderSetupMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - shaderStart).count();
 
     // --- Grid End ---
 
+    // scene drawn below native resolution while frames run over budget, stretched to the output
+    // before the ui is drawn on top
+    DynamicResolution dynamicRes;
+    dynamicRes.enabled = opts.dynamicRes;
+    dynamicRes.budgetMs = opts.frameBudget;
+    dynamicRes.minScale = opts.minScale;
+    dynamicRes.filter = (UpscaleFilter)opts.upscale;
+    shaderStart = std::chrono::steady_clock::now();
+    auto upscaleVertSource = readAsset(pack, "shaders/upscale_vertex.glsl");
+    auto upscaleFragSource = readAsset(pack, "shaders/upscale_fragment.glsl");
+    if (!upscaleVertSource || !upscaleFragSource || !dynamicRes.init(upscaleVertSource.value(), upscaleFragSource.value())) {
+        fprintf(stderr, "warn: upscale shader unavailable, dynamic resolution uses the bilinear blit\n");
+        dynamicRes.filter = UpscaleBilinear;
+    }
+    shaderSetupMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - shaderStart).count();
+
     // --- Pyramid Begin ---
 
     // pyramid vertices data
@@ -151,100 +285,269 @@ int main()
     };
     // clang-format on
 
-    // generate buffer objects
-    Vao pyVao;
-    Vbo pyVbo;
-    Ebo pyEbo;
+    // shares the grid's buffers, color edits write the edited vertex in place
+    Mesh pyMesh;
+    pyMesh.build(meshPools, pyVertices, pyIndices, VertexFormatFloat);
 
-    // bind pyramid buffer objects
-    pyVao.bind();
-    pyVbo.bind();
-    pyEbo.bind();
+    // per-instance pyramid data, written from the changes each snapshot carries
+    DirtyBuffer pyInstanceVbo(GL_ARRAY_BUFFER, "pyramid instances");
+    pyInstanceVbo.bind();
+    pyInstanceVbo.fill(sizeof(InstanceData), nullptr, GL_DYNAMIC_DRAW);
+    pyInstanceVbo.unbind();
 
-    // fill pyramid vertex buffer object
-    pyVbo.fill(pyVertices.size() * sizeof(Vertex), pyVertices.data(), GL_DYNAMIC_DRAW);
+    // per-frame visible and animated copies of the instances, streamed through a fenced ring
+    StreamBuffer pyInstanceStream(GL_ARRAY_BUFFER, "pyramid instance stream");
+    pyInstanceStream.init(64 * sizeof(InstanceData));
 
-    // fill pyramid element buffer object
-    pyEbo.fill(pyIndices.size() * sizeof(GLuint), pyIndices.data(), GL_DYNAMIC_DRAW);
+    // --- Pyramid End ---
 
-    // configure pyramid vertex attaributes
-    pyVao.attrib(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), 0);
-    pyVao.attrib(1, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), offsetof(Vertex, color));
+    // --- Dense Mesh Begin ---
+
+    // vertex-heavy test scene, replaces the pyramid mesh to compare shader throughput.
+    // --mesh picks a cooked mesh from the pack or parses a mesh file instead of the sphere.
+    std::vector<Vertex> denseVertices;
+    std::vector<GLuint> denseIndices;
+    Aabb denseBounds;
+
+    // stored in a selectable compact vertex format to compare fetch bandwidth
+    int denseFormat = opts.vertexFormat;
+    Mesh denseMesh;
+
+    // coarser spheres drawn at a distance by the gpu culling path, in the dense mesh's pool and
+    // with its index type so one multi draw covers every lod
+    std::vector<Vertex> lodVertices[2];
+    std::vector<GLuint> lodIndices[2];
+    Mesh denseLods[2];
+    auto buildDense = [&](VertexFormat format) {
+        // the gpu culled multi draw sets one position range for the mesh and its lods
+        PositionQuantization shared = PositionQuantization::fromBounds({ &denseVertices, &lodVertices[0], &lodVertices[1] });
+        denseMesh.build(meshPools, denseVertices, denseIndices, format, GL_TRIANGLES, 0, &shared);
+        for (int i = 0; i < 2 && !lodVertices[i].empty(); i++) {
+            denseLods[i].build(meshPools, lodVertices[i], lodIndices[i], format, GL_TRIANGLES, denseVertices.size(), &shared);
+        }
+    };
 
-    // unbind pyramid buffer objects
-    pyVao.unbind();
-    pyVbo.unbind();
-    pyEbo.unbind();
+    auto meshLoadStart = std::chrono::steady_clock::now();
+    const PackMesh* packedMesh = opts.mesh.empty() ? nullptr : pack.mesh(opts.mesh);
+    if (packedMesh) {
+        // cooked meshes are float only, the compact formats need the source vertices
+        if (denseFormat != VertexFormatFloat) {
+            fprintf(stderr, "warn: cooked meshes are stored as float, ignoring --vertex-format\n");
+            denseFormat = VertexFormatFloat;
+        }
+        denseMesh.build(meshPools, *packedMesh);
+        denseBounds = { glm::make_vec3(packedMesh->boundsMin), glm::make_vec3(packedMesh->boundsMax) };
+    } else {
+        if (opts.mesh.empty()) {
+            // the sphere and its lods are generated side by side, each split by rings, the
+            // bounds follow once the dense one is done
+            JobCounter dense, generated;
+            jobs.spawn([&] { generateSphere(denseVertices, denseIndices, 100.0f, 256, 256, &jobs); }, dense);
+            jobs.spawn([&] { generateSphere(lodVertices[0], lodIndices[0], 100.0f, 64, 64, &jobs); }, generated);
+            jobs.spawn([&] { generateSphere(lodVertices[1], lodIndices[1], 100.0f, 16, 16, &jobs); }, generated);
+            jobs.spawnAfter(dense, [&] { denseBounds = Aabb::fromVertices(denseVertices); }, generated);
+            jobs.wait(generated);
+        } else if (!MeshLoader::load(opts.mesh, denseVertices, denseIndices)) {
+            return EXIT_FAILURE;
+        } else {
+            denseBounds = Aabb::fromVertices(denseVertices);
+        }
+        buildDense((VertexFormat)denseFormat);
+    }
+    double meshLoadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - meshLoadStart).count();
+    if (!pyMesh.valid() || !denseMesh.valid()) {
+        return EXIT_FAILURE;
+    }
 
-    // pyramid transform variables
-    glm::vec3 pyTranslate = glm::vec3(0.0f, 0.0f, 0.0f);
-    glm::vec3 pyRotation = glm::vec3(0.0f, 0.0f, 0.0f);
-    glm::vec3 pyScale = glm::vec3(1.0f, 1.0f, 1.0f);
+    // --- Dense Mesh End ---
 
-    // --- Pyramid End ---
+    // scene controls, the ui edits these and every update input carries a copy
+    SimSettings settings;
+    settings.instanceCount = opts.objects ? opts.objects : (opts.bench ? 1000 : 1);
+    settings.frustumCull = !opts.noCull;
+    settings.denseScene = opts.dense || !opts.mesh.empty();
+    settings.simdLevel = MathKernels::level;
 
-    // camera stuff
-    CameraContext camera;
+    // reference path: rotate every vertex in the shader instead of composing per instance on the cpu
+    settings.gpuAnim = opts.gpuAnim;
 
-    camera.pos = glm::vec3(1000.0f, 500.0f, 500.0f);
-    camera.target = glm::vec3(0.0f, 0.0f, 0.0f);
-    camera.up = glm::vec3(0.0f, 1.0f, 0.0f);
-    camera.fov = 45.0f;
-    camera.zNear = 0.1f;
-    camera.zFar = 5000.0f;
+    // gpu-driven path for 4.3 contexts, the cpu bvh path stays the fallback
+    GpuCulling gpuCulling;
+    bool gpuCullReady = false;
+    if (GpuCulling::supported()) {
+        auto cullSource = readAsset(pack, "shaders/cull_compute.glsl");
+        gpuCullReady = cullSource && gpuCulling.init(cullSource.value());
+    }
+    if (opts.gpuCull && !gpuCullReady) {
+        fprintf(stderr, "warn: gpu culling unavailable on GL %s, using the cpu path\n", (const char*)glGetString(GL_VERSION));
+    }
+    settings.gpuCull = opts.gpuCull && gpuCullReady;
+    float lodDistance = opts.lodDistance;
+
+    // the bench script animates every pyramid around Y
+    if (opts.bench && !opts.idle && !replaying) {
+        settings.pyAnim = true;
+        settings.rotateAnimY = true;
+    }
+
+    // transforms, instances, culling and cpu animation run on the update thread one frame ahead
+    // of rendering. world matrices are only recomputed below edited scene graph nodes.
+    Simulation sim;
+    sim.init(Aabb::fromVertices(pyVertices), denseBounds);
+    sim.jobs = &jobs;
+    sim.introAnim = !opts.bench || replaying;
+    sim.orbitFrames = opts.bench && !opts.idle && !replaying ? opts.warmup + opts.frames : 0;
+
+    FramePipeline<SimInput, FrameSnapshot> pipeline;
+    pipeline.init([&sim](const SimInput& in, FrameSnapshot& out) { sim.update(in, out); }, !opts.serialUpdate);
+
+    SimInput simInput;
+    simInput.sequence = 1;
+
+    // camera input and ui copies of state owned by the update stage
+    CameraContext camera {};
+    PendingEdit<CameraPose> cameraEdit;
+    PendingEdit<NodeTransform> pyEdit, gridEdit, nodeEdit;
+    int sceneSelected = (int)sim.pyNode;
+
+    // widget values as the input log stores them
+    auto uiState = [&]() {
+        UiState ui;
+        ui.settings = settings;
+        ui.selected = sceneSelected;
+        ui.gridMode = gridMode;
+        ui.gridFade = gridFade;
+        ui.lodDistance = lodDistance;
+        ui.denseFormat = denseFormat;
+        return ui;
+    };
+    auto applyUiState = [&](const UiState& ui) {
+        settings = ui.settings;
+        settings.gpuCull = ui.settings.gpuCull && gpuCullReady;
+        sceneSelected = ui.selected;
+        gridMode = ui.gridMode;
+        gridFade = ui.gridFade;
+        lodDistance = ui.lodDistance;
+        if (ui.denseFormat != denseFormat && !packedMesh) {
+            denseFormat = ui.denseFormat;
+            buildDense((VertexFormat)denseFormat);
+        }
+    };
 
-    // animation controls
-    bool pyAnim = false;
-    bool gridAnim = false;
-    bool rotateAnimX = false;
-    bool rotateAnimY = false;
-    bool rotateAnimZ = false;
-    float animSpeed = 1.0f;
+    if (replaying) {
+        applyUiState(inputLog.initial);
+        printf("replay: %d frames from %s\n", (int)inputLog.frames.size(), inputLog.path.c_str());
+    } else if (!opts.record.empty()) {
+        if (!inputLog.record(opts.record, window.m_width, window.m_height, uiState())) {
+            return EXIT_FAILURE;
+        }
+        printf("input: recording to %s\n", opts.record.c_str());
+    }
 
     // enable depth test
     glEnable(GL_DEPTH_TEST);
 
-    bool initCamAnim = true;
-
     // main loop
-    while (!window.shouldClose()) {
-        // create model matrix for pyramid
-        glm::mat4 modelPyramid(1.0f);
-        modelPyramid = glm::translate(modelPyramid, pyTranslate);
-        modelPyramid = glm::rotate(modelPyramid, glm::radians(pyRotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
-        modelPyramid = glm::rotate(modelPyramid, glm::radians(pyRotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
-        modelPyramid = glm::rotate(modelPyramid, glm::radians(pyRotation.z), glm::vec3(1.0f, 0.0f, 1.0f));
-        modelPyramid = glm::scale(modelPyramid, pyScale);
-
-        // create model matrix for grid
-        glm::mat4 modelGrid(1.0f);
-        modelGrid = glm::translate(modelGrid, gridTranslate);
-        modelGrid = glm::rotate(modelGrid, glm::radians(gridRotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
-        modelGrid = glm::rotate(modelGrid, glm::radians(gridRotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
-        modelGrid = glm::rotate(modelGrid, glm::radians(gridRotation.z), glm::vec3(1.0f, 0.0f, 1.0f));
-        modelGrid = glm::scale(modelGrid, gridScale);
-
-        // create the view matrix every frame
-        glm::mat4 view = glm::lookAt(camera.pos, camera.target, camera.up);
-
-        // create projection matrix
-        glm::mat4 projection = glm::perspective(
-            glm::radians(camera.fov),
-            window.m_width / (float)window.m_height,
-            camera.zNear,
-            camera.zFar);
-
-        // handle window events
-        window.pollEvents();
+    // time from launch until the first frame starts
+    double startupMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startupStart).count();
+    printf("startup: %.1f ms (dense mesh %.1f ms%s)\n", startupMs, meshLoadMs, packedMesh ? ", mapped from pack" : "");
+    if (programCache.enabled) {
+        printf("shaders: %.1f ms (binary cache: %d hits, %d misses, %d rejected)\n", shaderSetupMs, programCache.hits, programCache.misses, programCache.rejected);
+    } else {
+        printf("shaders: %.1f ms (binary cache off)\n", shaderSetupMs);
+    }
+
+    printf("shader compiler: %s\n", ShaderCompiler::modeNames[shaderCompiler.mode]);
+    printf("scene update: %s\n", pipeline.threaded ? "threaded" : "serial");
+    printf("jobs: %d threads%s\n", jobs.threadCount(), jobs.inlineJobs ? ", inline" : "");
+    printf("culling: %s\n", settings.gpuCull ? "gpu compute, multi draw indirect" : "cpu bvh");
+    if (dynamicRes.enabled) {
+        printf("dynamic resolution: %.1f ms budget, scale %.2f to 1, %s upscale\n", dynamicRes.budgetMs, dynamicRes.minScale, upscaleFilterNames[dynamicRes.filter]);
+    }
+
+    // rebuild shaders edited on disk, sources cooked into a pack are not watched
+    FileWatcher shaderWatcher;
+    bool hotReload = !pack.isOpen() && shaderWatcher.open("shaders");
+
+    // when frames start. bench runs get synthetic input to measure input-to-present latency,
+    // there is no event source without a window.
+    FramePacer pacer;
+    pacer.targetFps = opts.fps;
+    pacer.setMode(opts.pacing >= 0 ? (PacingMode)opts.pacing : (opts.bench ? PacingUnlimited : PacingVsync), window);
+    if (opts.bench) {
+        pacer.syntheticRate = opts.inputRate;
+        pacer.nextSynthetic = pacer.now();
+    }
+    int pacingMode = pacer.mode;
+    printf("pacing: %s\n", pacingModeNames[pacer.mode]);
+
+    // inputs waiting for the snapshot that includes them to be presented
+    std::vector<std::pair<uint64_t, double>> inputsInFlight;
+    double latencyMs = 0.0;
+    bool sceneAnimating = true;
+
+    const int benchFrames = opts.warmup + opts.frames;
+    while (!window.shouldClose() && !(opts.bench && frameIndex >= benchFrames)) {
+        if (opts.bench && frameIndex == opts.warmup) {
+            benchStats.startClock(pacer.now());
+        }
+
+        // handle window events, glfw only allows this on the main thread. on demand, this blocks
+        // until something can have changed and frames with nothing new are skipped.
+        bool animating = sceneAnimating || ((settings.pyAnim || settings.gridAnim) && settings.anyAxis())
+            || !shaders.pending.empty() || proceduralGrid.next.pending();
+        pacer.wait(window, animating);
+
+        std::vector<std::string> shaderChanges;
+        if (hotReload) {
+            shaderChanges = shaderWatcher.poll();
+            if (!shaderChanges.empty()) {
+                pacer.requestRedraw();
+            }
+        }
+
+        if (!pacer.shouldDraw(animating)) {
+            continue;
+        }
+
+        auto frameStart = std::chrono::steady_clock::now();
+        profiler.beginFrame();
+
+        if (opts.bench && !opts.trace.empty() && frameIndex == opts.warmup) {
+            profiler.startCapture(opts.trace, opts.frames);
+        }
+
+        if (opts.bench && !opts.capture.empty() && frameIndex == opts.warmup) {
+            frameCapture.startSequence(opts.capture, (CaptureFormat)opts.captureFormat);
+        }
+        if (opts.bench && !opts.screenshot.empty() && frameIndex == benchFrames - 1) {
+            frameCapture.screenshot(opts.screenshot);
+        }
 
         // ____________ CAMERA MOVEMENT WITH MIDDLE MOUSE ____________
         // I still don't know how to orbit the camera around a target, for now this is enough for me
         // get current mouse position
-        double xpos, ypos;
-        glfwGetCursorPos(window.m_handle, &xpos, &ypos);
-
-        // get middle mouse button state
-        int middleState = glfwGetMouseButton(window.m_handle, GLFW_MOUSE_BUTTON_MIDDLE);
+        double xpos = 0.0, ypos = 0.0;
+        int middleState = GLFW_RELEASE;
+        if (replaying) {
+            const InputFrame& logged = inputLog.frames[frameIndex];
+            xpos = logged.cursorX;
+            ypos = logged.cursorY;
+            middleState = logged.buttons & (1 << GLFW_MOUSE_BUTTON_MIDDLE) ? GLFW_PRESS : GLFW_RELEASE;
+        } else if (window.get()) {
+            glfwGetCursorPos(window.m_handle, &xpos, &ypos);
+
+            // get middle mouse button state
+            middleState = glfwGetMouseButton(window.m_handle, GLFW_MOUSE_BUTTON_MIDDLE);
+
+            if (inputLog.mode == InputLog::Recording) {
+                uint8_t buttons = 0;
+                for (int b = GLFW_MOUSE_BUTTON_LEFT; b <= GLFW_MOUSE_BUTTON_MIDDLE; b++) {
+                    buttons |= glfwGetMouseButton(window.m_handle, b) == GLFW_PRESS ? 1 << b : 0;
+                }
+                inputLog.setCursor(xpos, ypos, buttons);
+            }
+        }
 
         if (middleState == GLFW_PRESS) {
             if (!camera.middleMousePressed) {
@@ -259,8 +562,9 @@ int main()
                 // camera movement sensitivity
                 float sensitivity = 5.0f;
 
-                camera.pos.x += static_cast<float>(-deltaX * sensitivity);
-                camera.pos.y += static_cast<float>(deltaY * sensitivity);
+                // applied to the camera by the next update
+                simInput.pan.x += static_cast<float>(-deltaX * sensitivity);
+                simInput.pan.y += static_cast<float>(deltaY * sensitivity);
 
                 // update camera last mouse pos
                 camera.lastMouseX = xpos;
@@ -270,156 +574,755 @@ int main()
             camera.middleMousePressed = false;
         }
 
-        // clear color buffer and depth buffer every frame before rendering
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        // hand this frame's input to the update stage and take the snapshot to draw. threaded,
+        // the update runs while this thread renders the previous snapshot.
+        profiler.push("Update");
+        simInput.frame = frameIndex;
+        // logged runs step a fixed clock so a replay animates exactly like the recording
+        if (inputLog.mode != InputLog::Off) {
+            simInput.time = frameIndex * inputLog.timestep;
+        } else {
+            simInput.time = opts.bench ? frameIndex / 60.0f : (float)glfwGetTime();
+        }
+        simInput.aspect = window.m_width / (float)window.m_height;
+        simInput.settings = settings;
+        simInput.selected = (SceneNode)sceneSelected;
+
+        const FrameSnapshot& snap = pipeline.step(simInput);
+        const SimSettings& drawn = snap.settings;
+        sceneAnimating = snap.cameraAnimating;
+
+        for (double arrival : pacer.arrivals) {
+            inputsInFlight.push_back({ simInput.sequence, arrival });
+        }
 
-        // update pyramid vertices
-        pyVbo.bind();
-        pyVbo.fill(pyVertices.size() * sizeof(Vertex), pyVertices.data(), GL_DYNAMIC_DRAW);
-        pyVbo.unbind();
+        // the ui fills the next input
+        simInput.sequence++;
+        simInput.setCamera = false;
+        simInput.pan = glm::vec2(0.0f);
+        simInput.edits.clear();
+        profiler.pop();
+
+        // start rebuilds for edited shader files and swap in the ones that finished linking
+        profiler.push("Shader Reload");
+        if (hotReload) {
+            bool variantsChanged = false, gridChanged = false;
+            for (const std::string& name : shaderChanges) {
+                variantsChanged |= name == "vertex.glsl" || name == "fragment.glsl";
+                gridChanged |= name == "grid_vertex.glsl" || name == "grid_fragment.glsl";
+            }
 
-        // use shader program
-        glUseProgram(shader.program);
+            if (variantsChanged) {
+                auto vert = File::readFile("shaders/vertex.glsl");
+                auto frag = File::readFile("shaders/fragment.glsl");
+                if (vert && frag) {
+                    printf("shaders: reloading %d variants\n", (int)shaders.variants.size());
+                    shaders.reload(vert.value(), frag.value());
+                }
+            }
 
-        // uMVP
-        GLint mvpLoc = glGetUniformLocation(shader.program, "uMVP");
+            if (gridChanged) {
+                auto vert = File::readFile("shaders/grid_vertex.glsl");
+                auto frag = File::readFile("shaders/grid_fragment.glsl");
+                if (vert && frag) {
+                    printf("shaders: reloading grid\n");
+                    proceduralGrid.reload(vert.value(), frag.value());
+                }
+            }
+        }
 
-        // uTime
-        GLint timeLoc = glGetUniformLocation(shader.program, "uTime");
-        glUniform1f(timeLoc, glfwGetTime());
+        size_t building = shaders.pending.size();
+        shaders.poll();
+        if (building > shaders.pending.size()) {
+            printf("shaders: %d variant builds finished, last 0x%x in %.2f ms\n", (int)(building - shaders.pending.size()), shaders.lastBuildFeatures, shaders.lastBuildMs);
+        }
+        if (proceduralGrid.poll()) {
+            printf("shaders: grid built in %.2f ms\n", proceduralGrid.shader.buildMs);
+        }
+        profiler.pop();
 
-        // uObjectID
-        GLint objectIDLoc = glGetUniformLocation(shader.program, "uObjectID");
+        if (opts.bench) {
+            benchFbo.bind();
+        }
 
-        // animation booleans
-        GLint pyAnimLoc = glGetUniformLocation(shader.program, "uPyAnim");
+        // the scene goes into the scaled target, the ui and captures use the output
+        GLuint outputFbo = opts.bench ? benchFbo.id : 0;
+        bool scaled = dynamicRes.begin(opts.bench ? benchFbo.width : window.m_width, opts.bench ? benchFbo.height : window.m_height);
 
-        GLint gridAnimLoc = glGetUniformLocation(shader.program, "uGridAnim");
+        // clear color buffer and depth buffer every frame before rendering
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        // uAnimSpeed
-        GLint animSpeedLoc = glGetUniformLocation(shader.program, "uAnimSpeed");
-        glUniform1f(animSpeedLoc, animSpeed);
+        // cpu cost of getting this frame's draws to the driver, for comparing the culling paths
+        auto submitStart = std::chrono::steady_clock::now();
+        profiler.push("Buffer Upload");
+
+        // upload shared per-frame state in one go
+        frameUniforms.view = snap.view;
+        frameUniforms.projection = snap.projection;
+        frameUniforms.viewProjection = snap.viewProjection;
+        frameUniforms.rotateAnimX = drawn.rotateAnimX;
+        frameUniforms.rotateAnimY = drawn.rotateAnimY;
+        frameUniforms.rotateAnimZ = drawn.rotateAnimZ;
+        frameUniforms.time = snap.time;
+        frameUniforms.animSpeed = drawn.animSpeed;
+
+        frameUbo.bind();
+        // a failed write leaves nothing to bind, the frame's draws are dropped below
+        GLintptr frameOffset = frameUbo.write(&frameUniforms, sizeof(FrameUniforms), uboAlignment);
+        if (frameOffset >= 0) {
+            frameUbo.bindRange(FrameUniforms::binding, frameOffset, sizeof(FrameUniforms));
+        }
+        frameUbo.unbind();
+
+        // the static instance copy takes every instance after a rebuild, otherwise only the
+        // instances whose nodes the update touched
+        if (snap.instancesRebuilt || !snap.changed.empty()) {
+            pyInstanceVbo.bind();
+            if (pyInstanceVbo.shadow.size() != snap.instanceCount * sizeof(InstanceData)) {
+                pyInstanceVbo.fill(snap.instanceCount * sizeof(InstanceData), snap.changedData.data(), GL_DYNAMIC_DRAW);
+            } else if (snap.instancesRebuilt) {
+                pyInstanceVbo.write(0, snap.changedData.data(), snap.instanceCount * sizeof(InstanceData));
+                pyInstanceVbo.flush();
+            } else {
+                for (size_t c = 0; c < snap.changed.size(); c++) {
+                    pyInstanceVbo.write(snap.changed[c] * sizeof(InstanceData), &snap.changedData[c], sizeof(InstanceData));
+                }
+                pyInstanceVbo.flush();
+            }
+            pyInstanceVbo.unbind();
+        }
 
-        // rotation toggles
-        GLint rotateAnimXLoc = glGetUniformLocation(shader.program, "uRotateAnimX");
-        GLint rotateAnimYLoc = glGetUniformLocation(shader.program, "uRotateAnimY");
-        GLint rotateAnimZLoc = glGetUniformLocation(shader.program, "uRotateAnimZ");
+        GLsizei pyDrawCount = (GLsizei)snap.drawCount;
 
-        // update the anim control variables in the vertex shader
-        glUniform1i(rotateAnimXLoc, rotateAnimX);
-        glUniform1i(rotateAnimYLoc, rotateAnimY);
-        glUniform1i(rotateAnimZLoc, rotateAnimZ);
+        // pick shader variants, rotation is either compiled into the shader or composed on the cpu
+        uint32_t animFeatures = 0;
+        if (drawn.gpuAnim) {
+            animFeatures |= drawn.rotateAnimX ? ShaderFeatureRotateX : 0u;
+            animFeatures |= drawn.rotateAnimY ? ShaderFeatureRotateY : 0u;
+            animFeatures |= drawn.rotateAnimZ ? ShaderFeatureRotateZ : 0u;
+        }
 
-        // ____________ PYRAMID ____________
-        glUniform1i(objectIDLoc, 0);
-        glUniform1i(pyAnimLoc, pyAnim);
+        uint32_t pyFeatures = animFeatures | ShaderFeatureTint;
+        if (drawn.denseScene && denseMesh.quantized()) {
+            pyFeatures |= ShaderFeatureQuantized;
+        }
 
-        // compute mvp for pyramid
-        // upload the pyramid mvp matrix before rendering
-        glm::mat4 pyMVP = projection * view * modelPyramid;
-        glUniformMatrix4fv(mvpLoc, 1, GL_FALSE, glm::value_ptr(pyMVP));
+        // variants not built yet are skipped until they link instead of stalling the frame
+        const ShaderVariant* pyShader = shaders.acquire(pyFeatures);
+        const ShaderVariant* gridShader = shaders.acquire(animFeatures);
+
+        // the mesh drawn for every pyramid instance
+        const Mesh& pyDrawMesh = drawn.denseScene ? denseMesh : pyMesh;
+
+        // gpu culling reads the static instance copy and bounds kept in sync from the same deltas
+        if (drawn.gpuCull) {
+            if (snap.boundsRebuilt || !snap.changedBounds.empty()) {
+                gpuCulling.bounds.bind();
+                if (gpuCulling.bounds.shadow.size() != snap.instanceCount * sizeof(Aabb)) {
+                    gpuCulling.bounds.fill(snap.instanceCount * sizeof(Aabb), snap.changedBounds.data(), GL_DYNAMIC_DRAW);
+                } else if (snap.boundsRebuilt) {
+                    gpuCulling.bounds.write(0, snap.changedBounds.data(), snap.instanceCount * sizeof(Aabb));
+                    gpuCulling.bounds.flush();
+                } else {
+                    for (size_t c = 0; c < snap.changed.size(); c++) {
+                        gpuCulling.bounds.write(snap.changed[c] * sizeof(Aabb), &snap.changedBounds[c], sizeof(Aabb));
+                    }
+                    gpuCulling.bounds.flush();
+                }
+                gpuCulling.bounds.unbind();
+            }
 
-        // render pyramid
-        pyVao.bind();
-        pyEbo.bind();
-        glDrawElements(GL_TRIANGLES, pyIndices.size(), GL_UNSIGNED_INT, 0);
-        pyVao.unbind();
-        pyEbo.unbind();
+            const PoolRange* lods[3] = { &pyDrawMesh.range() };
+            int lodCount = 1;
+            for (int i = 0; drawn.denseScene && i < 2 && denseLods[i].valid(); i++) {
+                lods[lodCount++] = &denseLods[i].range();
+            }
+            gpuCulling.setLods(lods, lodCount);
 
-        // disable pyramid animation
-        glUniform1i(pyAnimLoc, false);
+            gpuCulling.dispatch(pyInstanceVbo.id, snap.instanceCount, snap.camera.pos, lodDistance, drawn.frustumCull, drawn.pyAnim && drawn.cpuAnim());
+            pyDrawCount = (GLsizei)gpuCulling.visibleCount;
+        }
 
-        // ____________ GRID ____________
-        glUniform1i(objectIDLoc, 1);
-        glUniform1i(gridAnimLoc, gridAnim);
+        // animated or culled instances are streamed, otherwise the static copy is used. a failed
+        // write (-1) skips the pyramid draw
+        GLuint pyInstanceBuffer = pyInstanceVbo.id;
+        GLintptr pyInstanceOffset = 0;
+        if (snap.streamed && pyDrawCount > 0) {
+            if (pyInstanceStream.reserve(pyDrawCount * sizeof(InstanceData))) {
+                glState.forgetInstances();
+            }
+            pyInstanceStream.bind();
+            pyInstanceOffset = pyInstanceStream.write(snap.drawn.data(), pyDrawCount * sizeof(InstanceData), sizeof(InstanceData));
+            pyInstanceStream.unbind();
+            pyInstanceBuffer = pyInstanceStream.id;
+        }
 
-        // compute mvp for grid
-        // upload the grid mvp matrix before rendering
-        glm::mat4 gridMVP = projection * view * modelGrid;
-        glUniformMatrix4fv(mvpLoc, 1, GL_FALSE, glm::value_ptr(gridMVP));
+        // grid instance
+        gridInstanceVbo.bind();
+        gridInstanceVbo.write(0, &snap.gridInstance, sizeof(InstanceData));
+        gridInstanceVbo.flush();
+        gridInstanceVbo.unbind();
 
-        // render grid
-        gridVao.bind();
-        gridEbo.bind();
-        glDrawElements(GL_LINES, gridIndices.size(), GL_UNSIGNED_INT, 0);
-        gridVao.unbind();
-        gridEbo.unbind();
+        profiler.pop();
 
-        // disable grid animation
-        glUniform1i(gridAnimLoc, false);
+        // ____________ PYRAMID ____________
+        // every lod of the culled instances in one multi draw, the gpu wrote the instance counts
+        if (pyShader && drawn.gpuCull && snap.instanceCount > 0) {
+            float depth = glm::distance(snap.camera.pos, glm::vec3(snap.modelPyramid[3]));
+            RenderCommand& cmd = renderQueue.submit(RenderPassOpaque, *pyShader, pyDrawMesh.vao(), drawn.denseScene ? 1 : 0, depth, snap.camera.zFar);
+            cmd.mode = gpuCulling.mode;
+            cmd.indexType = gpuCulling.indexType;
+            cmd.indirect = gpuCulling.commands.id;
+            cmd.count = gpuCulling.lodCount;
+            cmd.instanceBuffer = gpuCulling.visible.id;
+
+            if (pyDrawMesh.quantized()) {
+                renderQueue.uniform(pyShader->posScale, pyDrawMesh.quantization.scale);
+                renderQueue.uniform(pyShader->posOffset, pyDrawMesh.quantization.offset);
+            }
+        }
 
-        // if you are reading this code, then this part is optional you can set the initCamAnim to
-        // false or just remove this if block
-        if (initCamAnim) {
-            float targetX = 500.0f;
-            float lerpFactor = 0.08f;
+        // meshes of one vertex format share a vao and its buffers, a draw picks its range with
+        // the index offset and base vertex
+        if (pyShader && !drawn.gpuCull && pyDrawCount > 0 && pyInstanceOffset >= 0) {
+            const PoolRange& range = pyDrawMesh.range();
+            float depth = glm::distance(snap.camera.pos, glm::vec3(snap.modelPyramid[3]));
+            RenderCommand& cmd = renderQueue.submit(RenderPassOpaque, *pyShader, pyDrawMesh.vao(), drawn.denseScene ? 1 : 0, depth, snap.camera.zFar);
+            cmd.instances = pyDrawCount;
+            cmd.mode = range.mode;
+            cmd.count = range.indexCount;
+            cmd.indexType = range.indexType;
+            cmd.offset = range.indexOffset;
+            cmd.baseVertex = range.baseVertex;
+            cmd.instanceBuffer = pyInstanceBuffer;
+            cmd.instanceOffset = pyInstanceOffset;
+
+            if (pyDrawMesh.quantized()) {
+                renderQueue.uniform(pyShader->posScale, pyDrawMesh.quantization.scale);
+                renderQueue.uniform(pyShader->posOffset, pyDrawMesh.quantization.offset);
+            }
+        }
 
-            camera.pos.x = glm::mix(camera.pos.x, targetX, lerpFactor);
+        // ____________ GRID ____________
+        if (gridMode != GridModeProcedural && gridIndices.empty()) {
+            buildGridLines();
+        }
+        if (gridMode == GridModeProcedural) {
+            proceduralGrid.submit(renderQueue, snap.gridModel, gridColor, gridSpacing, gridFade);
+        } else if (gridShader && gridMesh.valid()) {
+            float depth = glm::distance(snap.camera.pos, glm::vec3(snap.modelGrid[3]));
+            const PoolRange& range = gridMesh.range();
+            RenderCommand& cmd = renderQueue.submit(RenderPassOpaque, *gridShader, gridMesh.vao(), 0, depth, snap.camera.zFar);
+            cmd.mode = range.mode;
+            cmd.count = range.indexCount;
+            cmd.indexType = range.indexType;
+            cmd.offset = range.indexOffset;
+            cmd.baseVertex = range.baseVertex;
+            cmd.instanceBuffer = gridInstanceVbo.id;
+        }
 
-            if (fabs(camera.pos.x - targetX) < 1.f) {
-                camera.pos.x = targetX;
-                initCamAnim = false;
+        {
+            PROFILE_SCOPE_GPU(profiler, "Draw");
+            if (frameOffset >= 0) {
+                renderQueue.execute(glState);
+            } else {
+                renderQueue.discard();
             }
         }
+        if (scaled) {
+            PROFILE_SCOPE_GPU(profiler, "Upscale");
+            dynamicRes.resolve(outputFbo);
+        }
+        if (!captureUi) {
+            captureFrame();
+        }
+        double submitMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - submitStart).count();
 
         // create new gui frame
-        gui.newFrame();
+        profiler.push("ImGui Build");
+        gui.beginFrame();
+        if (inputLog.mode == InputLog::Recording) {
+            inputLog.captureEvents();
+        } else if (replaying) {
+            InputLog::replayEvents(inputLog.frames[frameIndex]);
+        }
+        if (inputLog.mode != InputLog::Off) {
+            ImGui::GetIO().DeltaTime = inputLog.timestep;
+        }
+        ImGui::NewFrame();
 
         // draw gui
         ImGuiTreeNodeFlags flags = ImGuiTreeNodeFlags_DefaultOpen;
 
         // pyramid transform controls
         if (ImGui::CollapsingHeader("Pyramid Transform", flags)) {
-            ImGui::DragFloat3("Translate##Py", glm::value_ptr(pyTranslate), 1.0f);
-            ImGui::DragFloat3("Rotation##Py", glm::value_ptr(pyRotation), 1.0f);
-            ImGui::DragFloat3("Scale##Py", glm::value_ptr(pyScale), 0.1f);
+            editNodeTransform(snap.pyramid, pyEdit, snap.sequence, simInput, "Py");
+        }
+
+        // pyramid vertex colors, an edit rewrites only the edited vertex in the pool
+        if (ImGui::CollapsingHeader("Pyramid Colors")) {
+            for (size_t i = 0; i < pyVertices.size(); i++) {
+                ImGui::PushID((int)i);
+                if (ImGui::ColorEdit4("##PyColor", glm::value_ptr(pyVertices[i].color))) {
+                    meshPools[VertexFormatFloat].writeVertices(pyMesh.handle, (uint32_t)i, &pyVertices[i], 1);
+                }
+                ImGui::PopID();
+            }
         }
 
         // grid transform controls
         if (ImGui::CollapsingHeader("Grid Transform", flags)) {
-            ImGui::DragFloat3("Translate##Grid", glm::value_ptr(gridTranslate), 1.0f);
-            ImGui::DragFloat3("Rotation##Grid", glm::value_ptr(gridRotation), 1.0f);
-            ImGui::DragFloat3("Scale##Grid", glm::value_ptr(gridScale), 0.1f);
+            editNodeTransform(snap.grid, gridEdit, snap.sequence, simInput, "Grid");
+            ImGui::Combo("Mode##Grid", &gridMode, gridModeNames, IM_ARRAYSIZE(gridModeNames));
+            if (gridMode == GridModeProcedural) {
+                ImGui::DragFloat("Fade distance##Grid", &gridFade, 10.0f, 0.0f, 100000.0f);
+            } else {
+                ImGui::Text("Line geometry: %d lines, %.1f KB", (int)gridIndices.size() / 2,
+                    (gridMesh.vertexBytes + gridMesh.indexBytes) / 1024.0);
+            }
+        }
+
+        // any node of the graph, instance nodes included
+        if (ImGui::CollapsingHeader("Scene Graph")) {
+            ImGui::Text("Nodes: %d, updated last frame: %d (%.3f ms)", (int)snap.sceneNodes, (int)snap.sceneUpdated, snap.sceneMs);
+            ImGui::Combo("Math kernels", &settings.simdLevel, simdLevelNames, IM_ARRAYSIZE(simdLevelNames));
+            ImGui::SliderInt("Node", &sceneSelected, 0, (int)snap.sceneNodes - 1);
+            sceneSelected = std::clamp(sceneSelected, 0, (int)snap.sceneNodes - 1);
+
+            // the selected node's data arrives with the next snapshot
+            ImGui::Text("Name: %s, parent: %s", snap.selected.name.c_str(), snap.selected.parentName.c_str());
+            editNodeTransform(snap.selected, nodeEdit, snap.sequence, simInput, "Node");
         }
 
         // camera controls
         if (ImGui::CollapsingHeader("Camera", flags)) {
-            ImGui::DragFloat3("Camera pos", glm::value_ptr(camera.pos), 1.0f);
-            ImGui::DragFloat3("Camera target", glm::value_ptr(camera.target), 1.0f);
-            ImGui::DragFloat3("up", glm::value_ptr(camera.up), 1.0f);
-            ImGui::SliderFloat("FOV", &camera.fov, 10.0f, 120.0f);
-            ImGui::SliderFloat("Z-Near", &camera.zNear, 0.1f, 1.0f);
-            ImGui::SliderFloat("z-Far", &camera.zFar, 1.0f, 10000.0f);
+            CameraPose& pose = cameraEdit.show(snap.camera, snap.sequence);
+            bool changed = false;
+            changed |= ImGui::DragFloat3("Camera pos", glm::value_ptr(pose.pos), 1.0f);
+            changed |= ImGui::DragFloat3("Camera target", glm::value_ptr(pose.target), 1.0f);
+            changed |= ImGui::DragFloat3("up", glm::value_ptr(pose.up), 1.0f);
+            changed |= ImGui::SliderFloat("FOV", &pose.fov, 10.0f, 120.0f);
+            changed |= ImGui::SliderFloat("Z-Near", &pose.zNear, 0.1f, 1.0f);
+            changed |= ImGui::SliderFloat("z-Far", &pose.zFar, 1.0f, 10000.0f);
+            if (changed) {
+                simInput.setCamera = true;
+                simInput.camera = pose;
+                cameraEdit.edited(simInput.sequence);
+            }
+        }
+
+        // instancing controls, raise the count to stress test the instanced path
+        if (ImGui::CollapsingHeader("Instancing", flags)) {
+            ImGui::SliderInt("Instance Count", &settings.instanceCount, 1, 100000, "%d", ImGuiSliderFlags_Logarithmic);
+            ImGui::DragFloat("Spacing", &settings.instanceSpacing, 1.0f, 0.0f, 2000.0f);
+            ImGui::Checkbox("Frustum culling", &settings.frustumCull);
+            ImGui::Text("BVH: %d nodes, %d visited last cull", snap.bvhNodes, snap.bvhVisited);
+            ImGui::BeginDisabled(!gpuCullReady);
+            ImGui::Checkbox("GPU culling (compute + multi draw indirect)", &settings.gpuCull);
+            ImGui::EndDisabled();
+            if (settings.gpuCull) {
+                ImGui::DragFloat("LOD distance", &lodDistance, 10.0f, 0.0f, 100000.0f);
+                ImGui::Text("Draws: %d lods, %u visible (%d frames ago)", gpuCulling.lodCount, gpuCulling.visibleCount, GpuCulling::readbackFrames - 1);
+            }
+            ImGui::Text("Submission: %.3f ms", submitMs);
         }
 
         // animation control
         if (ImGui::CollapsingHeader("Animation", flags)) {
-            ImGui::Checkbox("Pyramid Animation", &pyAnim);
-            ImGui::Checkbox("Grid Animation", &gridAnim);
-            ImGui::Checkbox("Rotation X", &rotateAnimX);
-            ImGui::Checkbox("Rotation Y", &rotateAnimY);
-            ImGui::Checkbox("Rotation Z", &rotateAnimZ);
-            ImGui::SliderFloat("Animation Speed", &animSpeed, 1.0f, 20.0f);
+            ImGui::Checkbox("Pyramid Animation", &settings.pyAnim);
+            ImGui::Checkbox("Grid Animation", &settings.gridAnim);
+            ImGui::Checkbox("Rotation X", &settings.rotateAnimX);
+            ImGui::Checkbox("Rotation Y", &settings.rotateAnimY);
+            ImGui::Checkbox("Rotation Z", &settings.rotateAnimZ);
+            ImGui::SliderFloat("Animation Speed", &settings.animSpeed, 1.0f, 20.0f);
+        }
+
+        // screenshots and sequences, written by the encoder thread a few frames later
+        if (ImGui::CollapsingHeader("Capture")) {
+            ImGui::Checkbox("Include UI", &captureUi);
+            ImGui::Combo("Format##Capture", &captureFormat, captureFormatNames, IM_ARRAYSIZE(captureFormatNames));
+            ImGui::InputText("Directory##Capture", captureDir, sizeof(captureDir));
+            if (ImGui::Button("Screenshot")) {
+                frameCapture.screenshot(std::string(captureDir) + "/screenshot_" + std::to_string(screenshotCount++) + ".png");
+            }
+            ImGui::SameLine();
+            if (!frameCapture.sequence && ImGui::Button("Record sequence")) {
+                frameCapture.startSequence(captureDir, (CaptureFormat)captureFormat);
+            } else if (frameCapture.sequence && ImGui::Button("Stop")) {
+                frameCapture.stopSequence();
+            }
+            ImGui::Text("Queue: %d, written %d, stalls %d, dropped %d, %.3f ms on this thread", frameCapture.queueDepth(),
+                frameCapture.writtenFrames(), frameCapture.stalls, frameCapture.dropped, frameCapture.lastMs);
+        }
+
+        // how frames are paced, cpu usage covers every thread of the process
+        if (ImGui::CollapsingHeader("Frame Pacing")) {
+            if (ImGui::Combo("Mode##Pacing", &pacingMode, pacingModeNames, IM_ARRAYSIZE(pacingModeNames))) {
+                pacer.setMode((PacingMode)pacingMode, window);
+            }
+            if (pacer.mode == PacingCapped) {
+                float fps = (float)pacer.targetFps;
+                if (ImGui::SliderFloat("Target FPS", &fps, 10.0f, 500.0f, "%.0f")) {
+                    pacer.targetFps = fps;
+                }
+            }
+            ImGui::Text("CPU: %.1f %%, input latency %.2f ms", pacer.cpuPercent, latencyMs);
+            ImGui::Text("Frames: %llu, idle wakeups: %llu", (unsigned long long)pacer.frames, (unsigned long long)pacer.wakeups);
+        }
+
+        // scene resolution against the frame budget, the cost plot is the larger of gpu and
+        // cpu frame time
+        if (ImGui::CollapsingHeader("Dynamic Resolution")) {
+            bool changed = ImGui::Checkbox("Enabled##DynamicRes", &dynamicRes.enabled);
+            changed |= ImGui::SliderFloat("Budget (ms)", &dynamicRes.budgetMs, 2.0f, 50.0f, "%.1f");
+            changed |= ImGui::SliderFloat("Min scale", &dynamicRes.minScale, 0.25f, 1.0f, "%.2f");
+            int filter = dynamicRes.filter;
+            if (ImGui::Combo("Upscale", &filter, upscaleFilterNames, IM_ARRAYSIZE(upscaleFilterNames))) {
+                dynamicRes.filter = (UpscaleFilter)filter;
+            }
+            if (dynamicRes.filter == UpscaleSharpen) {
+                ImGui::SliderFloat("Sharpness", &dynamicRes.sharpenAmount, 0.0f, 1.0f, "%.2f");
+            }
+            if (changed) {
+                dynamicRes.clampScale();
+            }
+
+            ImGui::Text("Scale: %.0f %% (%dx%d of %dx%d)", 100.0f * dynamicRes.width / std::max(1, dynamicRes.outputWidth), dynamicRes.width,
+                dynamicRes.height, dynamicRes.outputWidth, dynamicRes.outputHeight);
+            ImGui::Text("GPU %.3f ms, CPU %.3f ms before present", dynamicRes.gpuMs, dynamicRes.cpuMs);
+            ImGui::PlotLines("##ScaleHistory", dynamicRes.scaleHistory, DynamicResolution::historySize, dynamicRes.historyHead, "scale",
+                0.0f, 1.0f, ImVec2(-1.0f, 50.0f));
+            ImGui::PlotLines("##CostHistory", dynamicRes.costHistory, DynamicResolution::historySize, dynamicRes.historyHead, "frame cost (ms)",
+                0.0f, dynamicRes.budgetMs * 2.0f, ImVec2(-1.0f, 50.0f));
+        }
+
+        // update stage threading, the serial path is the reference for the overlap gain
+        if (ImGui::CollapsingHeader("Frame Pipeline")) {
+            ImGui::Checkbox("Threaded update", &pipeline.threaded);
+            ImGui::Text("Update: %.3f ms, waited %.3f ms", snap.updateMs, pipeline.waitMs);
+            ImGui::Text("Drawing snapshot %llu", (unsigned long long)snap.sequence);
+            ImGui::Text("Jobs: %d threads%s", jobs.threadCount(), jobs.inlineJobs ? ", inline" : "");
+        }
+
+        // shared vertex and index buffers, one pool per vertex format
+        if (ImGui::CollapsingHeader("Mesh Pools")) {
+            for (int f = 0; f < IM_ARRAYSIZE(meshPools.pools); f++) {
+                const MeshPool& pool = meshPools.pools[f];
+                ImGui::Text("%s: %d meshes, vertices %.2f / %.2f MB, indices %.2f / %.2f MB", vertexFormatNames[f], (int)pool.meshCount(),
+                    pool.vertices.used * pool.stride / (1024.0 * 1024.0), pool.vertices.capacity * pool.stride / (1024.0 * 1024.0),
+                    pool.indices.used / (1024.0 * 1024.0), pool.indices.capacity / (1024.0 * 1024.0));
+                ImGui::Text("  fragmented %.0f %% / %.0f %%, %d growths, %d defrags, %.2f MB moved", pool.vertices.fragmentation() * 100.0f,
+                    pool.indices.fragmentation() * 100.0f, (int)pool.growths, (int)pool.defrags, pool.bytesMoved / (1024.0 * 1024.0));
+            }
+            if (ImGui::Button("Defragment")) {
+                for (MeshPool& pool : meshPools.pools) {
+                    pool.defragment();
+                }
+            }
+        }
+
+        // every GL object made through glad, sizes are estimates for textures and renderbuffers
+        if (ImGui::CollapsingHeader("GPU Resources")) {
+            GlResourceTotals totals = GlResources::totals();
+            size_t totalBytes = 0;
+            for (int k = 0; k < GlResourceKindCount; k++) {
+                totalBytes += totals.bytes[k];
+                ImGui::Text("%s: %d, %.2f MB", glResourceKindNames[k], totals.count[k], totals.bytes[k] / (1024.0 * 1024.0));
+            }
+            ImGui::Text("Total: %.2f MB", totalBytes / (1024.0 * 1024.0));
+
+            const GlUploadStats& uploads = GlResources::last;
+            ImGui::Text("Uploads: %.1f KB in %u calls, %u reallocations", uploads.bytes / 1024.0, uploads.uploads, uploads.reallocations);
+            ImGui::Text("Created %u, deleted %u last frame", uploads.created, uploads.deleted);
+            ImGui::PlotLines("##UploadHistory", GlResources::uploadHistory, GlResources::historySize, GlResources::historyHead, "upload (KB/frame)",
+                0.0f, FLT_MAX, ImVec2(-1.0f, 50.0f));
+
+            ImGuiTableFlags tableFlags = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY | ImGuiTableFlags_Resizable;
+            if (ImGui::BeginTable("##GlObjects", 7, tableFlags, ImVec2(0.0f, 200.0f))) {
+                ImGui::TableSetupScrollFreeze(0, 1);
+                ImGui::TableSetupColumn("Object");
+                ImGui::TableSetupColumn("Name");
+                ImGui::TableSetupColumn("KB");
+                ImGui::TableSetupColumn("Usage");
+                ImGui::TableSetupColumn("KB/frame");
+                ImGui::TableSetupColumn("Reallocs");
+                ImGui::TableSetupColumn("Site");
+                ImGui::TableHeadersRow();
+                for (const GlResource& object : GlResources::snapshot()) {
+                    const char* file = object.file ? object.file : "?";
+                    const char* slash = strrchr(file, '/');
+                    ImGui::TableNextRow();
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%s %u", glResourceKindNames[object.kind], object.id);
+                    ImGui::TableNextColumn();
+                    ImGui::TextUnformatted(object.name.empty() ? "-" : object.name.c_str());
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%.1f", object.bytes / 1024.0);
+                    ImGui::TableNextColumn();
+                    ImGui::TextUnformatted(object.immutable ? "immutable" : GlResources::usageName(object.usage));
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%.1f", object.lastUploaded / 1024.0);
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%u", object.reallocations);
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%s:%d", slash ? slash + 1 : file, object.line);
+                }
+                ImGui::EndTable();
+            }
+        }
+
+        // shader permutation controls
+        if (ImGui::CollapsingHeader("Shader", flags)) {
+            ImGui::Checkbox("GPU per-vertex rotation", &settings.gpuAnim);
+            ImGui::Checkbox("Vertex-heavy scene", &settings.denseScene);
+            ImGui::BeginDisabled(packedMesh != nullptr);
+            if (ImGui::Combo("Vertex format", &denseFormat, vertexFormatNames, IM_ARRAYSIZE(vertexFormatNames))) {
+                buildDense((VertexFormat)denseFormat);
+            }
+            ImGui::EndDisabled();
+            ImGui::Text("Dense mesh: %.1f bytes/vertex, %d bytes/index, %.2f MB",
+                (double)denseMesh.vertexBytes / denseMesh.vertexCount, indexSize(denseMesh.range().indexType),
+                (denseMesh.vertexBytes + denseMesh.indexBytes) / (1024.0 * 1024.0));
+            ImGui::Text("Variants compiled: %d (%d building)", (int)shaders.variants.size(), (int)shaders.pending.size());
+            ImGui::Text("Compiler: %s", ShaderCompiler::modeNames[shaderCompiler.mode]);
+            ImGui::Text("Last build: %.2f ms (variant 0x%x)", shaders.lastBuildMs, shaders.lastBuildFeatures);
+            ImGui::Checkbox("Hot reload", &hotReload);
+            ImGui::Text("Frame time: %.3f ms", 1000.0f / ImGui::GetIO().Framerate);
+        }
+
+        // the logged widget results win over whatever the replayed events did, so a replay
+        // stays on the recorded trace when panels moved between builds
+        if (replaying) {
+            const InputFrame& logged = inputLog.frames[frameIndex];
+            if (logged.hasState) {
+                applyUiState(logged.state);
+            }
+            simInput.setCamera = logged.setCamera;
+            if (logged.setCamera) {
+                simInput.camera = logged.camera;
+                cameraEdit.edited(simInput.sequence);
+            }
+            simInput.edits = logged.edits;
+        } else {
+            inputLog.endFrame(uiState(), simInput);
         }
 
         // draw model matrices
         drawText("Pyramid - Model Matrix:", ImVec2(10, 0));
-        drawMat4(modelPyramid, ImVec2(10, 30));
+        drawMat4(snap.modelPyramid, ImVec2(10, 30));
 
         drawText("Grid - Model Matrix:", ImVec2(10, 100));
-        drawMat4(modelGrid, ImVec2(10, 130));
+        drawMat4(snap.modelGrid, ImVec2(10, 130));
+
+        // draw gl call counters of the previous frame
+        char statsBuf[128];
+        snprintf(statsBuf, sizeof(statsBuf), "GL calls / frame: %llu (draws: %llu, vertices: %llu)",
+            (unsigned long long)GlStats::last.calls, (unsigned long long)GlStats::last.drawCalls,
+            (unsigned long long)GlStats::last.vertices);
+        drawText(statsBuf, ImVec2(10, 200));
+
+        // culling results of this frame
+        if (drawn.gpuCull) {
+            snprintf(statsBuf, sizeof(statsBuf), "Visible objects: %d / %d (gpu, %d frames ago)", pyDrawCount, snap.instanceCount, GpuCulling::readbackFrames - 1);
+        } else if (drawn.frustumCull) {
+            snprintf(statsBuf, sizeof(statsBuf), "Visible objects: %d / %d (cull %.3f ms)", pyDrawCount, snap.instanceCount, snap.cullMs);
+        } else {
+            snprintf(statsBuf, sizeof(statsBuf), "Visible objects: %d / %d (culling off)", pyDrawCount, snap.instanceCount);
+        }
+        drawText(statsBuf, ImVec2(10, 220));
+
+        // background shader builds, times cover submit to swap-in
+        snprintf(statsBuf, sizeof(statsBuf), "Shader builds: %d pending, last %.2f ms, grid %.2f ms",
+            (int)(shaders.pending.size() + proceduralGrid.next.pending()), shaders.lastBuildMs, proceduralGrid.shader.buildMs);
+        drawText(statsBuf, ImVec2(10, 240));
+
+        // scene graph work of this frame, proportional to the edited subtrees
+        snprintf(statsBuf, sizeof(statsBuf), "Scene graph: %d / %d nodes updated (%.3f ms)", (int)snap.sceneUpdated, (int)snap.sceneNodes, snap.sceneMs);
+        drawText(statsBuf, ImVec2(10, 260));
+
+        // render queue state filtering of this frame
+        const RenderQueueStats& queueStats = renderQueue.stats;
+        snprintf(statsBuf, sizeof(statsBuf), "Render queue: %u draws, binds %llu / %llu filtered, uniforms %llu / %llu filtered",
+            queueStats.draws, (unsigned long long)queueStats.bindsFiltered, (unsigned long long)queueStats.bindsRequested,
+            (unsigned long long)queueStats.uniformsFiltered, (unsigned long long)queueStats.uniformsRequested);
+        drawText(statsBuf, ImVec2(10, 280));
+
+        // update stage of the drawn snapshot and how long this frame waited for it
+        snprintf(statsBuf, sizeof(statsBuf), "Update: %.3f ms %s, waited %.3f ms", snap.updateMs,
+            pipeline.threaded ? "(threaded)" : "(serial)", pipeline.waitMs);
+        drawText(statsBuf, ImVec2(10, 300));
+
+        snprintf(statsBuf, sizeof(statsBuf), "Pacing: %s, CPU %.1f %%, input latency %.2f ms", pacingModeNames[pacer.mode], pacer.cpuPercent, latencyMs);
+        drawText(statsBuf, ImVec2(10, 320));
+
+        if (frameCapture.requested() || frameCapture.inFlight > 0) {
+            snprintf(statsBuf, sizeof(statsBuf), "Capture: %d frames queued, %d written, %.3f ms", frameCapture.queueDepth(),
+                frameCapture.writtenFrames(), frameCapture.lastMs);
+            drawText(statsBuf, ImVec2(10, 340));
+        }
+
+        if (dynamicRes.enabled) {
+            snprintf(statsBuf, sizeof(statsBuf), "Resolution: %dx%d (%.0f %%), cost %.2f / %.1f ms", dynamicRes.width, dynamicRes.height,
+                100.0f * dynamicRes.width / std::max(1, dynamicRes.outputWidth), std::max(dynamicRes.gpuMs, dynamicRes.cpuMs), dynamicRes.budgetMs);
+            drawText(statsBuf, ImVec2(10, 360));
+        }
+
+        // profiler panel next to the matrix overlay
+        ImGui::SetNextWindowPos(ImVec2(ImGui::GetIO().DisplaySize.x - 520.0f, 10.0f), ImGuiCond_FirstUseEver);
+        ImGui::SetNextWindowSize(ImVec2(510.0f, 420.0f), ImGuiCond_FirstUseEver);
+        profiler.drawPanel();
+        profiler.pop();
 
         // render gui
+        profiler.push("ImGui Render", true);
         gui.render();
+        profiler.pop();
+
+        if (captureUi) {
+            captureFrame();
+        }
+
+        // the next frame's scale follows this one's cost, presenting is left out since it waits
+        // for vsync
+        double renderMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count();
+        dynamicRes.update(profiler.gpuFrameMs(), renderMs);
 
         // display
+        profiler.push("Swap");
         window.swapBuffers();
+        profiler.pop();
+
+        // input is presented once the snapshot built from it is on screen
+        size_t presented = 0;
+        while (presented < inputsInFlight.size() && inputsInFlight[presented].first <= snap.sequence) {
+            latencyMs = (pacer.now() - inputsInFlight[presented].second) * 1000.0;
+            if (opts.bench && frameIndex >= opts.warmup) {
+                benchStats.addLatency(latencyMs);
+            }
+            presented++;
+        }
+        inputsInFlight.erase(inputsInFlight.begin(), inputsInFlight.begin() + presented);
+
+        frameUbo.endFrame();
+        pyInstanceStream.endFrame();
+        GlStats::endFrame();
+        GlResources::endFrame();
+        profiler.endFrame();
+
+        if (opts.bench && frameIndex >= opts.warmup) {
+            std::chrono::duration<double, std::milli> frameTime = std::chrono::steady_clock::now() - frameStart;
+            benchStats.addFrame(frameTime.count(), GlStats::last);
+            benchStats.addUploads(GlResources::last);
+            benchStats.addCull(pyDrawCount, snap.cullMs);
+            benchStats.addSubmit(submitMs);
+            benchStats.addCapture(frameCapture.lastMs, frameCapture.captured);
+            benchStats.addResolution((float)dynamicRes.width / dynamicRes.outputWidth, dynamicRes.width, dynamicRes.height);
+            benchStats.addScene(snap.sceneUpdated, snap.sceneMs);
+            benchStats.addUpdate(snap.updateMs, pipeline.waitMs);
+            benchStats.addQueue(renderQueue.stats);
+            if (replaying) {
+                benchStats.addFrameDetail({ frameTime.count(), submitMs, snap.updateMs, GlStats::last.calls, GlStats::last.drawCalls, pyDrawCount });
+            }
+        }
+        frameIndex++;
+
+        pacer.endFrame();
     } // main loop
 
+    if (opts.bench) {
+        BenchScene scene;
+        scene.objects = settings.instanceCount;
+        scene.threadedUpdate = pipeline.threaded;
+        scene.jobThreads = jobs.threadCount();
+        scene.jobsInline = jobs.inlineJobs;
+        scene.gpuCull = settings.gpuCull;
+        scene.dynamicRes = opts.dynamicRes;
+        scene.upscale = upscaleFilterNames[dynamicRes.filter];
+        scene.pacing = pacingModeNames[pacer.mode];
+        scene.idle = opts.idle;
+        scene.replay = opts.replay;
+        benchStats.stopClock(pacer.now(), pacer.wakeups);
+        scene.gridMode = gridModeNames[gridMode];
+        scene.startupMs = startupMs;
+        scene.meshLoadMs = meshLoadMs;
+        scene.shaderSetupMs = shaderSetupMs;
+        scene.shaderCacheHits = programCache.hits;
+        scene.shaderCacheMisses = programCache.misses;
+        const Mesh& benchMesh = settings.denseScene ? denseMesh : pyMesh;
+        scene.vertexFormat = vertexFormatNames[benchMesh.format];
+        scene.vertexBytes = benchMesh.vertexBytes;
+        scene.vertexCount = benchMesh.vertexCount;
+        scene.indexBytes = benchMesh.indexBytes;
+        scene.indexCount = benchMesh.range().indexCount;
+
+        if (!benchStats.writeJson(opts.out, opts, scene)) {
+            return EXIT_FAILURE;
+        }
+        printf("bench: wrote %s\n", opts.out.c_str());
+    }
+
+    if (inputLog.mode == InputLog::Recording && inputLog.close()) {
+        printf("input: recorded %u frames, %.1f KB to %s\n", inputLog.frameCount, inputLog.bytes / 1024.0, inputLog.path.c_str());
+    }
+
     // clear resources
+    frameCapture.shutdown();
+    if (frameCapture.captured > 0) {
+        printf("capture: %d frames written, %d stalls, %d dropped\n", frameCapture.written, frameCapture.stalls, frameCapture.dropped);
+    }
+    pipeline.shutdown();
+    shaderCompiler.shutdown();
     gui.shutdown();
+
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char** argv)
+{
+    auto startupStart = std::chrono::steady_clock::now();
+
+    Options opts;
+    if (!opts.parse(argc, argv)) {
+        return EXIT_FAILURE;
+    }
+
+    // batch transform kernels, checked against glm without needing a context
+    if (opts.simd >= 0) {
+        MathKernels::setLevel((SimdLevel)opts.simd);
+    }
+    if (opts.simdCheck) {
+        return MathKernels::selfCheck() ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    // a replay is a headless bench of the logged frames at the recorded size, every frame measured
+    InputLog inputLog;
+    if (!opts.replay.empty()) {
+        if (!inputLog.load(opts.replay)) {
+            return EXIT_FAILURE;
+        }
+        if (inputLog.frames.empty()) {
+            fprintf(stderr, "err: input log %s has no frames\n", opts.replay.c_str());
+            return EXIT_FAILURE;
+        }
+        opts.bench = true;
+        opts.width = inputLog.width;
+        opts.height = inputLog.height;
+        opts.warmup = 0;
+        opts.frames = (int)inputLog.frames.size();
+    }
+
+    // initialize window, bench mode renders offscreen without a display
+    Window window;
+    if (opts.bench ? !window.initHeadless(opts.width, opts.height) : !window.init("LearnOpenGL")) {
+        return EXIT_FAILURE;
+    }
+
+    int status = run(opts, inputLog, window, startupStart);
+
+    // every GL owner is gone by now, whatever the registry still holds was never deleted
+    GlResources::reportLeaks();
     window.shutdown();
 
     // exit program
-    return EXIT_SUCCESS;
+    return status;
 }
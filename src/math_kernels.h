@@ -0,0 +1,458 @@
+#ifndef MATH_KERNELS_H
+#define MATH_KERNELS_H
+
+#include "bounds.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define MATH_KERNELS_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#else
+#define MATH_KERNELS_X86 0
+#endif
+
+// avx2 code is compiled per function so the rest of the build keeps the baseline target
+#if MATH_KERNELS_X86 && (defined(__GNUC__) || defined(__clang__))
+#define MATH_KERNELS_AVX2 __attribute__((target("avx2")))
+#else
+#define MATH_KERNELS_AVX2
+#endif
+
+enum SimdLevel {
+    SimdScalar,
+    SimdSse,
+    SimdAvx2,
+};
+
+inline constexpr const char* simdLevelNames[] = { "scalar", "sse", "avx2" };
+
+// translate * rotate X * rotate Y * rotate Z * scale, rotation as euler angles in degrees
+inline glm::mat4 composeTrs(const glm::vec3& t, const glm::vec3& rDegrees, const glm::vec3& s)
+{
+    glm::vec3 r = glm::radians(rDegrees);
+    float sx = std::sin(r.x), cx = std::cos(r.x);
+    float sy = std::sin(r.y), cy = std::cos(r.y);
+    float sz = std::sin(r.z), cz = std::cos(r.z);
+
+    // columns of Rx * Ry * Rz
+    glm::mat4 m(1.0f);
+    m[0] = glm::vec4(cy * cz, sx * sy * cz + cx * sz, -cx * sy * cz + sx * sz, 0.0f) * s.x;
+    m[1] = glm::vec4(-cy * sz, -sx * sy * sz + cx * cz, cx * sy * sz + sx * cz, 0.0f) * s.y;
+    m[2] = glm::vec4(sy, -sx * cy, cx * cy, 0.0f) * s.z;
+    m[3] = glm::vec4(t, 1.0f);
+    return m;
+}
+
+// best level the cpu supports
+inline SimdLevel detectSimdLevel()
+{
+#if MATH_KERNELS_X86
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return SimdAvx2;
+    }
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] >= 7) {
+        __cpuidex(info, 7, 0);
+        bool avx2 = (info[1] & (1 << 5)) != 0;
+        __cpuid(info, 1);
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        if (avx2 && osxsave && (_xgetbv(0) & 6) == 6) {
+            return SimdAvx2;
+        }
+    }
+#endif
+    return SimdSse;
+#else
+    return SimdScalar;
+#endif
+}
+
+// batch transform kernels over contiguous arrays. every simd path performs the same float
+// operations in the same order as the scalar one, so all levels produce identical bits and
+// the scalar path matches glm. only the trigonometry of composeTrs stays scalar.
+struct MathKernels {
+    static inline SimdLevel level = detectSimdLevel();
+
+    // never above what the cpu supports
+    static void setLevel(SimdLevel requested)
+    {
+        SimdLevel best = detectSimdLevel();
+        level = requested > best ? best : requested;
+    }
+
+    // out[i] = a * b[i]
+    static void mulMat4(const glm::mat4& a, const glm::mat4* b, glm::mat4* out, size_t count)
+    {
+#if MATH_KERNELS_X86
+        if (level == SimdAvx2) {
+            return mulMat4Avx2(a, b, out, count);
+        }
+        if (level == SimdSse) {
+            return mulMat4Sse(a, b, out, count);
+        }
+#endif
+        mulMat4Scalar(a, b, out, count);
+    }
+
+    // out[i] = composeTrs(t[i], r[i], s[i])
+    static void composeTrs(const glm::vec3* t, const glm::vec3* r, const glm::vec3* s, glm::mat4* out, size_t count)
+    {
+#if MATH_KERNELS_X86
+        if (level == SimdAvx2) {
+            return composeTrsAvx2(t, r, s, out, count);
+        }
+        if (level == SimdSse) {
+            return composeTrsSse(t, r, s, out, count);
+        }
+#endif
+        composeTrsScalar(t, r, s, out, count);
+    }
+
+    // out[i] = box.transformed(m[i])
+    static void transformAabb(const Aabb& box, const glm::mat4* m, Aabb* out, size_t count)
+    {
+#if MATH_KERNELS_X86
+        if (level == SimdAvx2) {
+            return transformAabbAvx2(box, m, out, count);
+        }
+        if (level == SimdSse) {
+            return transformAabbSse(box, m, out, count);
+        }
+#endif
+        transformAabbScalar(box, m, out, count);
+    }
+
+    static void mulMat4Scalar(const glm::mat4& a, const glm::mat4* b, glm::mat4* out, size_t count)
+    {
+        for (size_t i = 0; i < count; i++) {
+            out[i] = a * b[i];
+        }
+    }
+
+    static void composeTrsScalar(const glm::vec3* t, const glm::vec3* r, const glm::vec3* s, glm::mat4* out, size_t count)
+    {
+        for (size_t i = 0; i < count; i++) {
+            out[i] = ::composeTrs(t[i], r[i], s[i]);
+        }
+    }
+
+    static void transformAabbScalar(const Aabb& box, const glm::mat4* m, Aabb* out, size_t count)
+    {
+        for (size_t i = 0; i < count; i++) {
+            out[i] = box.transformed(m[i]);
+        }
+    }
+
+    // sines and cosines of up to 8 rotations, one array per component for the lane kernels
+    struct TrsLanes {
+        float sx[8], cx[8], sy[8], cy[8], sz[8], cz[8];
+        float scaleX[8], scaleY[8], scaleZ[8];
+
+        void load(const glm::vec3* r, const glm::vec3* s, size_t count)
+        {
+            for (size_t i = 0; i < count; i++) {
+                glm::vec3 rad = glm::radians(r[i]);
+                sx[i] = std::sin(rad.x), cx[i] = std::cos(rad.x);
+                sy[i] = std::sin(rad.y), cy[i] = std::cos(rad.y);
+                sz[i] = std::sin(rad.z), cz[i] = std::cos(rad.z);
+                scaleX[i] = s[i].x, scaleY[i] = s[i].y, scaleZ[i] = s[i].z;
+            }
+        }
+    };
+
+#if MATH_KERNELS_X86
+    static void mulMat4Sse(const glm::mat4& a, const glm::mat4* b, glm::mat4* out, size_t count)
+    {
+        __m128 a0 = _mm_loadu_ps(&a[0][0]);
+        __m128 a1 = _mm_loadu_ps(&a[1][0]);
+        __m128 a2 = _mm_loadu_ps(&a[2][0]);
+        __m128 a3 = _mm_loadu_ps(&a[3][0]);
+
+        for (size_t i = 0; i < count; i++) {
+            for (int col = 0; col < 4; col++) {
+                __m128 v = _mm_loadu_ps(&b[i][col][0]);
+                __m128 sum = _mm_mul_ps(a0, _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0)));
+                sum = _mm_add_ps(sum, _mm_mul_ps(a1, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1))));
+                sum = _mm_add_ps(sum, _mm_mul_ps(a2, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2))));
+                sum = _mm_add_ps(sum, _mm_mul_ps(a3, _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3))));
+                _mm_storeu_ps(&out[i][col][0], sum);
+            }
+        }
+    }
+
+    // two columns per register
+    MATH_KERNELS_AVX2 static void mulMat4Avx2(const glm::mat4& a, const glm::mat4* b, glm::mat4* out, size_t count)
+    {
+        __m256 a0 = _mm256_broadcast_ps((const __m128*)&a[0][0]);
+        __m256 a1 = _mm256_broadcast_ps((const __m128*)&a[1][0]);
+        __m256 a2 = _mm256_broadcast_ps((const __m128*)&a[2][0]);
+        __m256 a3 = _mm256_broadcast_ps((const __m128*)&a[3][0]);
+
+        for (size_t i = 0; i < count; i++) {
+            for (int col = 0; col < 4; col += 2) {
+                __m256 v = _mm256_loadu_ps(&b[i][col][0]);
+                __m256 sum = _mm256_mul_ps(a0, _mm256_permute_ps(v, _MM_SHUFFLE(0, 0, 0, 0)));
+                sum = _mm256_add_ps(sum, _mm256_mul_ps(a1, _mm256_permute_ps(v, _MM_SHUFFLE(1, 1, 1, 1))));
+                sum = _mm256_add_ps(sum, _mm256_mul_ps(a2, _mm256_permute_ps(v, _MM_SHUFFLE(2, 2, 2, 2))));
+                sum = _mm256_add_ps(sum, _mm256_mul_ps(a3, _mm256_permute_ps(v, _MM_SHUFFLE(3, 3, 3, 3))));
+                _mm256_storeu_ps(&out[i][col][0], sum);
+            }
+        }
+    }
+
+    // one rotation/scale per lane, the columns are transposed back into the matrices
+    static void composeTrsSse(const glm::vec3* t, const glm::vec3* r, const glm::vec3* s, glm::mat4* out, size_t count)
+    {
+        const __m128 sign = _mm_set1_ps(-0.0f);
+        const __m128 zero = _mm_setzero_ps();
+
+        TrsLanes lanes;
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            lanes.load(r + i, s + i, 4);
+            __m128 sx = _mm_loadu_ps(lanes.sx), cx = _mm_loadu_ps(lanes.cx);
+            __m128 sy = _mm_loadu_ps(lanes.sy), cy = _mm_loadu_ps(lanes.cy);
+            __m128 sz = _mm_loadu_ps(lanes.sz), cz = _mm_loadu_ps(lanes.cz);
+            __m128 scaleX = _mm_loadu_ps(lanes.scaleX);
+            __m128 scaleY = _mm_loadu_ps(lanes.scaleY);
+            __m128 scaleZ = _mm_loadu_ps(lanes.scaleZ);
+
+            __m128 sxsy = _mm_mul_ps(sx, sy);
+            __m128 cxsy = _mm_mul_ps(cx, sy);
+
+            __m128 c[3][4];
+            c[0][0] = _mm_mul_ps(_mm_mul_ps(cy, cz), scaleX);
+            c[0][1] = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(sxsy, cz), _mm_mul_ps(cx, sz)), scaleX);
+            c[0][2] = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_xor_ps(cxsy, sign), cz), _mm_mul_ps(sx, sz)), scaleX);
+            c[0][3] = _mm_mul_ps(zero, scaleX);
+            c[1][0] = _mm_mul_ps(_mm_mul_ps(_mm_xor_ps(cy, sign), sz), scaleY);
+            c[1][1] = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_xor_ps(sxsy, sign), sz), _mm_mul_ps(cx, cz)), scaleY);
+            c[1][2] = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(cxsy, sz), _mm_mul_ps(sx, cz)), scaleY);
+            c[1][3] = _mm_mul_ps(zero, scaleY);
+            c[2][0] = _mm_mul_ps(sy, scaleZ);
+            c[2][1] = _mm_mul_ps(_mm_mul_ps(_mm_xor_ps(sx, sign), cy), scaleZ);
+            c[2][2] = _mm_mul_ps(_mm_mul_ps(cx, cy), scaleZ);
+            c[2][3] = _mm_mul_ps(zero, scaleZ);
+
+            for (int col = 0; col < 3; col++) {
+                _MM_TRANSPOSE4_PS(c[col][0], c[col][1], c[col][2], c[col][3]);
+                for (int lane = 0; lane < 4; lane++) {
+                    _mm_storeu_ps(&out[i + lane][col][0], c[col][lane]);
+                }
+            }
+
+            for (int lane = 0; lane < 4; lane++) {
+                out[i + lane][3] = glm::vec4(t[i + lane], 1.0f);
+            }
+        }
+
+        composeTrsScalar(t + i, r + i, s + i, out + i, count - i);
+    }
+
+    MATH_KERNELS_AVX2 static void composeTrsAvx2(const glm::vec3* t, const glm::vec3* r, const glm::vec3* s, glm::mat4* out, size_t count)
+    {
+        const __m256 sign = _mm256_set1_ps(-0.0f);
+        const __m256 zero = _mm256_setzero_ps();
+
+        TrsLanes lanes;
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            lanes.load(r + i, s + i, 8);
+            __m256 sx = _mm256_loadu_ps(lanes.sx), cx = _mm256_loadu_ps(lanes.cx);
+            __m256 sy = _mm256_loadu_ps(lanes.sy), cy = _mm256_loadu_ps(lanes.cy);
+            __m256 sz = _mm256_loadu_ps(lanes.sz), cz = _mm256_loadu_ps(lanes.cz);
+            __m256 scaleX = _mm256_loadu_ps(lanes.scaleX);
+            __m256 scaleY = _mm256_loadu_ps(lanes.scaleY);
+            __m256 scaleZ = _mm256_loadu_ps(lanes.scaleZ);
+
+            __m256 sxsy = _mm256_mul_ps(sx, sy);
+            __m256 cxsy = _mm256_mul_ps(cx, sy);
+
+            __m256 c[3][4];
+            c[0][0] = _mm256_mul_ps(_mm256_mul_ps(cy, cz), scaleX);
+            c[0][1] = _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(sxsy, cz), _mm256_mul_ps(cx, sz)), scaleX);
+            c[0][2] = _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_xor_ps(cxsy, sign), cz), _mm256_mul_ps(sx, sz)), scaleX);
+            c[0][3] = _mm256_mul_ps(zero, scaleX);
+            c[1][0] = _mm256_mul_ps(_mm256_mul_ps(_mm256_xor_ps(cy, sign), sz), scaleY);
+            c[1][1] = _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_xor_ps(sxsy, sign), sz), _mm256_mul_ps(cx, cz)), scaleY);
+            c[1][2] = _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(cxsy, sz), _mm256_mul_ps(sx, cz)), scaleY);
+            c[1][3] = _mm256_mul_ps(zero, scaleY);
+            c[2][0] = _mm256_mul_ps(sy, scaleZ);
+            c[2][1] = _mm256_mul_ps(_mm256_mul_ps(_mm256_xor_ps(sx, sign), cy), scaleZ);
+            c[2][2] = _mm256_mul_ps(_mm256_mul_ps(cx, cy), scaleZ);
+            c[2][3] = _mm256_mul_ps(zero, scaleZ);
+
+            // transpose each 128-bit half like the sse path
+            for (int col = 0; col < 3; col++) {
+                for (int half = 0; half < 2; half++) {
+                    __m128 x = half ? _mm256_extractf128_ps(c[col][0], 1) : _mm256_castps256_ps128(c[col][0]);
+                    __m128 y = half ? _mm256_extractf128_ps(c[col][1], 1) : _mm256_castps256_ps128(c[col][1]);
+                    __m128 z = half ? _mm256_extractf128_ps(c[col][2], 1) : _mm256_castps256_ps128(c[col][2]);
+                    __m128 w = half ? _mm256_extractf128_ps(c[col][3], 1) : _mm256_castps256_ps128(c[col][3]);
+                    _MM_TRANSPOSE4_PS(x, y, z, w);
+
+                    size_t base = i + half * 4;
+                    _mm_storeu_ps(&out[base + 0][col][0], x);
+                    _mm_storeu_ps(&out[base + 1][col][0], y);
+                    _mm_storeu_ps(&out[base + 2][col][0], z);
+                    _mm_storeu_ps(&out[base + 3][col][0], w);
+                }
+            }
+
+            for (int lane = 0; lane < 8; lane++) {
+                out[i + lane][3] = glm::vec4(t[i + lane], 1.0f);
+            }
+        }
+
+        composeTrsSse(t + i, r + i, s + i, out + i, count - i);
+    }
+
+    // center and extent are shared, only the matrix differs per output
+    static void transformAabbSse(const Aabb& box, const glm::mat4* m, Aabb* out, size_t count)
+    {
+        glm::vec3 center = box.center();
+        glm::vec3 extent = box.extent();
+        const __m128 cx = _mm_set1_ps(center.x), cy = _mm_set1_ps(center.y), cz = _mm_set1_ps(center.z);
+        const __m128 ex = _mm_set1_ps(extent.x), ey = _mm_set1_ps(extent.y), ez = _mm_set1_ps(extent.z);
+        const __m128 abs = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+
+        for (size_t i = 0; i < count; i++) {
+            __m128 m0 = _mm_loadu_ps(&m[i][0][0]);
+            __m128 m1 = _mm_loadu_ps(&m[i][1][0]);
+            __m128 m2 = _mm_loadu_ps(&m[i][2][0]);
+            __m128 m3 = _mm_loadu_ps(&m[i][3][0]);
+
+            // same grouping as glm's mat4 * vec4
+            __m128 c = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m0, cx), _mm_mul_ps(m1, cy)), _mm_add_ps(_mm_mul_ps(m2, cz), m3));
+            __m128 e = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_and_ps(m0, abs), ex), _mm_mul_ps(_mm_and_ps(m1, abs), ey)), _mm_mul_ps(_mm_and_ps(m2, abs), ez));
+
+            float lo[4], hi[4];
+            _mm_storeu_ps(lo, _mm_sub_ps(c, e));
+            _mm_storeu_ps(hi, _mm_add_ps(c, e));
+            out[i].min = glm::vec3(lo[0], lo[1], lo[2]);
+            out[i].max = glm::vec3(hi[0], hi[1], hi[2]);
+        }
+    }
+
+    // two matrices per register
+    MATH_KERNELS_AVX2 static void transformAabbAvx2(const Aabb& box, const glm::mat4* m, Aabb* out, size_t count)
+    {
+        glm::vec3 center = box.center();
+        glm::vec3 extent = box.extent();
+        const __m256 cx = _mm256_set1_ps(center.x), cy = _mm256_set1_ps(center.y), cz = _mm256_set1_ps(center.z);
+        const __m256 ex = _mm256_set1_ps(extent.x), ey = _mm256_set1_ps(extent.y), ez = _mm256_set1_ps(extent.z);
+        const __m256 abs = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+
+        size_t i = 0;
+        for (; i + 2 <= count; i += 2) {
+            __m256 m0 = _mm256_set_m128(_mm_loadu_ps(&m[i + 1][0][0]), _mm_loadu_ps(&m[i][0][0]));
+            __m256 m1 = _mm256_set_m128(_mm_loadu_ps(&m[i + 1][1][0]), _mm_loadu_ps(&m[i][1][0]));
+            __m256 m2 = _mm256_set_m128(_mm_loadu_ps(&m[i + 1][2][0]), _mm_loadu_ps(&m[i][2][0]));
+            __m256 m3 = _mm256_set_m128(_mm_loadu_ps(&m[i + 1][3][0]), _mm_loadu_ps(&m[i][3][0]));
+
+            __m256 c = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m0, cx), _mm256_mul_ps(m1, cy)), _mm256_add_ps(_mm256_mul_ps(m2, cz), m3));
+            __m256 e = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_and_ps(m0, abs), ex), _mm256_mul_ps(_mm256_and_ps(m1, abs), ey)), _mm256_mul_ps(_mm256_and_ps(m2, abs), ez));
+
+            float lo[8], hi[8];
+            _mm256_storeu_ps(lo, _mm256_sub_ps(c, e));
+            _mm256_storeu_ps(hi, _mm256_add_ps(c, e));
+            out[i].min = glm::vec3(lo[0], lo[1], lo[2]);
+            out[i].max = glm::vec3(hi[0], hi[1], hi[2]);
+            out[i + 1].min = glm::vec3(lo[4], lo[5], lo[6]);
+            out[i + 1].max = glm::vec3(hi[4], hi[5], hi[6]);
+        }
+
+        transformAabbSse(box, m + i, out + i, count - i);
+    }
+#endif
+
+    // compares every supported level against glm on random transforms, bit for bit where the
+    // kernel is defined by a glm expression. prints a line per level, false on any mismatch.
+    // timings live in pyramid_bench.
+    static bool selfCheck(size_t count = 4099)
+    {
+        uint32_t seed = 12345;
+        auto random = [&seed](float lo, float hi) {
+            seed = seed * 1664525u + 1013904223u;
+            return lo + (hi - lo) * ((seed >> 8) / 16777216.0f);
+        };
+
+        std::vector<glm::vec3> t(count), r(count), s(count);
+        for (size_t i = 0; i < count; i++) {
+            t[i] = glm::vec3(random(-1000.0f, 1000.0f), random(-1000.0f, 1000.0f), random(-1000.0f, 1000.0f));
+            r[i] = glm::vec3(random(-360.0f, 360.0f), random(-360.0f, 360.0f), random(-360.0f, 360.0f));
+            s[i] = glm::vec3(random(-4.0f, 4.0f), random(0.1f, 4.0f), random(0.1f, 4.0f));
+        }
+        glm::mat4 viewProjection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 5000.0f)
+            * glm::lookAt(glm::vec3(300.0f, 200.0f, 500.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        Aabb box { glm::vec3(-50.0f, 0.0f, -50.0f), glm::vec3(50.0f, 100.0f, 50.0f) };
+
+        // references straight from glm
+        std::vector<glm::mat4> local(count), mvp(count);
+        std::vector<Aabb> bounds(count);
+        bool ok = true;
+        float composeError = 0.0f;
+        for (size_t i = 0; i < count; i++) {
+            glm::mat4 m = glm::translate(glm::mat4(1.0f), t[i]);
+            m = glm::rotate(m, glm::radians(r[i].x), glm::vec3(1.0f, 0.0f, 0.0f));
+            m = glm::rotate(m, glm::radians(r[i].y), glm::vec3(0.0f, 1.0f, 0.0f));
+            m = glm::rotate(m, glm::radians(r[i].z), glm::vec3(0.0f, 0.0f, 1.0f));
+            m = glm::scale(m, s[i]);
+
+            local[i] = ::composeTrs(t[i], r[i], s[i]);
+            for (int col = 0; col < 4; col++) {
+                for (int row = 0; row < 4; row++) {
+                    float error = std::abs(local[i][col][row] - m[col][row]) / (1.0f + std::abs(m[col][row]));
+                    composeError = std::max(composeError, error);
+                }
+            }
+
+            mvp[i] = viewProjection * local[i];
+            bounds[i] = box.transformed(local[i]);
+        }
+
+        // glm composes through three rotation matrices, so only closeness is expected there
+        if (composeError > 1e-5f) {
+            fprintf(stderr, "err: composeTrs differs from glm by %g\n", composeError);
+            ok = false;
+        }
+
+        SimdLevel saved = level;
+        std::vector<glm::mat4> outLocal(count), outMvp(count);
+        std::vector<Aabb> outBounds(count);
+        for (int l = SimdScalar; l <= detectSimdLevel(); l++) {
+            level = (SimdLevel)l;
+            composeTrs(t.data(), r.data(), s.data(), outLocal.data(), count);
+            mulMat4(viewProjection, outLocal.data(), outMvp.data(), count);
+            transformAabb(box, outLocal.data(), outBounds.data(), count);
+
+            bool composeOk = memcmp(outLocal.data(), local.data(), count * sizeof(glm::mat4)) == 0;
+            bool mulOk = memcmp(outMvp.data(), mvp.data(), count * sizeof(glm::mat4)) == 0;
+            bool boundsOk = memcmp(outBounds.data(), bounds.data(), count * sizeof(Aabb)) == 0;
+            ok = ok && composeOk && mulOk && boundsOk;
+
+            printf("simd %-6s compose %s, mvp %s, aabb %s\n", simdLevelNames[l],
+                composeOk ? "ok" : "MISMATCH", mulOk ? "ok" : "MISMATCH", boundsOk ? "ok" : "MISMATCH");
+        }
+        level = saved;
+
+        return ok;
+    }
+};
+
+#endif // MATH_KERNELS_H
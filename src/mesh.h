@@ -0,0 +1,99 @@
+#ifndef MESH_H
+#define MESH_H
+
+#include "asset_pack.h"
+#include "mesh_pool.h"
+#include "vertex_layout.h"
+
+// static indexed mesh stored in a selectable vertex format with the narrowest index type,
+// suballocated from the pool of its format. the pools must outlive their meshes.
+struct Mesh {
+    MeshPool* pool = nullptr;
+    MeshHandle handle = meshNone;
+
+    VertexFormat format = VertexFormatFloat;
+    PositionQuantization quantization;
+
+    size_t vertexCount = 0;
+    size_t vertexBytes = 0;
+    size_t indexBytes = 0;
+
+    Mesh() = default;
+    ~Mesh() { release(); }
+
+    Mesh(const Mesh&) = delete;
+    Mesh& operator=(const Mesh&) = delete;
+
+    bool quantized() const { return format != VertexFormatFloat; }
+    bool valid() const { return pool && handle != meshNone; }
+
+    // base vertex, index range, type and mode of the draw
+    const PoolRange& range() const { return (*pool)[handle]; }
+
+    GLuint vao() const { return pool->vao.id; }
+
+    void release()
+    {
+        if (valid()) {
+            pool->remove(handle);
+        }
+        pool = nullptr;
+        handle = meshNone;
+    }
+
+    // `indexRange` widens the index type to address that many vertices, so meshes drawn by one
+    // multi draw share it. `sharedQuantization` likewise replaces the mesh's own position range.
+    void build(MeshPools& pools, const std::vector<Vertex>& vertices, const std::vector<GLuint>& indices, VertexFormat vertexFormat, GLenum drawMode = GL_TRIANGLES, size_t indexRange = 0,
+        const PositionQuantization* sharedQuantization = nullptr)
+    {
+        release();
+
+        format = vertexFormat;
+        vertexCount = vertices.size();
+
+        std::vector<uint8_t> packedIndices;
+        GLenum indexType = packIndices(indices, std::max(vertices.size(), indexRange), packedIndices);
+        indexBytes = packedIndices.size();
+
+        auto upload = [&](const auto& packed) {
+            using V = typename std::decay_t<decltype(packed)>::value_type;
+            vertexBytes = packed.size() * sizeof(V);
+            pool = &pools[format];
+            handle = pool->add(packed.data(), (uint32_t)packed.size(), packedIndices.data(), indexType, (GLsizei)indices.size(), drawMode);
+        };
+
+        if (format == VertexFormatSnorm16) {
+            quantization = sharedQuantization ? *sharedQuantization : PositionQuantization::fromBounds(vertices);
+            std::vector<VertexSnorm16> packed;
+            packVertices(vertices, quantization, packed);
+            upload(packed);
+        } else if (format == VertexFormatHalf) {
+            quantization = sharedQuantization ? *sharedQuantization : PositionQuantization::fromBounds(vertices);
+            std::vector<VertexHalf> packed;
+            packVertices(vertices, quantization, packed);
+            upload(packed);
+        } else {
+            quantization = PositionQuantization {};
+            upload(vertices);
+        }
+    }
+
+    // cooked float mesh, uploaded straight from the mapped pack without a staging copy
+    void build(MeshPools& pools, const PackMesh& mesh, GLenum drawMode = GL_TRIANGLES)
+    {
+        release();
+
+        const uint8_t* blob = (const uint8_t*)&mesh;
+
+        format = VertexFormatFloat;
+        quantization = PositionQuantization {};
+        vertexCount = mesh.vertexCount;
+        vertexBytes = mesh.vertexBytes;
+        indexBytes = mesh.indexBytes;
+
+        pool = &pools[format];
+        handle = pool->add(blob + mesh.vertexOffset, (uint32_t)mesh.vertexCount, blob + mesh.indexOffset, mesh.indexType, (GLsizei)mesh.indexCount, drawMode);
+    }
+};
+
+#endif // MESH_H
@@ -0,0 +1,77 @@
+#ifndef MESH_GEN_H
+#define MESH_GEN_H
+
+#define GLAD_IMPLEMENTATION
+#include "glad/glad.h"
+
+#include "job_system.h"
+#include "vertex.h"
+
+#include <cmath>
+#include <vector>
+
+// uv sphere colored by its normal, used as a vertex-heavy test mesh. rings are written in
+// place, split across `jobs` when given.
+inline void generateSphere(std::vector<Vertex>& vertices, std::vector<GLuint>& indices, float radius, int rings, int segments, JobSystem* jobs = nullptr)
+{
+    vertices.resize((size_t)(rings + 1) * (segments + 1));
+    indices.resize((size_t)rings * segments * 6);
+
+    const float pi = 3.14159265358979f;
+    parallelFor(jobs, 0, rings + 1, 16, [&](size_t first, size_t last) {
+        for (int r = (int)first; r < (int)last; r++) {
+            float phi = pi * r / rings;
+            Vertex* row = &vertices[(size_t)r * (segments + 1)];
+            for (int s = 0; s <= segments; s++) {
+                float theta = 2.0f * pi * s / segments;
+                glm::vec3 n(std::sin(phi) * std::cos(theta), std::cos(phi), std::sin(phi) * std::sin(theta));
+                row[s] = Vertex(n * radius, glm::vec4(n * 0.5f + 0.5f, 1.0f));
+            }
+        }
+    });
+
+    parallelFor(jobs, 0, rings, 16, [&](size_t first, size_t last) {
+        for (int r = (int)first; r < (int)last; r++) {
+            GLuint* quad = &indices[(size_t)r * segments * 6];
+            for (int s = 0; s < segments; s++, quad += 6) {
+                GLuint a = r * (segments + 1) + s;
+                GLuint b = a + segments + 1;
+                quad[0] = a;
+                quad[1] = b;
+                quad[2] = a + 1;
+                quad[3] = a + 1;
+                quad[4] = b;
+                quad[5] = b + 1;
+            }
+        }
+    });
+}
+
+// line list on the XZ plane, `size` lines on each side of the origin along both axes
+inline void generateGridLines(std::vector<Vertex>& vertices, std::vector<GLuint>& indices, int size, float spacing, const glm::vec4& color, JobSystem* jobs = nullptr)
+{
+    vertices.resize((size_t)(2 * size + 1) * 4);
+    indices.resize(vertices.size());
+
+    const float extent = size * spacing;
+    parallelFor(jobs, 0, 2 * size + 1, 4096, [&](size_t first, size_t last) {
+        for (size_t line = first; line < last; line++) {
+            float offset = ((int)line - size) * spacing;
+            Vertex* v = &vertices[line * 4];
+
+            // parallel to Z
+            v[0] = Vertex(glm::vec3(offset, 0.0f, -extent), color);
+            v[1] = Vertex(glm::vec3(offset, 0.0f, extent), color);
+
+            // parallel to X
+            v[2] = Vertex(glm::vec3(-extent, 0.0f, offset), color);
+            v[3] = Vertex(glm::vec3(extent, 0.0f, offset), color);
+
+            for (GLuint i = (GLuint)line * 4; i < (GLuint)line * 4 + 4; i++) {
+                indices[i] = i;
+            }
+        }
+    });
+}
+
+#endif // MESH_GEN_H
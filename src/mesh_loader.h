@@ -0,0 +1,322 @@
+#ifndef MESH_LOADER_H
+#define MESH_LOADER_H
+
+#define GLAD_IMPLEMENTATION
+#include "glad/glad.h"
+
+#include "bounds.h"
+#include "file.h"
+#include "vertex.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// text mesh importers used by the cook tool, and at runtime when a mesh is not in the pack.
+// faces are fan triangulated. files without colors are colored by position within the bounds.
+struct MeshLoader {
+    static bool load(const std::string& path, std::vector<Vertex>& vertices, std::vector<GLuint>& indices)
+    {
+        std::string ext = path.size() >= 4 ? path.substr(path.size() - 4) : "";
+        for (char& c : ext) {
+            c = (char)tolower((unsigned char)c);
+        }
+
+        if (ext == ".obj") {
+            return loadObj(path, vertices, indices);
+        }
+        if (ext == ".ply") {
+            return loadPly(path, vertices, indices);
+        }
+
+        fprintf(stderr, "err: unsupported mesh format: %s\n", path.c_str());
+        return false;
+    }
+
+    // `missingOnly` keeps the vertices that already have a color, marked by a non-negative alpha
+    static void colorByPosition(std::vector<Vertex>& vertices, bool missingOnly = false)
+    {
+        Aabb bounds;
+        for (const auto& v : vertices) {
+            bounds.expand(v.position);
+        }
+
+        glm::vec3 size = glm::max(bounds.max - bounds.min, glm::vec3(1e-6f));
+        for (auto& v : vertices) {
+            if (!missingOnly || v.color.a < 0.0f) {
+                v.color = glm::vec4((v.position - bounds.min) / size, 1.0f);
+            }
+        }
+    }
+
+    // v, vn and f records, texture coordinates are ignored
+    static bool loadObj(const std::string& path, std::vector<Vertex>& vertices, std::vector<GLuint>& indices)
+    {
+        auto source = File::readFile(path);
+        if (!source.has_value()) {
+            fprintf(stderr, "err: failed to read mesh file: %s\n", path.c_str());
+            return false;
+        }
+
+        std::vector<glm::vec3> positions;
+        std::vector<glm::vec3> normals;
+        vertices.clear();
+        indices.clear();
+
+        // one output vertex per distinct position/normal pair
+        std::unordered_map<uint64_t, GLuint> remap;
+        std::vector<GLuint> face;
+
+        const char* p = source->c_str();
+        const char* end = p + source->size();
+        while (p < end) {
+            const char* line = p;
+            while (p < end && *p != '\n') {
+                p++;
+            }
+            const char* lineEnd = p++;
+
+            if (line[0] == 'v' && line[1] == ' ') {
+                char* c = (char*)line + 2;
+                float x = strtof(c, &c), y = strtof(c, &c), z = strtof(c, &c);
+                positions.emplace_back(x, y, z);
+            } else if (line[0] == 'v' && line[1] == 'n' && line[2] == ' ') {
+                char* c = (char*)line + 3;
+                float x = strtof(c, &c), y = strtof(c, &c), z = strtof(c, &c);
+                normals.emplace_back(x, y, z);
+            } else if (line[0] == 'f' && line[1] == ' ') {
+                face.clear();
+                char* c = (char*)line + 2;
+                while (c < lineEnd) {
+                    while (c < lineEnd && (*c == ' ' || *c == '\t' || *c == '\r')) {
+                        c++;
+                    }
+                    if (c >= lineEnd) {
+                        break;
+                    }
+
+                    long vi = strtol(c, &c, 10), ni = 0;
+                    if (*c == '/') {
+                        c++;
+                        if (*c != '/') {
+                            strtol(c, &c, 10);
+                        }
+                        if (*c == '/') {
+                            c++;
+                            ni = strtol(c, &c, 10);
+                        }
+                    }
+                    while (c < lineEnd && *c != ' ' && *c != '\t' && *c != '\r') {
+                        c++;
+                    }
+
+                    // negative indices count back from the latest record
+                    vi = vi < 0 ? (long)positions.size() + vi : vi - 1;
+                    ni = ni < 0 ? (long)normals.size() + ni : ni - 1;
+                    if (vi < 0 || vi >= (long)positions.size()) {
+                        fprintf(stderr, "err: %s: face references missing vertex\n", path.c_str());
+                        return false;
+                    }
+                    if (ni >= (long)normals.size()) {
+                        ni = -1;
+                    }
+
+                    uint64_t key = (uint64_t)vi << 32 | (uint32_t)ni;
+                    auto [it, inserted] = remap.emplace(key, (GLuint)vertices.size());
+                    if (inserted) {
+                        glm::vec4 color = ni >= 0 ? glm::vec4(glm::normalize(normals[ni]) * 0.5f + 0.5f, 1.0f) : glm::vec4(-1.0f);
+                        vertices.push_back(Vertex(positions[vi], color));
+                    }
+                    face.push_back(it->second);
+                }
+
+                for (size_t i = 2; i < face.size(); i++) {
+                    indices.insert(indices.end(), { face[0], face[i - 1], face[i] });
+                }
+            }
+        }
+
+        // corners without a normal are marked with a negative color and colored by position
+        colorByPosition(vertices, !normals.empty());
+        return !indices.empty();
+    }
+
+    // ascii and binary_little_endian, x/y/z plus optional red/green/blue vertex properties
+    static bool loadPly(const std::string& path, std::vector<Vertex>& vertices, std::vector<GLuint>& indices)
+    {
+        auto source = File::readFile(path);
+        if (!source.has_value()) {
+            fprintf(stderr, "err: failed to read mesh file: %s\n", path.c_str());
+            return false;
+        }
+
+        struct Property {
+            std::string name;
+            std::string type;
+            std::string countType; // set for list properties
+        };
+
+        struct Element {
+            std::string name;
+            size_t count = 0;
+            std::vector<Property> properties;
+        };
+
+        const std::string& s = source.value();
+        if (s.compare(0, 3, "ply") != 0) {
+            fprintf(stderr, "err: %s is not a ply file\n", path.c_str());
+            return false;
+        }
+
+        std::vector<Element> elements;
+        bool binary = false;
+        size_t pos = 0;
+        while (true) {
+            size_t eol = s.find('\n', pos);
+            if (eol == std::string::npos) {
+                fprintf(stderr, "err: %s: unterminated ply header\n", path.c_str());
+                return false;
+            }
+
+            char word[5][64] = {};
+            sscanf(s.c_str() + pos, "%63s %63s %63s %63s %63s", word[0], word[1], word[2], word[3], word[4]);
+            pos = eol + 1;
+
+            if (!strcmp(word[0], "format")) {
+                binary = !strcmp(word[1], "binary_little_endian");
+                if (!binary && strcmp(word[1], "ascii")) {
+                    fprintf(stderr, "err: %s: unsupported ply format %s\n", path.c_str(), word[1]);
+                    return false;
+                }
+            } else if (!strcmp(word[0], "element")) {
+                elements.push_back({ word[1], (size_t)strtoull(word[2], nullptr, 10), {} });
+            } else if (!strcmp(word[0], "property") && !elements.empty()) {
+                // property list <count type> <item type> <name>
+                if (!strcmp(word[1], "list")) {
+                    elements.back().properties.push_back({ word[4], word[3], word[2] });
+                } else {
+                    elements.back().properties.push_back({ word[2], word[1], "" });
+                }
+            } else if (!strcmp(word[0], "end_header")) {
+                break;
+            }
+        }
+
+        auto typeSize = [](const std::string& t) -> size_t {
+            if (t == "char" || t == "uchar" || t == "int8" || t == "uint8") return 1;
+            if (t == "short" || t == "ushort" || t == "int16" || t == "uint16") return 2;
+            if (t == "double" || t == "float64") return 8;
+            return 4;
+        };
+
+        const char* p = s.c_str() + pos;
+        const char* end = s.c_str() + s.size();
+        bool truncated = false;
+
+        // reads one scalar of the given type and advances
+        auto read = [&](const std::string& t) -> double {
+            if (!binary) {
+                char* next = nullptr;
+                double v = strtod(p, &next);
+                truncated |= next == p;
+                p = next;
+                return v;
+            }
+
+            size_t n = typeSize(t);
+            if ((size_t)(end - p) < n) {
+                truncated = true;
+                return 0.0;
+            }
+
+            uint8_t raw[8] = {};
+            memcpy(raw, p, n);
+            p += n;
+
+            if (t == "char" || t == "int8") return (int8_t)raw[0];
+            if (t == "uchar" || t == "uint8") return raw[0];
+            if (t == "short" || t == "int16") { int16_t v; memcpy(&v, raw, 2); return v; }
+            if (t == "ushort" || t == "uint16") { uint16_t v; memcpy(&v, raw, 2); return v; }
+            if (t == "int" || t == "int32") { int32_t v; memcpy(&v, raw, 4); return v; }
+            if (t == "uint" || t == "uint32") { uint32_t v; memcpy(&v, raw, 4); return v; }
+            if (t == "double" || t == "float64") { double v; memcpy(&v, raw, 8); return v; }
+            float v;
+            memcpy(&v, raw, 4);
+            return v;
+        };
+
+        vertices.clear();
+        indices.clear();
+        bool hasColor = false;
+        std::vector<GLuint> face;
+
+        for (const Element& element : elements) {
+            bool isVertex = element.name == "vertex";
+            bool isFace = element.name == "face";
+            // the header count is untrusted, every element takes at least a byte of the body
+            if (isVertex) {
+                vertices.reserve(std::min(element.count, (size_t)(end - p)));
+            }
+
+            for (size_t i = 0; i < element.count && !truncated; i++) {
+                Vertex v;
+                face.clear();
+
+                for (const Property& prop : element.properties) {
+                    if (!prop.countType.empty()) {
+                        size_t count = (size_t)read(prop.countType);
+                        for (size_t k = 0; k < count && !truncated; k++) {
+                            face.push_back((GLuint)read(prop.type));
+                        }
+                        continue;
+                    }
+
+                    double value = read(prop.type);
+                    if (!isVertex) {
+                        continue;
+                    }
+
+                    float scale = prop.type == "uchar" || prop.type == "uint8" ? 1.0f / 255.0f : 1.0f;
+                    if (prop.name == "x") v.position.x = (float)value;
+                    else if (prop.name == "y") v.position.y = (float)value;
+                    else if (prop.name == "z") v.position.z = (float)value;
+                    else if (prop.name == "red") { v.color.r = (float)value * scale; hasColor = true; }
+                    else if (prop.name == "green") v.color.g = (float)value * scale;
+                    else if (prop.name == "blue") v.color.b = (float)value * scale;
+                }
+
+                if (isVertex) {
+                    vertices.push_back(v);
+                } else if (isFace) {
+                    for (size_t k = 2; k < face.size(); k++) {
+                        indices.insert(indices.end(), { face[0], face[k - 1], face[k] });
+                    }
+                }
+            }
+        }
+
+        if (truncated) {
+            fprintf(stderr, "err: %s: ply data is truncated\n", path.c_str());
+            return false;
+        }
+
+        for (GLuint index : indices) {
+            if (index >= vertices.size()) {
+                fprintf(stderr, "err: %s: face references missing vertex\n", path.c_str());
+                return false;
+            }
+        }
+
+        if (!hasColor) {
+            colorByPosition(vertices);
+        }
+        return !indices.empty();
+    }
+};
+
+#endif // MESH_LOADER_H
@@ -0,0 +1,325 @@
+#ifndef MESH_POOL_H
+#define MESH_POOL_H
+
+#include "gl_buffer.h"
+#include "vertex_layout.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <vector>
+
+// offset allocator over a linear range. free blocks are kept sorted by offset so a released
+// block merges with the free neighbours on either side, allocation takes the first block that
+// fits.
+struct RangeAllocator {
+    static constexpr uint32_t none = ~0u;
+
+    std::map<uint32_t, uint32_t> blocks; // free blocks, offset -> size
+    uint32_t capacity = 0;
+    uint32_t used = 0;
+
+    void reset(uint32_t size)
+    {
+        blocks.clear();
+        capacity = size;
+        used = 0;
+        if (size > 0) {
+            blocks[0] = size;
+        }
+    }
+
+    // offset of `size` units aligned to `align`, or none when no free block fits
+    uint32_t allocate(uint32_t size, uint32_t align = 1)
+    {
+        for (auto it = blocks.begin(); it != blocks.end(); ++it) {
+            uint32_t offset = (it->first + align - 1) / align * align;
+            uint32_t pad = offset - it->first;
+            if (it->second < pad + size) {
+                continue;
+            }
+
+            uint32_t blockOffset = it->first;
+            uint32_t blockSize = it->second;
+            blocks.erase(it);
+            if (pad > 0) {
+                blocks[blockOffset] = pad;
+            }
+            if (blockSize > pad + size) {
+                blocks[offset + size] = blockSize - pad - size;
+            }
+
+            used += size;
+            return offset;
+        }
+        return none;
+    }
+
+    void release(uint32_t offset, uint32_t size)
+    {
+        used -= size;
+
+        auto next = blocks.lower_bound(offset);
+        if (next != blocks.end() && offset + size == next->first) {
+            size += next->second;
+            next = blocks.erase(next);
+        }
+
+        if (next != blocks.begin()) {
+            auto prev = std::prev(next);
+            if (prev->first + prev->second == offset) {
+                prev->second += size;
+                return;
+            }
+        }
+        blocks[offset] = size;
+    }
+
+    uint32_t available() const { return capacity - used; }
+
+    uint32_t largestBlock() const
+    {
+        uint32_t largest = 0;
+        for (const auto& block : blocks) {
+            largest = std::max(largest, block.second);
+        }
+        return largest;
+    }
+
+    // share of the free space outside the largest block, 0 when everything free is contiguous
+    float fragmentation() const
+    {
+        uint32_t free = available();
+        return free > 0 ? 1.0f - (float)largestBlock() / free : 0.0f;
+    }
+};
+
+using MeshHandle = uint32_t;
+inline constexpr MeshHandle meshNone = ~0u;
+
+// where a mesh lives in its pool, everything a draw needs besides the vao
+struct PoolRange {
+    GLint baseVertex = 0;
+    uint32_t vertexCount = 0;
+    GLintptr indexOffset = 0; // bytes into the element buffer
+    GLsizei indexCount = 0;
+    GLenum indexType = GL_UNSIGNED_INT;
+    GLenum mode = GL_TRIANGLES;
+    bool live = false;
+
+    uint32_t indexBytes() const { return indexCount * indexSize(indexType); }
+};
+
+// one vertex buffer and one element buffer shared by every mesh of a vertex format, attached to
+// a single vao. meshes are suballocated ranges drawn with a base vertex, so switching meshes of
+// the same format costs no binds. the buffers grow by relocating into larger ones, which packs
+// the live meshes and drops every hole on the way.
+struct MeshPool {
+    Vao vao { "mesh pool" };
+    Vbo vbo { GL_ARRAY_BUFFER, "mesh pool vertices" };
+    Ebo ebo { GL_ELEMENT_ARRAY_BUFFER, "mesh pool indices" };
+
+    GLsizei stride = 0;
+    void (*applyLayout)() = nullptr;
+
+    RangeAllocator vertices; // in vertices
+    RangeAllocator indices; // in bytes
+
+    std::vector<PoolRange> meshes;
+    std::vector<MeshHandle> freeHandles;
+
+    uint32_t growths = 0;
+    uint32_t defrags = 0;
+    uint64_t bytesMoved = 0;
+
+    template <typename V>
+    void init(uint32_t vertexCapacity, uint32_t indexCapacity)
+    {
+        stride = sizeof(V);
+        applyLayout = &applyVertexLayout<V>;
+        relocate(vertexCapacity, indexCapacity);
+    }
+
+    const PoolRange& operator[](MeshHandle handle) const { return meshes[handle]; }
+
+    uint32_t meshCount() const { return (uint32_t)(meshes.size() - freeHandles.size()); }
+
+    // copy a mesh into the pool, indices are relative to its own first vertex
+    MeshHandle add(const void* vertexData, uint32_t vertexCount, const void* indexData, GLenum indexType, GLsizei indexCount, GLenum mode = GL_TRIANGLES)
+    {
+        if (vertexCount == 0 || indexCount <= 0) {
+            fprintf(stderr, "err: mesh pool cannot hold an empty mesh\n");
+            return meshNone;
+        }
+
+        uint32_t align = indexSize(indexType);
+        uint32_t indexBytes = indexCount * align;
+
+        uint32_t baseVertex, indexOffset;
+        bool compacted = false;
+        while (true) {
+            baseVertex = vertices.allocate(vertexCount);
+            indexOffset = indices.allocate(indexBytes, align);
+            if (baseVertex != RangeAllocator::none && indexOffset != RangeAllocator::none) {
+                break;
+            }
+
+            if (baseVertex != RangeAllocator::none) {
+                vertices.release(baseVertex, vertexCount);
+            }
+            if (indexOffset != RangeAllocator::none) {
+                indices.release(indexOffset, indexBytes);
+            }
+
+            // compacting is enough when the free space is only split up, otherwise grow
+            bool fits = vertices.available() >= vertexCount && indices.available() >= indexBytes + align;
+            if (fits && !compacted) {
+                defragment();
+                compacted = true;
+            } else {
+                growths++;
+                relocate(std::max(vertices.capacity * 2, vertices.used + vertexCount),
+                    std::max(indices.capacity * 2, indices.used + indexBytes + align));
+            }
+        }
+
+        glBindBuffer(GL_COPY_WRITE_BUFFER, vbo.id);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, (GLintptr)baseVertex * stride, (GLsizeiptr)vertexCount * stride, vertexData);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, ebo.id);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, indexOffset, indexBytes, indexData);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+        MeshHandle handle;
+        if (freeHandles.empty()) {
+            handle = (MeshHandle)meshes.size();
+            meshes.emplace_back();
+        } else {
+            handle = freeHandles.back();
+            freeHandles.pop_back();
+        }
+
+        PoolRange& range = meshes[handle];
+        range.baseVertex = (GLint)baseVertex;
+        range.vertexCount = vertexCount;
+        range.indexOffset = indexOffset;
+        range.indexCount = indexCount;
+        range.indexType = indexType;
+        range.mode = mode;
+        range.live = true;
+        return handle;
+    }
+
+    void remove(MeshHandle handle)
+    {
+        if (handle >= meshes.size() || !meshes[handle].live) {
+            return;
+        }
+
+        PoolRange& range = meshes[handle];
+        vertices.release(range.baseVertex, range.vertexCount);
+        indices.release((uint32_t)range.indexOffset, range.indexBytes());
+        range.live = false;
+        freeHandles.push_back(handle);
+    }
+
+    // overwrite `count` vertices of a mesh starting at `first`
+    void writeVertices(MeshHandle handle, uint32_t first, const void* data, uint32_t count)
+    {
+        if (handle >= meshes.size() || !meshes[handle].live || first + count > meshes[handle].vertexCount) {
+            fprintf(stderr, "err: mesh pool vertex write out of range\n");
+            return;
+        }
+
+        glBindBuffer(GL_COPY_WRITE_BUFFER, vbo.id);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, (GLintptr)(meshes[handle].baseVertex + first) * stride, (GLsizeiptr)count * stride, data);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+
+    // pack every live mesh to the front of fresh buffers of the same size
+    void defragment()
+    {
+        defrags++;
+        relocate(vertices.capacity, indices.capacity);
+    }
+
+    // move into new buffers of the given capacity, live meshes are copied on the gpu in handle
+    // order and keep their handles. draws already queued keep reading the old storage.
+    void relocate(uint32_t vertexCapacity, uint32_t indexCapacity)
+    {
+        // room for every live mesh even when alignment padding adds up differently
+        uint32_t vertexNeeded = 0, indexNeeded = 0;
+        for (const PoolRange& range : meshes) {
+            if (range.live) {
+                vertexNeeded += range.vertexCount;
+                indexNeeded += range.indexBytes() + indexSize(range.indexType) - 1;
+            }
+        }
+        vertexCapacity = std::max(vertexCapacity, vertexNeeded);
+        indexCapacity = std::max(indexCapacity, indexNeeded);
+
+        Vbo nextVbo(GL_ARRAY_BUFFER, "mesh pool vertices");
+        Ebo nextEbo(GL_ELEMENT_ARRAY_BUFFER, "mesh pool indices");
+
+        glBindBuffer(GL_COPY_WRITE_BUFFER, nextVbo.id);
+        glBufferData(GL_COPY_WRITE_BUFFER, (GLsizeiptr)vertexCapacity * stride, nullptr, GL_STATIC_DRAW);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, nextEbo.id);
+        glBufferData(GL_COPY_WRITE_BUFFER, indexCapacity, nullptr, GL_STATIC_DRAW);
+
+        vertices.reset(vertexCapacity);
+        indices.reset(indexCapacity);
+
+        for (PoolRange& range : meshes) {
+            if (!range.live) {
+                continue;
+            }
+
+            uint32_t align = indexSize(range.indexType);
+            uint32_t baseVertex = vertices.allocate(range.vertexCount);
+            uint32_t indexOffset = indices.allocate(range.indexBytes(), align);
+
+            glBindBuffer(GL_COPY_READ_BUFFER, vbo.id);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, nextVbo.id);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, (GLintptr)range.baseVertex * stride, (GLintptr)baseVertex * stride, (GLsizeiptr)range.vertexCount * stride);
+
+            glBindBuffer(GL_COPY_READ_BUFFER, ebo.id);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, nextEbo.id);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, range.indexOffset, indexOffset, range.indexBytes());
+
+            bytesMoved += (uint64_t)range.vertexCount * stride + range.indexBytes();
+            range.baseVertex = (GLint)baseVertex;
+            range.indexOffset = indexOffset;
+        }
+
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+        // the old buffers are deleted when the locals go out of scope
+        std::swap(vbo, nextVbo);
+        std::swap(ebo, nextEbo);
+
+        // instance attributes on the vao stay as they are
+        vao.bind();
+        vbo.bind();
+        applyLayout();
+        ebo.bind();
+        vao.unbind();
+        vbo.unbind();
+    }
+};
+
+// one pool per vertex format
+struct MeshPools {
+    MeshPool pools[3];
+
+    void init()
+    {
+        pools[VertexFormatFloat].init<Vertex>(1 << 16, 1 << 18);
+        pools[VertexFormatSnorm16].init<VertexSnorm16>(1 << 16, 1 << 18);
+        pools[VertexFormatHalf].init<VertexHalf>(1 << 16, 1 << 18);
+    }
+
+    MeshPool& operator[](VertexFormat format) { return pools[format]; }
+};
+
+#endif // MESH_POOL_H
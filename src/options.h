@@ -0,0 +1,297 @@
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+// command line options, everything except --bench only affects the scene setup
+struct Options {
+    bool bench = false;
+    int frames = 600;
+    int warmup = 60;
+    int width = 1280;
+    int height = 720;
+    std::string out = "bench.json";
+    std::string trace;
+    std::string pack;
+    std::string mesh;
+    std::string shaderCache = ".shader_cache"; // empty disables the program binary cache
+    std::string record; // input log written while running interactively
+    std::string replay; // input log driving a headless run, implies --bench
+    std::string screenshot; // bench: png of the last frame
+    std::string capture; // bench: directory receiving every measured frame
+    int captureFormat = 0; // CaptureFormat of --capture
+    bool dynamicRes = false; // scale the scene resolution to hold --frame-budget
+    float frameBudget = 16.6f;
+    float minScale = 0.5f;
+    int upscale = 0; // UpscaleFilter
+
+    // scene scale, 0 keeps the mode's default
+    int objects = 0;
+    int gridSize = 20;
+    float gridSpacing = 20.0f;
+    bool dense = false;
+    bool gpuAnim = false;
+    bool noCull = false;
+    bool gpuCull = false; // cull and draw through compute and multi draw indirect when supported
+    float lodDistance = 2000.0f; // gpu culling: distance covered by each dense mesh lod, 0 disables lods
+    int vertexFormat = 0; // VertexFormat of the dense mesh
+    int gridMode = 1; // GridMode, procedural unless the line reference is requested
+    int simd = -1; // SimdLevel cap for the math kernels, -1 uses the best available
+    bool simdCheck = false;
+    bool serialUpdate = false; // run the update stage inline instead of on its own thread
+    int jobs = -1; // job pool workers, -1 leaves one hardware thread to the caller
+    bool jobsInline = false; // every job runs on the thread that spawned it
+    int pacing = -1; // PacingMode, -1 is vsync interactively and unlimited for --bench
+    double fps = 60.0; // target of the capped pacing mode
+    bool idle = false; // bench: still camera and no animation, what an idle viewer draws
+    double inputRate = 10.0; // bench: synthetic input events per second for the latency numbers
+
+    bool parse(int argc, char** argv)
+    {
+        for (int i = 1; i < argc; i++) {
+            const char* arg = argv[i];
+            const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+
+            auto needValue = [&]() {
+                if (!value) {
+                    fprintf(stderr, "err: %s expects a value\n", arg);
+                    return false;
+                }
+                i++;
+                return true;
+            };
+
+            if (!strcmp(arg, "--bench")) {
+                bench = true;
+            } else if (!strcmp(arg, "--dense")) {
+                dense = true;
+            } else if (!strcmp(arg, "--gpu-anim")) {
+                gpuAnim = true;
+            } else if (!strcmp(arg, "--no-cull")) {
+                noCull = true;
+            } else if (!strcmp(arg, "--gpu-cull")) {
+                gpuCull = true;
+            } else if (!strcmp(arg, "--lod-distance")) {
+                if (!needValue()) return false;
+                lodDistance = (float)atof(value);
+            } else if (!strcmp(arg, "--vertex-format")) {
+                if (!needValue()) return false;
+                if (!strcmp(value, "float")) {
+                    vertexFormat = 0;
+                } else if (!strcmp(value, "snorm16")) {
+                    vertexFormat = 1;
+                } else if (!strcmp(value, "half")) {
+                    vertexFormat = 2;
+                } else {
+                    fprintf(stderr, "err: unknown vertex format %s\n", value);
+                    return false;
+                }
+            } else if (!strcmp(arg, "--grid-mode")) {
+                if (!needValue()) return false;
+                if (!strcmp(value, "lines")) {
+                    gridMode = 0;
+                } else if (!strcmp(value, "procedural")) {
+                    gridMode = 1;
+                } else {
+                    fprintf(stderr, "err: unknown grid mode %s\n", value);
+                    return false;
+                }
+            } else if (!strcmp(arg, "--simd")) {
+                if (!needValue()) return false;
+                if (!strcmp(value, "scalar")) {
+                    simd = 0;
+                } else if (!strcmp(value, "sse")) {
+                    simd = 1;
+                } else if (!strcmp(value, "avx2")) {
+                    simd = 2;
+                } else {
+                    fprintf(stderr, "err: unknown simd level %s\n", value);
+                    return false;
+                }
+            } else if (!strcmp(arg, "--pacing")) {
+                if (!needValue()) return false;
+                if (!strcmp(value, "vsync")) {
+                    pacing = 0;
+                } else if (!strcmp(value, "unlimited")) {
+                    pacing = 1;
+                } else if (!strcmp(value, "capped")) {
+                    pacing = 2;
+                } else if (!strcmp(value, "on-demand")) {
+                    pacing = 3;
+                } else {
+                    fprintf(stderr, "err: unknown pacing mode %s\n", value);
+                    return false;
+                }
+            } else if (!strcmp(arg, "--fps")) {
+                if (!needValue()) return false;
+                fps = atof(value);
+            } else if (!strcmp(arg, "--input-rate")) {
+                if (!needValue()) return false;
+                inputRate = atof(value);
+            } else if (!strcmp(arg, "--idle")) {
+                idle = true;
+            } else if (!strcmp(arg, "--serial-update")) {
+                serialUpdate = true;
+            } else if (!strcmp(arg, "--jobs")) {
+                if (!needValue()) return false;
+                jobs = atoi(value);
+            } else if (!strcmp(arg, "--jobs-inline")) {
+                jobsInline = true;
+            } else if (!strcmp(arg, "--simd-check")) {
+                simdCheck = true;
+            } else if (!strcmp(arg, "--frames")) {
+                if (!needValue()) return false;
+                frames = atoi(value);
+            } else if (!strcmp(arg, "--warmup")) {
+                if (!needValue()) return false;
+                warmup = atoi(value);
+            } else if (!strcmp(arg, "--width")) {
+                if (!needValue()) return false;
+                width = atoi(value);
+            } else if (!strcmp(arg, "--height")) {
+                if (!needValue()) return false;
+                height = atoi(value);
+            } else if (!strcmp(arg, "--out")) {
+                if (!needValue()) return false;
+                out = value;
+            } else if (!strcmp(arg, "--pack")) {
+                if (!needValue()) return false;
+                pack = value;
+            } else if (!strcmp(arg, "--shader-cache")) {
+                if (!needValue()) return false;
+                shaderCache = value;
+            } else if (!strcmp(arg, "--no-shader-cache")) {
+                shaderCache.clear();
+            } else if (!strcmp(arg, "--mesh")) {
+                if (!needValue()) return false;
+                mesh = value;
+            } else if (!strcmp(arg, "--record")) {
+                if (!needValue()) return false;
+                record = value;
+            } else if (!strcmp(arg, "--replay")) {
+                if (!needValue()) return false;
+                replay = value;
+            } else if (!strcmp(arg, "--screenshot")) {
+                if (!needValue()) return false;
+                screenshot = value;
+            } else if (!strcmp(arg, "--capture")) {
+                if (!needValue()) return false;
+                capture = value;
+            } else if (!strcmp(arg, "--capture-format")) {
+                if (!needValue()) return false;
+                if (!strcmp(value, "png")) {
+                    captureFormat = 0;
+                } else if (!strcmp(value, "raw")) {
+                    captureFormat = 1;
+                } else {
+                    fprintf(stderr, "err: unknown capture format %s\n", value);
+                    return false;
+                }
+            } else if (!strcmp(arg, "--dynamic-res")) {
+                dynamicRes = true;
+            } else if (!strcmp(arg, "--frame-budget")) {
+                if (!needValue()) return false;
+                frameBudget = (float)atof(value);
+            } else if (!strcmp(arg, "--min-scale")) {
+                if (!needValue()) return false;
+                minScale = (float)atof(value);
+            } else if (!strcmp(arg, "--upscale")) {
+                if (!needValue()) return false;
+                if (!strcmp(value, "bilinear")) {
+                    upscale = 0;
+                } else if (!strcmp(value, "sharpen")) {
+                    upscale = 1;
+                } else {
+                    fprintf(stderr, "err: unknown upscale filter %s\n", value);
+                    return false;
+                }
+            } else if (!strcmp(arg, "--trace")) {
+                if (!needValue()) return false;
+                trace = value;
+            } else if (!strcmp(arg, "--objects")) {
+                if (!needValue()) return false;
+                objects = atoi(value);
+            } else if (!strcmp(arg, "--grid")) {
+                if (!needValue()) return false;
+                gridSize = atoi(value);
+            } else if (!strcmp(arg, "--grid-spacing")) {
+                if (!needValue()) return false;
+                gridSpacing = (float)atof(value);
+            } else if (!strcmp(arg, "--help") || !strcmp(arg, "-h")) {
+                usage(argv[0]);
+                exit(EXIT_SUCCESS);
+            } else {
+                fprintf(stderr, "err: unknown option %s\n", arg);
+                usage(argv[0]);
+                return false;
+            }
+        }
+
+        if (frames <= 0 || warmup < 0 || width <= 0 || height <= 0 || objects < 0 || gridSize < 0 || lodDistance < 0.0f || fps <= 0.0 || inputRate <= 0.0 || frameBudget <= 0.0f) {
+            fprintf(stderr, "err: numeric options must be positive\n");
+            return false;
+        }
+
+        if (minScale <= 0.0f || minScale > 1.0f) {
+            fprintf(stderr, "err: --min-scale must be in (0, 1]\n");
+            return false;
+        }
+
+        if (!record.empty() && (bench || !replay.empty())) {
+            fprintf(stderr, "err: --record needs an interactive window\n");
+            return false;
+        }
+
+        return true;
+    }
+
+    static void usage(const char* program)
+    {
+        fprintf(stderr,
+            "usage: %s [options]\n"
+            "  --bench              render a scripted scene offscreen and write timings as json\n"
+            "  --frames N           measured frames in bench mode (600)\n"
+            "  --warmup N           frames rendered before measuring (60)\n"
+            "  --width N --height N offscreen framebuffer size (1280x720)\n"
+            "  --out PATH           bench result file (bench.json)\n"
+            "  --trace PATH         write a chrome trace of the measured bench frames\n"
+            "  --record PATH        log mouse, keys and widget changes on a fixed clock for --replay\n"
+            "  --replay PATH        drive a headless bench from an input log, per-frame timings in --out\n"
+            "  --screenshot PATH    bench: save the last frame as png\n"
+            "  --capture DIR        bench: save every measured frame into DIR\n"
+            "  --capture-format F   png files or one raw rgba8 file (png)\n"
+            "  --dynamic-res        render the scene below native resolution when frames run over budget\n"
+            "  --frame-budget MS    frame time dynamic resolution holds (16.6)\n"
+            "  --min-scale F        lowest dynamic resolution scale (0.5)\n"
+            "  --upscale F          bilinear blit or sharpen pass to the output (bilinear)\n"
+            "  --pack PATH          load shaders and meshes from a cooked asset pack\n"
+            "  --mesh NAME|PATH     dense mesh from the pack, or an .obj/.ply parsed at startup\n"
+            "  --shader-cache DIR   program binary cache directory (.shader_cache)\n"
+            "  --no-shader-cache    always compile shaders from source\n"
+            "  --objects N          pyramid instances (1, bench: 1000)\n"
+            "  --grid N             grid lines per side of the origin (20)\n"
+            "  --grid-spacing F     distance between grid lines (20)\n"
+            "  --grid-mode M        grid drawn as procedural or lines geometry (procedural)\n"
+            "  --dense              draw the vertex-heavy sphere instead of the pyramid\n"
+            "  --gpu-anim           rotate per vertex in the shader instead of per instance\n"
+            "  --no-cull            submit every object instead of frustum culling them\n"
+            "  --gpu-cull           cull in a compute shader and draw with multi draw indirect (GL 4.3)\n"
+            "  --lod-distance F     gpu culling: distance covered by each sphere lod, 0 disables lods (2000)\n"
+            "  --vertex-format F    dense mesh vertex format: float, snorm16 or half (float)\n"
+            "  --simd L             cap the math kernels at scalar, sse or avx2 (best available)\n"
+            "  --pacing M           vsync, unlimited, capped or on-demand (vsync, bench: unlimited)\n"
+            "  --fps N              frame rate of the capped pacing mode (60)\n"
+            "  --idle               bench a still scene, no camera orbit or animation\n"
+            "  --input-rate HZ      synthetic input events per second in bench mode (10)\n"
+            "  --serial-update      run the scene update on the render thread instead of overlapping it\n"
+            "  --jobs N             worker threads of the job pool, 0 runs jobs on the waiting thread (cores - 1)\n"
+            "  --jobs-inline        run every job where it is spawned, in order, for deterministic repros\n"
+            "  --simd-check         compare every math kernel level against glm and exit\n",
+            program);
+    }
+};
+
+#endif // OPTIONS_H
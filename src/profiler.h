@@ -0,0 +1,371 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#define GLAD_IMPLEMENTATION
+#include "glad/glad.h"
+
+#include "gl_resources.h"
+
+#include "imgui.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// nestable cpu scopes plus flat gpu scopes measured with GL_TIME_ELAPSED queries. gpu results
+// are read back `gpuLatency` frames later and dropped if still not available, so collecting
+// them never stalls the pipeline.
+struct Profiler {
+    static constexpr int gpuLatency = 4;
+    static constexpr int historySize = 240;
+
+    struct Event {
+        const char* name;
+        double startUs;
+        double endUs;
+        int depth;
+    };
+
+    struct GpuQuery {
+        const char* name;
+        double cpuStartUs;
+        GLuint query;
+    };
+
+    struct Frame {
+        double startUs = 0.0;
+        double endUs = 0.0;
+        std::vector<Event> cpu;
+    };
+
+    std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+    uint64_t frameIndex = 0;
+    int depth = 0;
+
+    // open push() scopes: cpu event index and whether a gpu query was started
+    std::vector<std::pair<int, bool>> stack;
+
+    Frame current;
+    Frame last;
+    std::vector<Event> lastGpu; // resolved gpu scopes, gpuLatency frames old
+
+    // gpu queries issued per frame slot, reused once their results were collected
+    std::vector<GpuQuery> pending[gpuLatency];
+    std::vector<GLuint> freeQueries;
+    bool gpuActive = false;
+    uint64_t gpuDropped = 0;
+
+    float history[historySize] {};
+    int historyHead = 0;
+
+    // chrome trace capture
+    bool capturing = false;
+    int captureFramesLeft = 0;
+    std::string capturePath;
+    std::vector<Event> captureCpu;
+    std::vector<Event> captureGpu;
+
+    ~Profiler() { release(); }
+
+    double nowUs() const
+    {
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - epoch).count();
+    }
+
+    void beginFrame()
+    {
+        current.cpu.clear();
+        current.startUs = nowUs();
+        depth = 0;
+        stack.clear();
+        collectGpu();
+    }
+
+    void endFrame()
+    {
+        current.endUs = nowUs();
+
+        history[historyHead] = (float)((current.endUs - current.startUs) / 1000.0);
+        historyHead = (historyHead + 1) % historySize;
+
+        if (capturing) {
+            captureCpu.push_back({ "Frame", current.startUs, current.endUs, 0 });
+            for (const auto& e : current.cpu) {
+                captureCpu.push_back({ e.name, e.startUs, e.endUs, e.depth + 1 });
+            }
+
+            if (--captureFramesLeft <= 0) {
+                capturing = false;
+                writeTrace(capturePath);
+            }
+        }
+
+        std::swap(last, current);
+        frameIndex++;
+    }
+
+    int beginCpu(const char* name)
+    {
+        current.cpu.push_back({ name, nowUs(), 0.0, depth++ });
+        return (int)current.cpu.size() - 1;
+    }
+
+    void endCpu(int index)
+    {
+        current.cpu[index].endUs = nowUs();
+        depth--;
+    }
+
+    // begin a scope that ends at the matching pop(), for code that is not block structured
+    void push(const char* name, bool timeGpu = false)
+    {
+        int index = beginCpu(name);
+        stack.emplace_back(index, timeGpu && beginGpu(name));
+    }
+
+    void pop()
+    {
+        auto [index, gpu] = stack.back();
+        stack.pop_back();
+
+        if (gpu) {
+            endGpu();
+        }
+        endCpu(index);
+    }
+
+    // time elapsed queries cannot nest, a gpu scope inside another one is not measured
+    bool beginGpu(const char* name)
+    {
+        if (gpuActive) {
+            return false;
+        }
+
+        GLuint query = 0;
+        if (!freeQueries.empty()) {
+            query = freeQueries.back();
+            freeQueries.pop_back();
+        } else {
+            glGenQueries(1, &query);
+            GlResources::name(GlResourceQuery, query, "profiler timer");
+        }
+
+        glBeginQuery(GL_TIME_ELAPSED, query);
+        pending[frameIndex % gpuLatency].push_back({ name, nowUs(), query });
+        gpuActive = true;
+        return true;
+    }
+
+    void endGpu()
+    {
+        glEndQuery(GL_TIME_ELAPSED);
+        gpuActive = false;
+    }
+
+    // results of the frame that used this slot gpuLatency frames ago
+    void collectGpu()
+    {
+        auto& slot = pending[frameIndex % gpuLatency];
+        if (slot.empty()) {
+            return;
+        }
+
+        // queries complete in order, so the last one being ready means all of them are
+        GLint available = 0;
+        glGetQueryObjectiv(slot.back().query, GL_QUERY_RESULT_AVAILABLE, &available);
+
+        if (available) {
+            lastGpu.clear();
+            for (const auto& q : slot) {
+                GLuint64 ns = 0;
+                glGetQueryObjectui64v(q.query, GL_QUERY_RESULT, &ns);
+                lastGpu.push_back({ q.name, q.cpuStartUs, q.cpuStartUs + ns / 1000.0, 0 });
+            }
+
+            if (capturing) {
+                captureGpu.insert(captureGpu.end(), lastGpu.begin(), lastGpu.end());
+            }
+        } else {
+            gpuDropped += slot.size();
+        }
+
+        for (const auto& q : slot) {
+            freeQueries.push_back(q.query);
+        }
+        slot.clear();
+    }
+
+    // gpu time of the last resolved frame over every scope. tilers and software rasterizers run
+    // the work of earlier scopes when a later one needs their result, only the sum is reliable.
+    double gpuFrameMs() const
+    {
+        double total = 0.0;
+        for (const auto& e : lastGpu) {
+            total += e.endUs - e.startUs;
+        }
+        return total / 1000.0;
+    }
+
+    void startCapture(const std::string& path, int frames)
+    {
+        capturing = true;
+        captureFramesLeft = frames;
+        capturePath = path;
+        captureCpu.clear();
+        captureGpu.clear();
+    }
+
+    // chrome://tracing / perfetto json, cpu scopes on thread 1 and gpu scopes on thread 2.
+    // gpu scopes start at the cpu time they were issued, only their duration is measured.
+    bool writeTrace(const std::string& path) const
+    {
+        FILE* file = fopen(path.c_str(), "w");
+        if (!file) {
+            fprintf(stderr, "err: failed to open trace output: %s\n", path.c_str());
+            return false;
+        }
+
+        fprintf(file, "{\"traceEvents\":[\n");
+        fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}},\n");
+        fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}");
+
+        for (const auto& e : captureCpu) {
+            fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}", e.name, e.startUs, e.endUs - e.startUs);
+        }
+
+        for (const auto& e : captureGpu) {
+            fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":2,\"ts\":%.3f,\"dur\":%.3f}", e.name, e.startUs, e.endUs - e.startUs);
+        }
+
+        fprintf(file, "\n]}\n");
+        fclose(file);
+
+        printf("profiler: wrote %s\n", path.c_str());
+        return true;
+    }
+
+    static ImU32 colorFor(const char* name)
+    {
+        uint32_t h = 2166136261u;
+        for (const char* c = name; *c; c++) {
+            h = (h ^ (uint8_t)*c) * 16777619u;
+        }
+        return IM_COL32(80 + (h & 0x7f), 80 + ((h >> 8) & 0x7f), 80 + ((h >> 16) & 0x7f), 255);
+    }
+
+    // one row per nesting depth, scaled to the duration of the last frame
+    static void drawTimeline(const std::vector<Event>& events, double startUs, double spanUs, int rows, const char* id)
+    {
+        const float rowHeight = ImGui::GetFontSize() + 4.0f;
+        const float width = ImGui::GetContentRegionAvail().x;
+        const ImVec2 origin = ImGui::GetCursorScreenPos();
+
+        ImGui::InvisibleButton(id, ImVec2(width, rowHeight * rows));
+        ImDrawList* dl = ImGui::GetWindowDrawList();
+        dl->AddRectFilled(origin, ImVec2(origin.x + width, origin.y + rowHeight * rows), IM_COL32(30, 30, 30, 255));
+
+        const ImVec2 mouse = ImGui::GetIO().MousePos;
+        for (const auto& e : events) {
+            float x0 = origin.x + (float)((e.startUs - startUs) / spanUs) * width;
+            float x1 = origin.x + (float)((e.endUs - startUs) / spanUs) * width;
+            float y0 = origin.y + e.depth * rowHeight;
+            x1 = std::max(x1, x0 + 1.0f);
+
+            dl->AddRectFilled(ImVec2(x0, y0), ImVec2(x1, y0 + rowHeight - 1.0f), colorFor(e.name));
+            dl->PushClipRect(ImVec2(x0, y0), ImVec2(x1, y0 + rowHeight), true);
+            dl->AddText(ImVec2(x0 + 2.0f, y0 + 2.0f), IM_COL32(255, 255, 255, 255), e.name);
+            dl->PopClipRect();
+
+            if (mouse.x >= x0 && mouse.x < x1 && mouse.y >= y0 && mouse.y < y0 + rowHeight) {
+                ImGui::SetTooltip("%s: %.3f ms", e.name, (e.endUs - e.startUs) / 1000.0);
+            }
+        }
+    }
+
+    void drawPanel()
+    {
+        if (!ImGui::Begin("Profiler")) {
+            ImGui::End();
+            return;
+        }
+
+        double spanUs = std::max(1.0, last.endUs - last.startUs);
+        ImGui::Text("Frame %.3f ms", spanUs / 1000.0);
+        ImGui::PlotLines("##FrameTimes", history, historySize, historyHead, nullptr, 0.0f, 50.0f, ImVec2(-1.0f, 50.0f));
+
+        int rows = 1;
+        for (const auto& e : last.cpu) {
+            rows = std::max(rows, e.depth + 1);
+        }
+
+        ImGui::TextUnformatted("CPU");
+        drawTimeline(last.cpu, last.startUs, spanUs, rows, "##CpuTimeline");
+
+        // gpu scopes are drawn back to back since only their durations are known
+        double gpuTotal = 0.0;
+        std::vector<Event> gpu;
+        for (const auto& e : lastGpu) {
+            double duration = e.endUs - e.startUs;
+            gpu.push_back({ e.name, gpuTotal, gpuTotal + duration, 0 });
+            gpuTotal += duration;
+        }
+
+        ImGui::Text("GPU %.3f ms (%d frames late, %llu dropped)", gpuTotal / 1000.0, gpuLatency, (unsigned long long)gpuDropped);
+        drawTimeline(gpu, 0.0, std::max(spanUs, gpuTotal), 1, "##GpuTimeline");
+
+        if (ImGui::BeginTable("##Scopes", 2, ImGuiTableFlags_RowBg)) {
+            for (const auto& e : last.cpu) {
+                ImGui::TableNextColumn();
+                ImGui::Text("%*s%s", e.depth * 2, "", e.name);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f ms", (e.endUs - e.startUs) / 1000.0);
+            }
+            ImGui::EndTable();
+        }
+
+        if (capturing) {
+            ImGui::Text("Capturing trace, %d frames left", captureFramesLeft);
+        } else if (ImGui::Button("Capture Chrome trace (120 frames)")) {
+            startCapture("trace.json", 120);
+        }
+
+        ImGui::End();
+    }
+
+    void release()
+    {
+        for (auto& slot : pending) {
+            for (const auto& q : slot) {
+                freeQueries.push_back(q.query);
+            }
+            slot.clear();
+        }
+
+        if (!freeQueries.empty()) {
+            glDeleteQueries((GLsizei)freeQueries.size(), freeQueries.data());
+            freeQueries.clear();
+        }
+    }
+};
+
+// cpu scope, optionally also timed on the gpu
+struct ProfileScope {
+    Profiler& profiler;
+
+    ProfileScope(Profiler& p, const char* name, bool timeGpu = false)
+        : profiler(p)
+    {
+        profiler.push(name, timeGpu);
+    }
+
+    ~ProfileScope() { profiler.pop(); }
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(profiler, name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(profiler, name)
+#define PROFILE_SCOPE_GPU(profiler, name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(profiler, name, true)
+
+#endif // PROFILER_H
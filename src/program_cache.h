@@ -0,0 +1,174 @@
+#ifndef PROGRAM_CACHE_H
+#define PROGRAM_CACHE_H
+
+#define GLAD_IMPLEMENTATION
+#include "glad/glad.h"
+
+#include "file.h"
+
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// on-disk cache of linked program binaries (glGetProgramBinary). entries are keyed by the
+// final shader sources, including injected defines, and the driver identification strings,
+// so a driver update or an edited shader simply misses. a binary the driver rejects is
+// deleted and the program is compiled from source again.
+struct ProgramCache {
+    struct FileHeader {
+        uint32_t magic;
+        uint32_t format;
+        uint64_t key;
+        uint64_t length;
+    };
+
+    static constexpr uint32_t fileMagic = 0x42504350; // "PCPB"
+
+    std::string directory;
+    std::string driver;
+    bool enabled = false;
+
+    int hits = 0;
+    int misses = 0;
+    int rejected = 0;
+
+    // needs a current context, disabled when the driver offers no binary formats
+    bool init(const std::string& dir)
+    {
+        directory = dir;
+        enabled = false;
+
+        if (!GLAD_GL_ARB_get_program_binary) {
+            return false;
+        }
+
+        GLint formats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        if (formats <= 0) {
+            return false;
+        }
+
+        std::error_code ec;
+        std::filesystem::create_directories(directory, ec);
+        if (ec) {
+            fprintf(stderr, "err: failed to create shader cache directory %s: %s\n", directory.c_str(), ec.message().c_str());
+            return false;
+        }
+
+        driver = std::string((const char*)glGetString(GL_VENDOR)) + "\n" + (const char*)glGetString(GL_RENDERER) + "\n"
+            + (const char*)glGetString(GL_VERSION);
+        enabled = true;
+        return true;
+    }
+
+    // FNV-1a over the driver strings and every stage source
+    uint64_t key(const std::string& vert, const std::string& frag) const
+    {
+        uint64_t h = 14695981039346656037ull;
+        auto mix = [&](const std::string& s) {
+            for (unsigned char c : s) {
+                h = (h ^ c) * 1099511628211ull;
+            }
+            h = (h ^ 0xff) * 1099511628211ull; // separator so "ab"+"c" != "a"+"bc"
+        };
+
+        mix(driver);
+        mix(vert);
+        mix(frag);
+        return h;
+    }
+
+    std::string path(uint64_t key) const
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "%016" PRIx64 ".bin", key);
+        return (std::filesystem::path(directory) / name).string();
+    }
+
+    // links `program` from a cached binary, false on a miss or when the driver rejects it
+    bool load(uint64_t key, GLuint program)
+    {
+        if (!enabled) {
+            return false;
+        }
+
+        auto data = File::readFile(path(key));
+        FileHeader header {};
+        if (!data.has_value() || data->size() < sizeof(header)) {
+            misses++;
+            return false;
+        }
+
+        memcpy(&header, data->data(), sizeof(header));
+        if (header.magic != fileMagic || header.key != key || header.length != data->size() - sizeof(header)) {
+            misses++;
+            return false;
+        }
+
+        glProgramBinary(program, header.format, data->data() + sizeof(header), (GLsizei)header.length);
+
+        GLint linked = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if (!linked) {
+            rejected++;
+            std::error_code ec;
+            std::filesystem::remove(path(key), ec);
+            return false;
+        }
+
+        hits++;
+        return true;
+    }
+
+    // expects GL_PROGRAM_BINARY_RETRIEVABLE_HINT to have been set before linking
+    void store(uint64_t key, GLuint program) const
+    {
+        if (!enabled) {
+            return;
+        }
+
+        GLint length = 0;
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0) {
+            return;
+        }
+
+        std::vector<uint8_t> data(sizeof(FileHeader) + length);
+        FileHeader header { fileMagic, 0, key, 0 };
+
+        GLsizei written = 0;
+        glGetProgramBinary(program, length, &written, &header.format, data.data() + sizeof(FileHeader));
+        if (written <= 0) {
+            return;
+        }
+
+        header.length = (uint64_t)written;
+        memcpy(data.data(), &header, sizeof(header));
+
+        // written under a temporary name so a concurrent reader never sees a partial file
+        std::string target = path(key);
+        std::string temp = target + ".tmp";
+        FILE* file = fopen(temp.c_str(), "wb");
+        if (!file) {
+            fprintf(stderr, "err: failed to write shader cache entry %s\n", temp.c_str());
+            return;
+        }
+
+        bool ok = fwrite(data.data(), sizeof(FileHeader) + written, 1, file) == 1;
+        ok &= fclose(file) == 0;
+
+        std::error_code ec;
+        if (ok) {
+            std::filesystem::rename(temp, target, ec);
+        }
+        if (!ok || ec) {
+            std::filesystem::remove(temp, ec);
+        }
+    }
+};
+
+#endif // PROGRAM_CACHE_H
@@ -0,0 +1,231 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#define GLAD_IMPLEMENTATION
+#include "glad/glad.h"
+
+#include "gl_state.h"
+#include "shader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <type_traits>
+#include <vector>
+
+enum RenderPass : uint8_t {
+    RenderPassOpaque,
+    RenderPassBlended, // after every opaque draw, back to front
+};
+
+// one draw with everything needed to issue it, uniforms live in the queue's pool
+struct RenderCommand {
+    uint64_t key = 0;
+    GLuint program = 0;
+    GLuint vao = 0;
+    GLenum mode = GL_TRIANGLES;
+    GLenum indexType = 0; // 0 draws arrays
+    GLsizei count = 0;
+    GLsizei instances = 1;
+    GLintptr offset = 0; // first vertex, or byte offset into the element buffer
+    GLint baseVertex = 0; // added to every index
+    GLuint indirect = 0; // draws `count` records of this buffer from `offset` instead
+    GLuint instanceBuffer = 0; // where the instance attributes read from, 0 leaves them as they are
+    GLintptr instanceOffset = 0;
+    uint32_t uniformFirst = 0;
+    uint16_t uniformCount = 0;
+    bool blend = false;
+};
+
+struct RenderQueueStats {
+    uint32_t draws = 0;
+    uint64_t bindsRequested = 0;
+    uint64_t bindsFiltered = 0;
+    uint64_t uniformsRequested = 0;
+    uint64_t uniformsFiltered = 0;
+    double sortMs = 0.0;
+};
+
+// draws are collected during the frame, sorted by a 64-bit key and issued through a state cache.
+//
+// opaque:  pass:2 | program:12 | vao:12 | material:14 | depth:24
+// blended: pass:2 | far-to-near depth:24 | program:12 | vao:12 | material:14
+//
+// opaque draws group by state first and go front to back within a group, switching programs
+// costs more than the overdraw early-z saves between groups.
+struct RenderQueue {
+    struct UniformWrite {
+        GLint location;
+        UniformKind kind;
+        float data[16];
+    };
+
+    struct SortItem {
+        uint64_t key;
+        uint32_t index;
+    };
+
+    std::vector<RenderCommand> commands;
+    std::vector<UniformWrite> uniformPool;
+    std::vector<SortItem> items;
+    std::vector<SortItem> scratch;
+
+    RenderQueueStats stats;
+
+    // depth is the view distance, quantized against `depthRange` into the key
+    static uint64_t makeKey(RenderPass pass, GLuint program, GLuint vao, uint32_t material, float depth, float depthRange)
+    {
+        uint64_t d = (uint64_t)(std::clamp(depth / depthRange, 0.0f, 1.0f) * 0xffffff);
+        uint64_t p = program & 0xfff;
+        uint64_t v = vao & 0xfff;
+        uint64_t m = material & 0x3fff;
+        uint64_t key = (uint64_t)pass << 62;
+
+        if (pass == RenderPassBlended) {
+            return key | ((0xffffff - d) << 38) | (p << 26) | (v << 14) | m;
+        }
+        return key | (p << 50) | (v << 38) | (m << 24) | d;
+    }
+
+    // the returned command is filled in by the caller, uniforms are added right after it
+    RenderCommand& submit(RenderPass pass, const Shader& shader, GLuint vao, uint32_t material, float depth, float depthRange)
+    {
+        RenderCommand& cmd = commands.emplace_back();
+        cmd.key = makeKey(pass, shader.program, vao, material, depth, depthRange);
+        cmd.program = shader.program;
+        cmd.vao = vao;
+        cmd.blend = pass == RenderPassBlended;
+        cmd.uniformFirst = (uint32_t)uniformPool.size();
+        return cmd;
+    }
+
+    // applies to the last submitted command
+    template <typename T>
+    void uniform(const Uniform<T>& handle, const T& value)
+    {
+        if (!handle.valid() || commands.empty()) {
+            return;
+        }
+
+        UniformWrite& write = uniformPool.emplace_back();
+        write.location = handle.location;
+        if constexpr (std::is_same_v<T, float>) {
+            write.kind = UniformFloat;
+            write.data[0] = value;
+        } else if constexpr (std::is_same_v<T, int> || std::is_same_v<T, bool>) {
+            write.kind = UniformInt;
+            GLint i = value;
+            memcpy(write.data, &i, sizeof(i));
+        } else if constexpr (std::is_same_v<T, glm::vec3>) {
+            write.kind = UniformVec3;
+            memcpy(write.data, &value, sizeof(value));
+        } else if constexpr (std::is_same_v<T, glm::vec4>) {
+            write.kind = UniformVec4;
+            memcpy(write.data, &value, sizeof(value));
+        } else if constexpr (std::is_same_v<T, glm::mat4>) {
+            write.kind = UniformMat4;
+            memcpy(write.data, &value, sizeof(value));
+        }
+        commands.back().uniformCount++;
+    }
+
+    // lsd radix sort over the keys, 8 bits per pass. passes where every key has the same
+    // byte are skipped, so keys that differ only in a few fields cost only a few passes.
+    static void radixSort(std::vector<SortItem>& items, std::vector<SortItem>& scratch)
+    {
+        scratch.resize(items.size());
+        for (int shift = 0; shift < 64; shift += 8) {
+            uint32_t histogram[256] = {};
+            for (const SortItem& item : items) {
+                histogram[(item.key >> shift) & 0xff]++;
+            }
+
+            if (histogram[(items[0].key >> shift) & 0xff] == items.size()) {
+                continue;
+            }
+
+            uint32_t offset = 0;
+            for (uint32_t& bucket : histogram) {
+                uint32_t n = bucket;
+                bucket = offset;
+                offset += n;
+            }
+
+            for (const SortItem& item : items) {
+                scratch[histogram[(item.key >> shift) & 0xff]++] = item;
+            }
+            items.swap(scratch);
+        }
+    }
+
+    // drop the queued commands without drawing them
+    void discard()
+    {
+        stats = RenderQueueStats {};
+        commands.clear();
+        uniformPool.clear();
+    }
+
+    // sort and issue every command, then clear the queue. other code binds behind the cache's
+    // back between frames, so bindings start out unknown.
+    void execute(GlStateCache& state)
+    {
+        stats = RenderQueueStats {};
+        stats.draws = (uint32_t)commands.size();
+        if (commands.empty()) {
+            return;
+        }
+
+        auto sortStart = std::chrono::steady_clock::now();
+        items.resize(commands.size());
+        for (size_t i = 0; i < commands.size(); i++) {
+            items[i] = { commands[i].key, (uint32_t)i };
+        }
+        radixSort(items, scratch);
+        stats.sortMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - sortStart).count();
+
+        state.invalidate();
+        state.resetCounters();
+
+        for (const SortItem& item : items) {
+            const RenderCommand& cmd = commands[item.index];
+            state.useProgram(cmd.program);
+            state.bindVao(cmd.vao);
+            if (cmd.instanceBuffer) {
+                state.bindInstances(cmd.instanceBuffer, cmd.instanceOffset);
+            }
+            state.setBlend(cmd.blend);
+
+            for (uint32_t u = cmd.uniformFirst; u < cmd.uniformFirst + cmd.uniformCount; u++) {
+                const UniformWrite& write = uniformPool[u];
+                state.setUniform(write.location, write.kind, write.data);
+            }
+
+            if (cmd.indirect) {
+                glBindBuffer(GL_DRAW_INDIRECT_BUFFER, cmd.indirect);
+                glMultiDrawElementsIndirect(cmd.mode, cmd.indexType, (const void*)cmd.offset, cmd.count, 0);
+            } else if (cmd.indexType) {
+                glDrawElementsInstancedBaseVertex(cmd.mode, cmd.count, cmd.indexType, (const void*)cmd.offset, cmd.instances, cmd.baseVertex);
+            } else if (cmd.instances == 1) {
+                glDrawArrays(cmd.mode, (GLint)cmd.offset, cmd.count);
+            } else {
+                glDrawArraysInstanced(cmd.mode, (GLint)cmd.offset, cmd.count, cmd.instances);
+            }
+        }
+
+        // leave no vertex array bound so later element buffer binds cannot modify one
+        state.bindVao(0);
+        state.setBlend(false);
+
+        stats.bindsRequested = state.binds.requested;
+        stats.bindsFiltered = state.binds.filtered;
+        stats.uniformsRequested = state.uniforms.requested;
+        stats.uniformsFiltered = state.uniforms.filtered;
+
+        commands.clear();
+        uniformPool.clear();
+    }
+};
+
+#endif // RENDER_QUEUE_H
@@ -0,0 +1,222 @@
+#ifndef SCENE_GRAPH_H
+#define SCENE_GRAPH_H
+
+#include "job_system.h"
+#include "math_kernels.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+
+using SceneNode = uint32_t;
+inline constexpr SceneNode sceneNodeNone = ~0u;
+
+// parent/child hierarchy with local TRS, local and world matrices kept in parallel arrays.
+// nodes are stored in creation order so a parent always precedes its children; update() only
+// recomputes the subtrees below nodes marked dirty since the last call.
+struct SceneGraph {
+    // local transform, edited in place followed by markDirty()
+    std::vector<glm::vec3> translation;
+    std::vector<glm::vec3> rotation; // euler degrees
+    std::vector<glm::vec3> scale;
+
+    std::vector<glm::mat4> local;
+    std::vector<glm::mat4> world;
+
+    std::vector<SceneNode> parent;
+    std::vector<SceneNode> firstChild;
+    std::vector<SceneNode> nextSibling;
+    std::vector<std::string> names;
+
+    // dirty: local TRS changed, visited: collected by the running update()
+    enum : uint8_t { dirty = 1, visited = 2 };
+    std::vector<uint8_t> localDirty;
+    std::vector<SceneNode> dirtyRoots;
+
+    // nodes whose world matrix was recomputed by the last update(), parents first
+    std::vector<SceneNode> updated;
+
+    std::vector<SceneNode> stack;
+
+    // nodes per job when a batch is split
+    static constexpr size_t batchGrain = 2048;
+
+    size_t size() const { return parent.size(); }
+
+    SceneNode create(const std::string& name, SceneNode parentNode = sceneNodeNone,
+        const glm::vec3& t = glm::vec3(0.0f), const glm::vec3& r = glm::vec3(0.0f), const glm::vec3& s = glm::vec3(1.0f))
+    {
+        SceneNode node = (SceneNode)size();
+        translation.push_back(t);
+        rotation.push_back(r);
+        scale.push_back(s);
+        local.emplace_back(1.0f);
+        world.emplace_back(1.0f);
+        parent.push_back(parentNode);
+        firstChild.push_back(sceneNodeNone);
+        nextSibling.push_back(sceneNodeNone);
+        names.push_back(name);
+        localDirty.push_back(0);
+
+        // prepended, so children are listed newest first
+        if (parentNode != sceneNodeNone) {
+            nextSibling[node] = firstChild[parentNode];
+            firstChild[parentNode] = node;
+        }
+
+        markDirty(node);
+        return node;
+    }
+
+    void reserve(size_t count)
+    {
+        translation.reserve(count);
+        rotation.reserve(count);
+        scale.reserve(count);
+        local.reserve(count);
+        world.reserve(count);
+        parent.reserve(count);
+        firstChild.reserve(count);
+        nextSibling.reserve(count);
+        names.reserve(count);
+        localDirty.reserve(count);
+    }
+
+    // drop every node created at or after `count`. they cannot be parents of older nodes, so
+    // only the child lists of the remaining nodes need unlinking.
+    void truncate(size_t count)
+    {
+        if (count >= size()) {
+            return;
+        }
+
+        for (size_t node = count; node < size(); node++) {
+            SceneNode p = parent[node];
+            if (p != sceneNodeNone && p < count) {
+                // children are prepended, so the removed ones sit at the head of the list
+                while (firstChild[p] != sceneNodeNone && firstChild[p] >= count) {
+                    firstChild[p] = nextSibling[firstChild[p]];
+                }
+            }
+        }
+
+        translation.resize(count);
+        rotation.resize(count);
+        scale.resize(count);
+        local.resize(count);
+        world.resize(count);
+        parent.resize(count);
+        firstChild.resize(count);
+        nextSibling.resize(count);
+        names.resize(count);
+        localDirty.resize(count);
+
+        dirtyRoots.erase(std::remove_if(dirtyRoots.begin(), dirtyRoots.end(), [count](SceneNode n) { return n >= count; }), dirtyRoots.end());
+    }
+
+    // the local transform changed, the node and everything below it gets recomputed
+    void markDirty(SceneNode node)
+    {
+        if (!localDirty[node]) {
+            localDirty[node] = dirty;
+            dirtyRoots.push_back(node);
+        }
+    }
+
+    void setTranslation(SceneNode node, const glm::vec3& t)
+    {
+        translation[node] = t;
+        markDirty(node);
+    }
+
+    void setRotation(SceneNode node, const glm::vec3& r)
+    {
+        rotation[node] = r;
+        markDirty(node);
+    }
+
+    void setScale(SceneNode node, const glm::vec3& s)
+    {
+        scale[node] = s;
+        markDirty(node);
+    }
+
+    // recompute world matrices below dirty nodes, returns the number of nodes updated. long
+    // runs are split across `jobs` when given.
+    size_t update(JobSystem* jobs = nullptr)
+    {
+        updated.clear();
+        if (dirtyRoots.empty()) {
+            return 0;
+        }
+
+        // creation order puts ancestors first, a dirty node inside an already collected subtree
+        // is skipped. siblings come off the stack oldest first, so they stay contiguous.
+        std::sort(dirtyRoots.begin(), dirtyRoots.end());
+
+        for (SceneNode root : dirtyRoots) {
+            if (localDirty[root] & visited) {
+                continue;
+            }
+
+            stack.clear();
+            stack.push_back(root);
+            while (!stack.empty()) {
+                SceneNode node = stack.back();
+                stack.pop_back();
+
+                localDirty[node] |= visited;
+                updated.push_back(node);
+
+                for (SceneNode child = firstChild[node]; child != sceneNodeNone; child = nextSibling[child]) {
+                    stack.push_back(child);
+                }
+            }
+        }
+
+        // runs of consecutive dirty nodes are composed in one batch
+        for (size_t i = 0; i < updated.size();) {
+            SceneNode first = updated[i];
+            size_t run = 1;
+            if (localDirty[first] & dirty) {
+                while (i + run < updated.size() && updated[i + run] == first + run && (localDirty[first + run] & dirty)) {
+                    run++;
+                }
+                parallelFor(jobs, first, first + run, batchGrain, [&](size_t begin, size_t end) {
+                    MathKernels::composeTrs(&translation[begin], &rotation[begin], &scale[begin], &local[begin], end - begin);
+                });
+            }
+            i += run;
+        }
+
+        // parents first, consecutive siblings share the parent matrix of one batch
+        for (size_t i = 0; i < updated.size();) {
+            SceneNode first = updated[i];
+            SceneNode p = parent[first];
+            size_t run = 1;
+            while (i + run < updated.size() && updated[i + run] == first + run && parent[first + run] == p) {
+                run++;
+            }
+
+            if (p == sceneNodeNone) {
+                std::copy(&local[first], &local[first] + run, &world[first]);
+            } else {
+                parallelFor(jobs, first, first + run, batchGrain, [&](size_t begin, size_t end) {
+                    MathKernels::mulMat4(world[p], &local[begin], &world[begin], end - begin);
+                });
+            }
+            i += run;
+        }
+
+        for (SceneNode node : updated) {
+            localDirty[node] = 0;
+        }
+
+        dirtyRoots.clear();
+        return updated.size();
+    }
+};
+
+#endif // SCENE_GRAPH_H
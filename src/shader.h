@@ -5,9 +5,131 @@
 #include "glad/glad.h"
 
 #include "file.h"
+#include "gl_resources.h"
+#include "gl_state.h"
+#include "program_cache.h"
+#include "shader_compiler.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// maps a C++ type to the GL type reported by uniform reflection
+template <typename T>
+struct UniformType;
+
+template <> struct UniformType<float> { static constexpr GLenum value = GL_FLOAT; };
+template <> struct UniformType<int> { static constexpr GLenum value = GL_INT; };
+template <> struct UniformType<bool> { static constexpr GLenum value = GL_BOOL; };
+template <> struct UniformType<glm::vec3> { static constexpr GLenum value = GL_FLOAT_VEC3; };
+template <> struct UniformType<glm::vec4> { static constexpr GLenum value = GL_FLOAT_VEC4; };
+template <> struct UniformType<glm::mat4> { static constexpr GLenum value = GL_FLOAT_MAT4; };
+
+// typed handle to a uniform location, resolved once after linking
+template <typename T>
+struct Uniform {
+    GLint location = -1;
+
+    bool valid() const { return location >= 0; }
+
+    // expects the owning program to be in use
+    void set(const T& value) const
+    {
+        if (location < 0) {
+            return;
+        }
+
+        if constexpr (std::is_same_v<T, float>) {
+            glUniform1f(location, value);
+        } else if constexpr (std::is_same_v<T, int> || std::is_same_v<T, bool>) {
+            glUniform1i(location, value);
+        } else if constexpr (std::is_same_v<T, glm::vec3>) {
+            glUniform3fv(location, 1, glm::value_ptr(value));
+        } else if constexpr (std::is_same_v<T, glm::vec4>) {
+            glUniform4fv(location, 1, glm::value_ptr(value));
+        } else if constexpr (std::is_same_v<T, glm::mat4>) {
+            glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value));
+        }
+    }
+};
+
+struct UniformInfo {
+    std::string name;
+    GLint location;
+    GLenum type;
+    GLint count;
+};
+
+struct UniformBlockInfo {
+    std::string name;
+    GLuint index;
+    GLint size;
+};
 
 struct Shader {
+    // program binary cache shared by every shader, set up once the context exists
+    static inline ProgramCache* cache = nullptr;
+
+    // compiles in the background when set, otherwise builds are issued on the calling thread
+    static inline ShaderCompiler* compiler = nullptr;
+
+    // told about deleted programs so it drops their cached uniform values
+    static inline GlStateCache* state = nullptr;
+
     GLuint program = 0;
+    std::vector<UniformInfo> uniforms;
+    std::vector<UniformBlockInfo> blocks;
+
+    std::unique_ptr<ShaderBuild> build;
+    double buildMs = 0.0; // submit to finish(), including time spent waiting to be polled
+
+    // debug name of the program in the resource registry, the site is where the build started
+    std::string label;
+    const char* file = nullptr;
+    int line = 0;
+
+    Shader() = default;
+
+    // a build still in flight is dropped without checking it. the compiler thread may hold it,
+    // so it is waited for before it is freed
+    ~Shader()
+    {
+        if (build) {
+            if (compiler && compiler->mode == ShaderCompiler::ModeWorker) {
+                compiler->finish(*build);
+            }
+            glDeleteShader(build->vertShader);
+            glDeleteShader(build->fragShader);
+            glDeleteProgram(build->program);
+            build.reset();
+        }
+        release();
+    }
+
+    Shader(const Shader&) = delete;
+    Shader& operator=(const Shader&) = delete;
+    Shader(Shader&& other) noexcept { swap(other); }
+    Shader& operator=(Shader&& other) noexcept
+    {
+        swap(other);
+        return *this;
+    }
+
+    void swap(Shader& other) noexcept
+    {
+        std::swap(program, other.program);
+        uniforms.swap(other.uniforms);
+        blocks.swap(other.blocks);
+        build.swap(other.build);
+        std::swap(buildMs, other.buildMs);
+        label.swap(other.label);
+        std::swap(file, other.file);
+        std::swap(line, other.line);
+    }
 
     bool init(const std::string& vertexSourcePath, const std::string& fragmentSourcePath)
     {
@@ -23,82 +145,213 @@ struct Shader {
             return false;
         }
 
-        GLuint vertShader = createShader(GL_VERTEX_SHADER, vertSource.value().c_str(), "vertex");
-        GLuint fragShader = createShader(GL_FRAGMENT_SHADER, fragSource.value().c_str(), "fragment");
+        return initFromSource(vertSource.value(), fragSource.value());
+    }
 
-        program = glCreateProgram();
-        if (!program) {
-            fprintf(stderr, "err: failed to create shader program\n");
-            glDeleteShader(vertShader);
-            glDeleteShader(fragShader);
-            return false;
+    // `defines` is inserted right after the #version line of both stages. blocks until linked.
+    bool initFromSource(const std::string& vertSource, const std::string& fragSource, const std::string& defines = "",
+        const char* site = __builtin_FILE(), int siteLine = __builtin_LINE())
+    {
+        begin(vertSource, fragSource, defines, site, siteLine);
+        return finish();
+    }
+
+    // start building without waiting for the driver, poll ready() and then call finish()
+    void begin(const std::string& vertSource, const std::string& fragSource, const std::string& defines = "",
+        const char* site = __builtin_FILE(), int siteLine = __builtin_LINE())
+    {
+        file = site;
+        line = siteLine;
+        build = std::make_unique<ShaderBuild>();
+        build->vert = injectDefines(vertSource, defines);
+        build->frag = injectDefines(fragSource, defines);
+
+        // a cached binary skips compiling and linking entirely
+        bool cached = cache && cache->enabled;
+        if (cached) {
+            build->cacheKey = cache->key(build->vert, build->frag);
+            build->program = glCreateProgram();
+            if (build->program && cache->load(build->cacheKey, build->program)) {
+                build->fromCache = true;
+                build->ok = true;
+                build->done = true;
+                return;
+            }
+
+            // a rejected binary leaves the program unusable, start over from source
+            glDeleteProgram(build->program);
+            build->program = 0;
         }
 
-        glAttachShader(program, vertShader);
-        glAttachShader(program, fragShader);
-        glLinkProgram(program);
+        if (compiler) {
+            compiler->submit(*build);
+        } else {
+            ShaderCompiler::issue(*build);
+        }
+    }
 
-        glDeleteShader(vertShader);
-        glDeleteShader(fragShader);
+    bool pending() const { return build != nullptr; }
 
-        return true;
+    bool ready() const
+    {
+        if (!build || build->done.load(std::memory_order_acquire)) {
+            return true;
+        }
+        return compiler ? compiler->ready(*build) : true;
     }
 
-    GLuint createShader(GLenum type, const char* source, const char* name)
+    // takes over the built program, false if compiling or linking failed
+    bool finish()
     {
-        GLuint shader = glCreateShader(type);
-        if (shader == GL_INVALID_ENUM) {
-            fprintf(stderr, "err: invalid enum type for %s shader\n", name);
-            return 0;
+        if (!build) {
+            return program != 0;
         }
 
-        if (!shader) {
-            fprintf(stderr, "err: failed to create %s shader\n", name);
-            return 0;
+        bool ok = build->ok;
+        if (!build->done.load(std::memory_order_acquire)) {
+            if (compiler) {
+                ok = compiler->finish(*build);
+            } else {
+                ShaderCompiler::check(*build);
+                ok = build->ok;
+            }
         }
 
-        glShaderSource(shader, 1, &source, NULL);
-        glCompileShader(shader);
-        if (!shaderCompiled(shader, name)) {
-            return 0;
+        buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - build->start).count();
+
+        if (ok) {
+            program = build->program;
+            GlResources::name(GlResourceProgram, program, label.empty() ? nullptr : label.c_str(), file, line);
+            if (cache && cache->enabled && build->cacheKey && !build->fromCache) {
+                cache->store(build->cacheKey, program);
+            }
+            reflect();
         }
 
-        return shader;
+        build.reset();
+        return ok;
     }
 
-    bool shaderCompiled(GLuint shader, const char* name) const
+    void release()
     {
-        GLint compiled;
-        glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
-        if (!compiled) {
-            GLsizei logLength;
-            glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &logLength);
+        // an unfinished build is completed first, its program is dropped as well
+        if (build) {
+            GLuint current = program;
+            finish();
+            if (program != current) {
+                glDeleteProgram(current);
+            }
+        }
 
-            GLchar infoLog[logLength];
-            glGetShaderInfoLog(shader, logLength, NULL, infoLog);
+        if (state && program) {
+            state->forget(program);
+        }
+        glDeleteProgram(program);
+        program = 0;
+        uniforms.clear();
+        blocks.clear();
+    }
 
-            fprintf(stderr, "err: failed to compile %s shader: %s\n", name, infoLog);
-            return false;
+    static std::string injectDefines(const std::string& source, const std::string& defines)
+    {
+        if (defines.empty()) {
+            return source;
         }
 
-        return true;
+        size_t pos = 0;
+        if (source.compare(0, 8, "#version") == 0) {
+            pos = source.find('\n');
+            pos = pos == std::string::npos ? source.size() : pos + 1;
+        }
+
+        // keep compiler line numbers matching the file on disk
+        return source.substr(0, pos) + defines + "#line 2\n" + source.substr(pos);
     }
 
-    bool programLinked(GLuint program) const
+    // query active uniforms and uniform blocks once so the render loop never looks up names
+    void reflect()
     {
-        GLint linked;
-        glGetProgramiv(program, GL_LINK_STATUS, &linked);
-        if (!linked) {
-            GLsizei logLength;
-            glGetProgramiv(program, GL_INFO_LOG_LENGTH, &logLength);
+        uniforms.clear();
+        blocks.clear();
 
-            GLchar infoLog[logLength];
-            glGetProgramInfoLog(program, logLength, NULL, infoLog);
+        GLint count = 0, maxLength = 0;
+        glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
 
-            fprintf(stderr, "err: failed to link shader program: %s\n", infoLog);
-            return false;
+        std::vector<GLchar> name(maxLength > 0 ? maxLength : 1);
+        for (GLuint i = 0; i < (GLuint)count; i++) {
+            // members of uniform blocks have no location, they are reached through the block
+            GLint blockIndex = -1;
+            glGetActiveUniformsiv(program, 1, &i, GL_UNIFORM_BLOCK_INDEX, &blockIndex);
+            if (blockIndex != -1) {
+                continue;
+            }
+
+            GLsizei length = 0;
+            GLint size = 0;
+            GLenum type = 0;
+            glGetActiveUniform(program, i, (GLsizei)name.size(), &length, &size, &type, name.data());
+
+            std::string uniformName(name.data(), length);
+            if (uniformName.size() > 3 && uniformName.compare(uniformName.size() - 3, 3, "[0]") == 0) {
+                uniformName.resize(uniformName.size() - 3);
+            }
+
+            GLint location = glGetUniformLocation(program, uniformName.c_str());
+            uniforms.push_back({ uniformName, location, type, size });
+        }
+
+        glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCKS, &count);
+        glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &maxLength);
+
+        name.resize(maxLength > 0 ? maxLength : 1);
+        for (GLuint i = 0; i < (GLuint)count; i++) {
+            GLsizei length = 0;
+            GLint size = 0;
+            glGetActiveUniformBlockName(program, i, (GLsizei)name.size(), &length, name.data());
+            glGetActiveUniformBlockiv(program, i, GL_UNIFORM_BLOCK_DATA_SIZE, &size);
+            blocks.push_back({ std::string(name.data(), length), i, size });
+        }
+    }
+
+    // returns an invalid handle when the uniform is not active (e.g. optimized out)
+    template <typename T>
+    Uniform<T> uniform(const std::string& name) const
+    {
+        for (const auto& info : uniforms) {
+            if (info.name != name) {
+                continue;
+            }
+
+            if (info.type != UniformType<T>::value) {
+                fprintf(stderr, "err: uniform %s has type 0x%x, expected 0x%x\n", name.c_str(), info.type, UniformType<T>::value);
+                return {};
+            }
+
+            return { info.location };
+        }
+
+        return {};
+    }
+
+    // point the named uniform block at a binding index shared by every program
+    bool bindBlock(const std::string& name, GLuint binding, GLsizeiptr hostSize) const
+    {
+        for (const auto& block : blocks) {
+            if (block.name != name) {
+                continue;
+            }
+
+            if (block.size > hostSize) {
+                fprintf(stderr, "err: uniform block %s is %d bytes, host struct is %d bytes\n", name.c_str(), block.size, (int)hostSize);
+                return false;
+            }
+
+            glUniformBlockBinding(program, block.index, binding);
+            return true;
         }
 
+        // not an error, the block may be unused by this program
         return true;
     }
 };
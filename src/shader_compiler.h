@@ -0,0 +1,245 @@
+#ifndef SHADER_COMPILER_H
+#define SHADER_COMPILER_H
+
+#define GLAD_IMPLEMENTATION
+#include "glad/glad.h"
+
+#define GLFW_INCLUDE
+#include "GLFW/glfw3.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// one program compile and link in flight
+struct ShaderBuild {
+    std::string vert;
+    std::string frag;
+    uint64_t cacheKey = 0;
+
+    GLuint program = 0;
+    GLuint vertShader = 0;
+    GLuint fragShader = 0;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::atomic<bool> done { false }; // set by the worker thread or for cache hits
+    bool ok = false;
+    bool fromCache = false;
+};
+
+// compiles programs without blocking the render loop. with KHR/ARB_parallel_shader_compile
+// the driver compiles in the background and completion is polled; otherwise a worker thread
+// with a context shared with the main one compiles and links. without either the build is
+// issued right away and its status is only queried once the caller finishes it.
+struct ShaderCompiler {
+    enum Mode {
+        ModeDeferred,
+        ModeParallel,
+        ModeWorker,
+    };
+
+    static constexpr const char* modeNames[] = { "deferred", "parallel (driver threads)", "worker thread" };
+
+    Mode mode = ModeDeferred;
+
+    GLFWwindow* workerContext = nullptr;
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<ShaderBuild*> queue;
+    bool quit = false;
+
+    ~ShaderCompiler() { shutdown(); }
+
+    // `sharedContext` is an invisible window sharing objects with the main context, owned by
+    // the compiler from here on. it is only used when the driver cannot compile in parallel.
+    void init(GLFWwindow* sharedContext)
+    {
+        if (GLAD_GL_KHR_parallel_shader_compile) {
+            glMaxShaderCompilerThreadsKHR(0xffffffffu);
+            mode = ModeParallel;
+        } else if (GLAD_GL_ARB_parallel_shader_compile) {
+            glMaxShaderCompilerThreadsARB(0xffffffffu);
+            mode = ModeParallel;
+        } else if (sharedContext) {
+            workerContext = sharedContext;
+            worker = std::thread([this] { run(); });
+            mode = ModeWorker;
+        }
+
+        if (sharedContext && mode != ModeWorker) {
+            glfwDestroyWindow(sharedContext);
+        }
+    }
+
+    void submit(ShaderBuild& build)
+    {
+        if (mode == ModeWorker) {
+            std::lock_guard<std::mutex> lock(mutex);
+            queue.push_back(&build);
+            wake.notify_one();
+            return;
+        }
+
+        issue(build);
+    }
+
+    // true once finish() will not block
+    bool ready(const ShaderBuild& build) const
+    {
+        if (mode == ModeWorker) {
+            return build.done.load(std::memory_order_acquire);
+        }
+
+        if (mode == ModeParallel) {
+            GLint complete = GL_FALSE;
+            glGetProgramiv(build.program, GL_COMPLETION_STATUS_KHR, &complete);
+            return complete == GL_TRUE;
+        }
+
+        return true;
+    }
+
+    // checks the result on the calling thread, blocks if the build is not ready yet
+    bool finish(ShaderBuild& build)
+    {
+        if (mode == ModeWorker) {
+            while (!build.done.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            return build.ok;
+        }
+
+        check(build);
+        return build.ok;
+    }
+
+    // compile and link without querying any status, so nothing waits on the driver
+    static void issue(ShaderBuild& build)
+    {
+        const char* vert = build.vert.c_str();
+        const char* frag = build.frag.c_str();
+
+        build.vertShader = glCreateShader(GL_VERTEX_SHADER);
+        glShaderSource(build.vertShader, 1, &vert, NULL);
+        glCompileShader(build.vertShader);
+
+        build.fragShader = glCreateShader(GL_FRAGMENT_SHADER);
+        glShaderSource(build.fragShader, 1, &frag, NULL);
+        glCompileShader(build.fragShader);
+
+        build.program = glCreateProgram();
+        if (build.cacheKey) {
+            glProgramParameteri(build.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        }
+        glAttachShader(build.program, build.vertShader);
+        glAttachShader(build.program, build.fragShader);
+        glLinkProgram(build.program);
+    }
+
+    static void check(ShaderBuild& build)
+    {
+        build.ok = compiled(build.vertShader, "vertex") && compiled(build.fragShader, "fragment") && linked(build.program);
+
+        glDeleteShader(build.vertShader);
+        glDeleteShader(build.fragShader);
+        build.vertShader = 0;
+        build.fragShader = 0;
+
+        if (!build.ok) {
+            glDeleteProgram(build.program);
+            build.program = 0;
+        }
+    }
+
+    static bool compiled(GLuint shader, const char* name)
+    {
+        GLint status = GL_FALSE;
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+        if (status) {
+            return true;
+        }
+
+        GLint length = 0;
+        glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
+        std::vector<GLchar> log(length > 0 ? length : 1);
+        glGetShaderInfoLog(shader, (GLsizei)log.size(), NULL, log.data());
+
+        fprintf(stderr, "err: failed to compile %s shader: %s\n", name, log.data());
+        return false;
+    }
+
+    static bool linked(GLuint program)
+    {
+        GLint status = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &status);
+        if (status) {
+            return true;
+        }
+
+        GLint length = 0;
+        glGetProgramiv(program, GL_INFO_LOG_LENGTH, &length);
+        std::vector<GLchar> log(length > 0 ? length : 1);
+        glGetProgramInfoLog(program, (GLsizei)log.size(), NULL, log.data());
+
+        fprintf(stderr, "err: failed to link shader program: %s\n", log.data());
+        return false;
+    }
+
+    void run()
+    {
+        glfwMakeContextCurrent(workerContext);
+
+        while (true) {
+            ShaderBuild* build = nullptr;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this] { return quit || !queue.empty(); });
+                if (quit) {
+                    // builds still queued are failed so nobody waits on them forever
+                    for (ShaderBuild* queued : queue) {
+                        queued->done.store(true, std::memory_order_release);
+                    }
+                    queue.clear();
+                    break;
+                }
+                build = queue.front();
+                queue.pop_front();
+            }
+
+            issue(*build);
+            check(*build);
+
+            // the program must be complete before another context uses it
+            glFinish();
+            build->done.store(true, std::memory_order_release);
+        }
+
+        glfwMakeContextCurrent(nullptr);
+    }
+
+    void shutdown()
+    {
+        if (worker.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                quit = true;
+                wake.notify_one();
+            }
+            worker.join();
+        }
+
+        if (workerContext) {
+            glfwDestroyWindow(workerContext);
+            workerContext = nullptr;
+        }
+    }
+};
+
+#endif // SHADER_COMPILER_H
@@ -0,0 +1,221 @@
+#ifndef SHADER_VARIANTS_H
+#define SHADER_VARIANTS_H
+
+#include "shader.h"
+
+#include <cstdint>
+#include <iterator>
+#include <unordered_map>
+#include <unordered_set>
+
+// compile-time features of shaders/vertex.glsl, each bit maps to one #define
+enum ShaderFeature : uint32_t {
+    ShaderFeatureRotateX = 1 << 0,
+    ShaderFeatureRotateY = 1 << 1,
+    ShaderFeatureRotateZ = 1 << 2,
+    ShaderFeatureTint = 1 << 3,
+    ShaderFeatureQuantized = 1 << 4,
+};
+
+inline constexpr const char* shaderFeatureDefines[] = {
+    "ROTATE_X",
+    "ROTATE_Y",
+    "ROTATE_Z",
+    "INSTANCE_TINT",
+    "QUANTIZED_POS",
+};
+
+// a linked variant with the handles its draws set, resolved once when it links
+struct ShaderVariant : Shader {
+    Uniform<glm::vec4> posScale; // QUANTIZED_POS only
+    Uniform<glm::vec4> posOffset;
+};
+
+// one linked program per feature bitmask, compiled on first use and cached. rebuilds after a
+// source change compile in the background while the previous program keeps rendering.
+struct ShaderVariants {
+    std::string vertSource;
+    std::string fragSource;
+    std::unordered_map<uint32_t, ShaderVariant> variants;
+
+    // builds in flight, swapped into `variants` by poll() once linked
+    std::unordered_map<uint32_t, ShaderVariant> pending;
+    std::unordered_set<uint32_t> stale; // pending builds started from outdated sources
+
+    struct BlockBinding {
+        std::string name;
+        GLuint binding;
+        GLsizeiptr hostSize;
+    };
+    std::vector<BlockBinding> blockBindings;
+
+    double lastBuildMs = 0.0;
+    uint32_t lastBuildFeatures = 0;
+
+    bool init(const std::string& vertexSourcePath, const std::string& fragmentSourcePath)
+    {
+        auto vert = File::readFile(vertexSourcePath);
+        if (!vert.has_value()) {
+            fprintf(stderr, "err: failed to read vertex shader file: %s\n", vertexSourcePath.c_str());
+            return false;
+        }
+
+        auto frag = File::readFile(fragmentSourcePath);
+        if (!frag.has_value()) {
+            fprintf(stderr, "err: failed to read fragment shader file: %s\n", fragmentSourcePath.c_str());
+            return false;
+        }
+
+        initFromSource(vert.value(), frag.value());
+        return true;
+    }
+
+    void initFromSource(const std::string& vert, const std::string& frag)
+    {
+        vertSource = vert;
+        fragSource = frag;
+        variants.clear();
+    }
+
+    // applied to every variant, including ones compiled later
+    void bindBlock(const std::string& name, GLuint binding, GLsizeiptr hostSize)
+    {
+        blockBindings.push_back({ name, binding, hostSize });
+    }
+
+    static std::string defines(uint32_t features)
+    {
+        std::string out;
+        for (uint32_t i = 0; i < std::size(shaderFeatureDefines); i++) {
+            if (features & (1u << i)) {
+                out += "#define ";
+                out += shaderFeatureDefines[i];
+                out += "\n";
+            }
+        }
+        return out;
+    }
+
+    // program name in the resource registry
+    static std::string label(uint32_t features)
+    {
+        std::string out = "variant";
+        for (uint32_t i = 0; i < std::size(shaderFeatureDefines); i++) {
+            if (features & (1u << i)) {
+                out += " ";
+                out += shaderFeatureDefines[i];
+            }
+        }
+        return features ? out : out + " base";
+    }
+
+    // binds the blocks and resolves the handles of a freshly linked variant
+    bool link(ShaderVariant& shader) const
+    {
+        for (const auto& block : blockBindings) {
+            if (!shader.bindBlock(block.name, block.binding, block.hostSize)) {
+                return false;
+            }
+        }
+        shader.posScale = shader.uniform<glm::vec4>("uPosScale");
+        shader.posOffset = shader.uniform<glm::vec4>("uPosOffset");
+        return true;
+    }
+
+    // blocks until built. returns nullptr if the variant failed to build, failures are not retried
+    const ShaderVariant* get(uint32_t features)
+    {
+        auto it = variants.find(features);
+        if (it != variants.end()) {
+            return it->second.program ? &it->second : nullptr;
+        }
+
+        ShaderVariant& shader = variants[features];
+        shader.label = label(features);
+        if (!shader.initFromSource(vertSource, fragSource, defines(features))) {
+            fprintf(stderr, "err: failed to build shader variant 0x%x\n", features);
+            return nullptr;
+        }
+
+        if (!link(shader)) {
+            shader.release();
+            return nullptr;
+        }
+
+        return &shader;
+    }
+
+    // never blocks, a variant that is not built yet is started and nullptr returned meanwhile
+    const ShaderVariant* acquire(uint32_t features)
+    {
+        auto it = variants.find(features);
+        if (it != variants.end()) {
+            return it->second.program ? &it->second : nullptr;
+        }
+
+        if (!pending.count(features)) {
+            pending[features].label = label(features);
+            pending[features].begin(vertSource, fragSource, defines(features));
+        }
+        return nullptr;
+    }
+
+    // rebuild every variant from new sources, the current programs stay in use until then
+    void reload(const std::string& vert, const std::string& frag)
+    {
+        vertSource = vert;
+        fragSource = frag;
+
+        for (const auto& [features, shader] : variants) {
+            if (pending.count(features)) {
+                stale.insert(features);
+            } else {
+                pending[features].label = label(features);
+                pending[features].begin(vertSource, fragSource, defines(features));
+            }
+        }
+    }
+
+    // swap in finished builds, call once per frame
+    void poll()
+    {
+        for (auto it = pending.begin(); it != pending.end();) {
+            uint32_t features = it->first;
+            ShaderVariant& shader = it->second;
+            if (!shader.ready()) {
+                ++it;
+                continue;
+            }
+
+            bool ok = shader.finish() && link(shader);
+            lastBuildMs = shader.buildMs;
+            lastBuildFeatures = features;
+
+            if (stale.erase(features)) {
+                shader.release();
+                shader.begin(vertSource, fragSource, defines(features));
+                ++it;
+                continue;
+            }
+
+            auto active = variants.find(features);
+            if (ok) {
+                if (active != variants.end()) {
+                    active->second.release();
+                    active->second = std::move(shader);
+                } else {
+                    variants.emplace(features, std::move(shader));
+                }
+            } else {
+                fprintf(stderr, "err: failed to build shader variant 0x%x%s\n", features, active != variants.end() ? ", keeping the previous program" : "");
+                shader.release();
+                if (active == variants.end()) {
+                    variants[features]; // remembered as failed
+                }
+            }
+            it = pending.erase(it);
+        }
+    }
+};
+
+#endif // SHADER_VARIANTS_H
@@ -0,0 +1,423 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include "bounds.h"
+#include "bvh.h"
+#include "instance.h"
+#include "math_kernels.h"
+#include "scene_graph.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <string>
+#include <vector>
+
+struct CameraPose {
+    glm::vec3 pos { 1000.0f, 500.0f, 500.0f };
+    glm::vec3 target { 0.0f, 0.0f, 0.0f };
+    glm::vec3 up { 0.0f, 1.0f, 0.0f };
+    float fov = 45.0f;
+    float zNear = 0.1f;
+    float zFar = 5000.0f;
+};
+
+// controls edited by the ui and read by the update stage. every snapshot carries the settings
+// it was built from, so a frame is drawn the way it was simulated.
+struct SimSettings {
+    int instanceCount = 1;
+    float instanceSpacing = 300.0f;
+    bool frustumCull = true;
+    bool denseScene = false;
+
+    bool pyAnim = false;
+    bool gridAnim = false;
+    bool rotateAnimX = false;
+    bool rotateAnimY = false;
+    bool rotateAnimZ = false;
+    float animSpeed = 1.0f;
+    bool gpuAnim = false; // rotate per vertex in the shader instead of per instance
+    bool gpuCull = false; // cull, pick lods and animate in a compute shader, the bvh sits idle
+
+    int simdLevel = SimdScalar;
+
+    bool anyAxis() const { return rotateAnimX || rotateAnimY || rotateAnimZ; }
+    bool cpuAnim() const { return anyAxis() && !gpuAnim; }
+
+    bool operator==(const SimSettings& o) const
+    {
+        return instanceCount == o.instanceCount && instanceSpacing == o.instanceSpacing && frustumCull == o.frustumCull
+            && denseScene == o.denseScene && pyAnim == o.pyAnim && gridAnim == o.gridAnim && rotateAnimX == o.rotateAnimX
+            && rotateAnimY == o.rotateAnimY && rotateAnimZ == o.rotateAnimZ && animSpeed == o.animSpeed && gpuAnim == o.gpuAnim
+            && gpuCull == o.gpuCull && simdLevel == o.simdLevel;
+    }
+    bool operator!=(const SimSettings& o) const { return !(*this == o); }
+};
+
+struct NodeTransform {
+    glm::vec3 translation { 0.0f };
+    glm::vec3 rotation { 0.0f }; // euler degrees
+    glm::vec3 scale { 1.0f };
+};
+
+struct NodeEdit {
+    SceneNode node;
+    NodeTransform transform;
+};
+
+// everything the main thread hands to one update
+struct SimInput {
+    uint64_t sequence = 0;
+    int frame = 0;
+    float time = 0.0f;
+    float aspect = 1.0f;
+    SimSettings settings;
+
+    // absolute pose from the camera panel, applied before the middle mouse pan
+    bool setCamera = false;
+    CameraPose camera;
+    glm::vec2 pan { 0.0f };
+
+    std::vector<NodeEdit> edits;
+    SceneNode selected = 0;
+};
+
+// a node as the ui shows it
+struct NodeView {
+    SceneNode node = sceneNodeNone;
+    NodeTransform transform;
+    std::string name;
+    std::string parentName;
+};
+
+// the result of one update, immutable once published. slots are reused, so every field is
+// written by each update.
+struct FrameSnapshot {
+    uint64_t sequence = 0; // input it was built from
+    float time = 0.0f;
+    SimSettings settings;
+
+    CameraPose camera;
+    glm::mat4 view { 1.0f };
+    glm::mat4 projection { 1.0f };
+    glm::mat4 viewProjection { 1.0f };
+
+    glm::mat4 modelPyramid { 1.0f };
+    glm::mat4 modelGrid { 1.0f };
+    glm::mat4 gridModel { 1.0f }; // procedural grid, animation always composed
+    InstanceData gridInstance;
+
+    // changes to the static instance buffer: every instance when rebuilt, else the edited ones
+    int instanceCount = 0;
+    bool instancesRebuilt = false;
+    std::vector<int> changed;
+    std::vector<InstanceData> changedData;
+
+    // world bounds for gpu culling, only filled with gpuCull: every object when boundsRebuilt,
+    // else the ones in `changed`
+    bool boundsRebuilt = false;
+    std::vector<Aabb> changedBounds;
+
+    // culled and cpu animated instances, streamed instead of the static buffer when set
+    bool streamed = false;
+    std::vector<InstanceData> drawn;
+    int drawCount = 0;
+
+    NodeView pyramid;
+    NodeView grid;
+    NodeView selected;
+
+    size_t sceneNodes = 0;
+    size_t sceneUpdated = 0;
+    double sceneMs = 0.0;
+    double cullMs = 0.0;
+    int bvhNodes = 0;
+    int bvhVisited = 0;
+    double updateMs = 0.0;
+    bool cameraAnimating = false; // the camera moves on its own, frames are needed without input
+};
+
+// ui copy of a value owned by the update stage. an edit stays on screen until the snapshot of
+// the input carrying it comes back, so a drag never continues from a value older than itself.
+template <typename T>
+struct PendingEdit {
+    T value {};
+    uint64_t sequence = 0;
+    uint32_t key = ~0u;
+
+    T& show(const T& current, uint64_t applied, uint32_t currentKey = 0)
+    {
+        if (applied >= sequence || key != currentKey) {
+            value = current;
+            key = currentKey;
+        }
+        return value;
+    }
+
+    void edited(uint64_t next) { sequence = next; }
+};
+
+// cpu side of the scene: transforms, instances, bounds, culling and cpu animation. only the
+// update stage touches it, the renderer sees the snapshots it fills.
+struct Simulation {
+    SceneGraph graph;
+    JobSystem* jobs = nullptr; // splits the per-object loops, serial without one
+    SceneNode root = sceneNodeNone;
+    SceneNode gridNode = sceneNodeNone;
+    SceneNode pyNode = sceneNodeNone;
+    size_t pyFirstInstance = 0;
+
+    Aabb pyBounds;
+    Aabb denseBounds;
+
+    // one child node per instance below the pyramid node, recreated when the lattice changes
+    std::vector<InstanceData> instances;
+    int layoutCount = 0;
+    float layoutSpacing = 0.0f;
+    bool layoutAnim = false;
+
+    // instances are frustum culled through a bvh over their world bounds
+    Bvh bvh;
+    std::vector<Aabb> objectBounds;
+    std::vector<int> visible;
+    std::vector<InstanceData> culled;
+    bool boundsDense = false;
+    bool boundsGpu = false;
+    bool bvhStale = false; // bounds changed while the gpu culled
+
+    CameraPose camera;
+    bool introAnim = false; // camera slides in on launch
+    int orbitFrames = 0; // scripted bench camera, one orbit over this many frames
+
+    void init(const Aabb& pyramidBounds, const Aabb& denseMeshBounds)
+    {
+        root = graph.create("Scene");
+        gridNode = graph.create("Grid", root);
+        pyNode = graph.create("Pyramid", root);
+        pyFirstInstance = graph.size();
+
+        pyBounds = pyramidBounds;
+        denseBounds = denseMeshBounds;
+    }
+
+    void view(SceneNode node, NodeView& out) const
+    {
+        SceneNode p = graph.parent[node];
+        out.node = node;
+        out.transform = { graph.translation[node], graph.rotation[node], graph.scale[node] };
+        out.name = graph.names[node].empty() ? "(instance)" : graph.names[node];
+        out.parentName = p == sceneNodeNone ? "none" : graph.names[p];
+    }
+
+    void update(const SimInput& in, FrameSnapshot& out)
+    {
+        auto updateStart = std::chrono::steady_clock::now();
+        const SimSettings& s = in.settings;
+
+        if (MathKernels::level != s.simdLevel) {
+            MathKernels::setLevel((SimdLevel)s.simdLevel);
+        }
+
+        // ui edits
+        if (in.setCamera) {
+            camera = in.camera;
+        }
+        camera.pos.x += in.pan.x;
+        camera.pos.y += in.pan.y;
+
+        for (const NodeEdit& edit : in.edits) {
+            if (edit.node < graph.size()) {
+                graph.translation[edit.node] = edit.transform.translation;
+                graph.rotation[edit.node] = edit.transform.rotation;
+                graph.scale[edit.node] = edit.transform.scale;
+                graph.markDirty(edit.node);
+            }
+        }
+
+        // scripted camera: one orbit around the scene over the measured frames
+        if (orbitFrames > 0) {
+            float extent = std::max(1000.0f, std::sqrt((float)s.instanceCount) * s.instanceSpacing);
+            float orbit = 6.2831853f * in.frame / orbitFrames;
+            camera.pos = glm::vec3(std::cos(orbit) * extent, extent * 0.5f, std::sin(orbit) * extent);
+            camera.zFar = extent * 4.0f;
+        }
+
+        // recreate the instance nodes when the lattice changed
+        if (layoutCount != s.instanceCount || layoutSpacing != s.instanceSpacing) {
+            graph.truncate(pyFirstInstance);
+            graph.reserve(pyFirstInstance + s.instanceCount);
+            for (int i = 0; i < s.instanceCount; i++) {
+                graph.create("", pyNode, latticeOffset(i, s.instanceCount, s.instanceSpacing));
+            }
+            layoutCount = s.instanceCount;
+            layoutSpacing = s.instanceSpacing;
+        }
+
+        // world matrices of the subtrees edited since the last update
+        auto sceneStart = std::chrono::steady_clock::now();
+        out.sceneUpdated = graph.update(jobs);
+        out.sceneMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - sceneStart).count();
+        out.sceneNodes = graph.size();
+
+        out.sequence = in.sequence;
+        out.time = in.time;
+        out.settings = s;
+        out.camera = camera;
+        out.modelPyramid = graph.world[pyNode];
+        out.modelGrid = graph.world[gridNode];
+
+        out.view = glm::lookAt(camera.pos, camera.target, camera.up);
+        out.projection = glm::perspective(glm::radians(camera.fov), in.aspect, camera.zNear, camera.zFar);
+        out.viewProjection = out.projection * out.view;
+
+        // tint and animation data is rebuilt when the count or animation toggle changed, model
+        // matrices are copied only for instance nodes the scene graph update touched
+        bool rebuild = (int)instances.size() != s.instanceCount || layoutAnim != s.pyAnim;
+        if (rebuild) {
+            buildInstanceLattice(instances, s.instanceCount, s.pyAnim);
+            layoutAnim = s.pyAnim;
+        }
+
+        out.changed.clear();
+        out.changedData.clear();
+        for (SceneNode node : graph.updated) {
+            if (node >= pyFirstInstance) {
+                int i = (int)(node - pyFirstInstance);
+                instances[i].model = graph.world[node];
+                out.changed.push_back(i);
+            }
+        }
+
+        out.instanceCount = (int)instances.size();
+        out.instancesRebuilt = rebuild;
+        if (rebuild) {
+            out.changedData = instances;
+        } else {
+            for (int i : out.changed) {
+                out.changedData.push_back(instances[i]);
+            }
+        }
+
+        // world bounds follow the instance transforms, the bvh is refit unless the object count changed.
+        // animated instances get bounds that hold for any rotation so they never need a refit.
+        const Aabb& meshBounds = s.denseScene ? denseBounds : pyBounds;
+        auto instanceBounds = [&](int i) {
+            const InstanceData& inst = instances[i];
+            return inst.anim.x > 0.5f ? meshBounds.rotationInvariant(inst.model) : meshBounds.transformed(inst.model);
+        };
+
+        bool allBounds = rebuild || boundsDense != s.denseScene || boundsGpu != s.gpuCull || out.changed.size() == instances.size();
+        if (allBounds) {
+            objectBounds.resize(instances.size());
+            parallelFor(jobs, 0, instances.size(), 2048, [&](size_t first, size_t last) {
+                if (s.pyAnim) {
+                    for (size_t i = first; i < last; i++) {
+                        objectBounds[i] = instanceBounds((int)i);
+                    }
+                } else {
+                    // instance models are the contiguous world matrices of the instance nodes
+                    MathKernels::transformAabb(meshBounds, &graph.world[pyFirstInstance + first], &objectBounds[first], last - first);
+                }
+            });
+            boundsDense = s.denseScene;
+            boundsGpu = s.gpuCull;
+        } else {
+            parallelFor(jobs, 0, out.changed.size(), 2048, [&](size_t first, size_t last) {
+                for (size_t k = first; k < last; k++) {
+                    objectBounds[out.changed[k]] = instanceBounds(out.changed[k]);
+                }
+            });
+        }
+
+        // the compute shader culls against a copy of the bounds kept up to date on the gpu
+        out.boundsRebuilt = s.gpuCull && allBounds;
+        out.changedBounds.clear();
+        if (out.boundsRebuilt) {
+            out.changedBounds = objectBounds;
+        } else if (s.gpuCull) {
+            for (int i : out.changed) {
+                out.changedBounds.push_back(objectBounds[i]);
+            }
+        }
+
+        if (s.gpuCull) {
+            bvhStale |= allBounds || !out.changed.empty();
+        } else if (allBounds || bvhStale) {
+            if (bvh.size() != objectBounds.size()) {
+                bvh.build(objectBounds);
+            } else {
+                for (size_t i = 0; i < objectBounds.size(); i++) {
+                    bvh.update((int)i, objectBounds[i]);
+                }
+                bvh.refit();
+            }
+            bvhStale = false;
+        } else if (!out.changed.empty()) {
+            for (int i : out.changed) {
+                bvh.update(i, objectBounds[i]);
+            }
+            bvh.refit();
+        }
+
+        // animated or culled instances are streamed, otherwise the static copy is drawn
+        bool animate = s.pyAnim && s.cpuAnim() && !s.gpuCull;
+        out.streamed = animate || (s.frustumCull && !s.gpuCull);
+        out.drawn.clear();
+        out.cullMs = 0.0;
+
+        const std::vector<InstanceData>* source = &instances;
+        if (s.frustumCull && !s.gpuCull) {
+            auto cullStart = std::chrono::steady_clock::now();
+
+            bvh.cull(Frustum::fromMatrix(out.viewProjection), visible);
+
+            std::vector<InstanceData>& target = animate ? culled : out.drawn;
+            target.clear();
+            for (int i : visible) {
+                target.push_back(instances[i]);
+            }
+            source = &target;
+
+            out.cullMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - cullStart).count();
+        }
+
+        if (animate) {
+            animateInstances(*source, out.drawn, in.time, s.animSpeed, s.rotateAnimX, s.rotateAnimY, s.rotateAnimZ, jobs);
+        }
+        out.drawCount = (int)source->size();
+        out.bvhNodes = (int)bvh.nodes.size();
+        out.bvhVisited = bvh.nodesVisited;
+
+        // grid instance
+        glm::mat4 gridRotation = animRotation(in.time * s.animSpeed, s.rotateAnimX, s.rotateAnimY, s.rotateAnimZ);
+        out.gridInstance.model = s.gridAnim && s.cpuAnim() ? out.modelGrid * gridRotation : out.modelGrid;
+        out.gridInstance.anim.x = s.gridAnim ? 1.0f : 0.0f;
+
+        // the procedural grid has no vertices to rotate, animation is always composed into the model matrix
+        out.gridModel = s.gridAnim && s.anyAxis() ? out.modelGrid * gridRotation : out.modelGrid;
+
+        view(pyNode, out.pyramid);
+        view(gridNode, out.grid);
+        view(std::min<SceneNode>(in.selected, (SceneNode)graph.size() - 1), out.selected);
+
+        // the launch slide, applied to the next update
+        if (introAnim) {
+            float targetX = 500.0f;
+            float lerpFactor = 0.08f;
+
+            camera.pos.x = glm::mix(camera.pos.x, targetX, lerpFactor);
+
+            if (fabs(camera.pos.x - targetX) < 1.f) {
+                camera.pos.x = targetX;
+                introAnim = false;
+            }
+        }
+
+        out.cameraAnimating = introAnim || orbitFrames > 0;
+        out.updateMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - updateStart).count();
+    }
+};
+
+#endif // SIMULATION_H
@@ -7,12 +7,12 @@ struct Timer {
     double last = 0.0f;
 
     void reset() {
-        last = glfwGetTime();;
+        last = glfwGetTime();
     }
 
     double delta() {
         double now = glfwGetTime();
-        double dt = last - now;
+        double dt = now - last;
         last = now;
         return dt;
     }
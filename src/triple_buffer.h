@@ -0,0 +1,47 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <atomic>
+#include <cstdint>
+
+// single producer, single consumer handover of the newest value. the producer writes its own
+// slot and swaps it with the shared middle slot, the consumer swaps its slot with the middle
+// one when a fresh value was published. neither side ever waits for the other, values the
+// consumer did not pick up in time are overwritten.
+template <typename T>
+struct TripleBuffer {
+    static constexpr uint8_t indexMask = 3;
+    static constexpr uint8_t freshBit = 4;
+
+    T slots[3];
+
+    // middle slot index, freshBit is set while it holds a value the consumer has not taken
+    std::atomic<uint8_t> middle { 1 };
+    uint8_t back = 0; // producer only
+    uint8_t front = 2; // consumer only
+
+    // producer side
+    T& writeSlot() { return slots[back]; }
+
+    void publish()
+    {
+        back = middle.exchange(back | freshBit, std::memory_order_acq_rel) & indexMask;
+    }
+
+    // consumer side
+    bool fresh() const { return middle.load(std::memory_order_acquire) & freshBit; }
+
+    // swaps in the newest published value, false when nothing was published since the last call
+    bool acquire()
+    {
+        if (!fresh()) {
+            return false;
+        }
+        front = middle.exchange(front, std::memory_order_acq_rel) & indexMask;
+        return true;
+    }
+
+    const T& readSlot() const { return slots[front]; }
+};
+
+#endif // TRIPLE_BUFFER_H
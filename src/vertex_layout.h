@@ -0,0 +1,187 @@
+#ifndef VERTEX_LAYOUT_H
+#define VERTEX_LAYOUT_H
+
+#include "gl_buffer.h"
+#include "vertex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+#include <initializer_list>
+#include <vector>
+
+// half floats have no glm storage type of their own
+struct Half4 {
+    uint16_t v[4];
+};
+
+// GL component type and count of a vertex member type
+template <typename T>
+struct AttribTraits;
+
+template <> struct AttribTraits<glm::vec3> { static constexpr GLint size = 3; static constexpr GLenum type = GL_FLOAT; };
+template <> struct AttribTraits<glm::vec4> { static constexpr GLint size = 4; static constexpr GLenum type = GL_FLOAT; };
+template <> struct AttribTraits<glm::i16vec4> { static constexpr GLint size = 4; static constexpr GLenum type = GL_SHORT; };
+template <> struct AttribTraits<glm::u8vec4> { static constexpr GLint size = 4; static constexpr GLenum type = GL_UNSIGNED_BYTE; };
+template <> struct AttribTraits<Half4> { static constexpr GLint size = 4; static constexpr GLenum type = GL_HALF_FLOAT; };
+
+struct VertexAttrib {
+    GLuint location;
+    GLint size;
+    GLenum type;
+    GLboolean normalized;
+    GLintptr offset;
+};
+
+#define VERTEX_ATTRIB(location, V, member, normalized) \
+    VertexAttrib { location, AttribTraits<decltype(V::member)>::size, AttribTraits<decltype(V::member)>::type, normalized, offsetof(V, member) }
+
+// specialized per vertex type with the attributes read by shaders/vertex.glsl
+template <typename V>
+struct VertexLayout;
+
+// configure every attribute of V on the bound vao with the vertex buffer bound
+template <typename V>
+void applyVertexLayout()
+{
+    for (const VertexAttrib& a : VertexLayout<V>::attribs) {
+        Vao::attrib(a.location, a.size, a.type, a.normalized, sizeof(V), a.offset);
+    }
+}
+
+template <>
+struct VertexLayout<Vertex> {
+    static constexpr VertexAttrib attribs[] = {
+        VERTEX_ATTRIB(0, Vertex, position, GL_FALSE),
+        VERTEX_ATTRIB(1, Vertex, color, GL_FALSE),
+    };
+};
+
+// 12 bytes: snorm16 position relative to the mesh bounds, rgba8 color
+struct VertexSnorm16 {
+    glm::i16vec4 position;
+    glm::u8vec4 color;
+};
+
+template <>
+struct VertexLayout<VertexSnorm16> {
+    static constexpr VertexAttrib attribs[] = {
+        VERTEX_ATTRIB(0, VertexSnorm16, position, GL_TRUE),
+        VERTEX_ATTRIB(1, VertexSnorm16, color, GL_TRUE),
+    };
+};
+
+// 12 bytes: half float position relative to the mesh bounds, rgba8 color
+struct VertexHalf {
+    Half4 position;
+    glm::u8vec4 color;
+};
+
+template <>
+struct VertexLayout<VertexHalf> {
+    static constexpr VertexAttrib attribs[] = {
+        VERTEX_ATTRIB(0, VertexHalf, position, GL_FALSE),
+        VERTEX_ATTRIB(1, VertexHalf, color, GL_TRUE),
+    };
+};
+
+static_assert(sizeof(VertexSnorm16) == 12 && sizeof(VertexHalf) == 12, "packed vertices must stay 12 bytes");
+
+enum VertexFormat {
+    VertexFormatFloat,
+    VertexFormatSnorm16,
+    VertexFormatHalf,
+};
+
+inline constexpr const char* vertexFormatNames[] = { "float", "snorm16", "half" };
+
+// positions are stored as (p - offset) / scale so they fill [-1, 1]
+struct PositionQuantization {
+    glm::vec4 scale { 1.0f };
+    glm::vec4 offset { 0.0f };
+
+    static PositionQuantization fromBounds(const std::vector<Vertex>& vertices) { return fromBounds({ &vertices }); }
+
+    // one range over several meshes, for meshes drawn with the same uniforms
+    static PositionQuantization fromBounds(std::initializer_list<const std::vector<Vertex>*> meshes)
+    {
+        PositionQuantization q;
+        glm::vec3 lo(INFINITY);
+        glm::vec3 hi(-INFINITY);
+        for (const auto* vertices : meshes) {
+            for (const auto& v : *vertices) {
+                lo = glm::min(lo, v.position);
+                hi = glm::max(hi, v.position);
+            }
+        }
+        if (lo.x > hi.x) {
+            return q;
+        }
+
+        glm::vec3 half = glm::max((hi - lo) * 0.5f, glm::vec3(1e-6f));
+        q.scale = glm::vec4(half, 1.0f);
+        q.offset = glm::vec4((hi + lo) * 0.5f, 0.0f);
+        return q;
+    }
+
+    glm::vec3 normalize(const glm::vec3& p) const
+    {
+        return glm::clamp((p - glm::vec3(offset)) / glm::vec3(scale), glm::vec3(-1.0f), glm::vec3(1.0f));
+    }
+};
+
+inline glm::u8vec4 packColor(const glm::vec4& c)
+{
+    return glm::u8vec4(glm::round(glm::clamp(c, 0.0f, 1.0f) * 255.0f));
+}
+
+inline void packVertices(const std::vector<Vertex>& in, const PositionQuantization& q, std::vector<VertexSnorm16>& out)
+{
+    out.resize(in.size());
+    for (size_t i = 0; i < in.size(); i++) {
+        glm::vec3 p = glm::round(q.normalize(in[i].position) * 32767.0f);
+        out[i].position = glm::i16vec4(glm::ivec3(p), 32767);
+        out[i].color = packColor(in[i].color);
+    }
+}
+
+inline void packVertices(const std::vector<Vertex>& in, const PositionQuantization& q, std::vector<VertexHalf>& out)
+{
+    out.resize(in.size());
+    for (size_t i = 0; i < in.size(); i++) {
+        glm::vec3 p = q.normalize(in[i].position);
+        out[i].position = { { glm::packHalf1x16(p.x), glm::packHalf1x16(p.y), glm::packHalf1x16(p.z), glm::packHalf1x16(1.0f) } };
+        out[i].color = packColor(in[i].color);
+    }
+}
+
+inline GLsizei indexSize(GLenum type)
+{
+    return type == GL_UNSIGNED_BYTE ? 1 : type == GL_UNSIGNED_SHORT ? 2 : 4;
+}
+
+// narrowest index type that can address `vertexCount` vertices, packed into `out`
+inline GLenum packIndices(const std::vector<GLuint>& indices, size_t vertexCount, std::vector<uint8_t>& out)
+{
+    GLenum type = vertexCount <= 0x100 ? GL_UNSIGNED_BYTE : vertexCount <= 0x10000 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+
+    out.resize(indices.size() * indexSize(type));
+    for (size_t i = 0; i < indices.size(); i++) {
+        if (type == GL_UNSIGNED_BYTE) {
+            out[i] = (uint8_t)indices[i];
+        } else if (type == GL_UNSIGNED_SHORT) {
+            uint16_t v = (uint16_t)indices[i];
+            memcpy(&out[i * 2], &v, 2);
+        } else {
+            memcpy(&out[i * 4], &indices[i], 4);
+        }
+    }
+
+    return type;
+}
+
+#endif // VERTEX_LAYOUT_H
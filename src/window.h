@@ -7,8 +7,15 @@
 #define GLFW_INCLUDE
 #include "GLFW/glfw3.h"
 
+#include "gl_resources.h"
+#include "gl_stats.h"
+#include "headless_context.h"
+
+#include <chrono>
+#include <cmath>
 #include <cstdlib>
 #include <string>
+#include <thread>
 
 struct Window {
     GLFWwindow* m_handle;
@@ -16,6 +23,15 @@ struct Window {
     int m_height;
     bool m_fullscreen;
     bool m_maximized;
+    bool m_headless = false;
+    HeadlessContext m_context;
+
+    // swap interval in effect, headless swaps emulate a 60 Hz display for interval 1
+    int m_swapInterval = 0;
+    std::chrono::steady_clock::time_point m_nextVblank;
+
+    // input and window events seen so far, bumped by the callbacks
+    uint64_t m_events = 0;
 
     bool init(const std::string& title, bool maximized = true, int width = 1200, int height = 720, bool fullscreen = false)
     {
@@ -32,6 +48,9 @@ struct Window {
         m_width = (m_maximized || m_fullscreen) ? mode->width : width;
         m_height =(m_maximized || m_fullscreen) ? mode->height : height;
 
+        // hints only apply to windows created after them
+        setHints();
+
         m_handle = glfwCreateWindow(m_width, m_height, title.c_str(), m_fullscreen ? monitor : NULL, NULL);
         if (!m_handle) {
             fprintf(stderr, "failed to create GLFWwindow\n");
@@ -39,10 +58,10 @@ struct Window {
             return false;
         }
 
-        glfwSwapInterval(1);
-        setHints();
-
+        // the swap interval belongs to the current context, so it is set after making it current
         glfwMakeContextCurrent(m_handle);
+        setSwapInterval(1);
+        installEventCallbacks();
 
         if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
             fprintf(stderr, "err: failed to initialize glad\n");
@@ -50,12 +69,67 @@ struct Window {
             return false;
         }
 
+        GlStats::install();
+        GlResources::install();
+
+        return true;
+    }
+
+    // offscreen context for benchmarks: surfaceless EGL where available, otherwise an invisible
+    // window. either way rendering is expected to go to a framebuffer object.
+    bool initHeadless(int width, int height)
+    {
+        m_headless = true;
+        m_maximized = false;
+        m_fullscreen = false;
+        m_width = width;
+        m_height = height;
+        m_handle = NULL;
+
+        GLADloadproc loader = (GLADloadproc)HeadlessContext::getProcAddress;
+        if (m_context.init(3, 3)) {
+            // glfw only provides the timer in this case
+            glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+            if (!glfwInit()) {
+                fprintf(stderr, "failed to initialize glfw\n");
+                m_context.shutdown();
+                return false;
+            }
+        } else {
+            fprintf(stderr, "falling back to an invisible glfw window\n");
+            if (!glfwInit()) {
+                fprintf(stderr, "failed to initialize glfw\n");
+                return false;
+            }
+
+            setHints();
+            glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+            m_handle = glfwCreateWindow(width, height, "bench", NULL, NULL);
+            if (!m_handle) {
+                fprintf(stderr, "failed to create GLFWwindow\n");
+                shutdown();
+                return false;
+            }
+
+            glfwMakeContextCurrent(m_handle);
+            loader = (GLADloadproc)glfwGetProcAddress;
+        }
+
+        if (!gladLoadGLLoader(loader)) {
+            fprintf(stderr, "err: failed to initialize glad\n");
+            shutdown();
+            return false;
+        }
+
+        GlStats::install();
+        GlResources::install();
         return true;
     }
 
     bool shouldClose() const
     {
-        return glfwWindowShouldClose(m_handle);
+        return m_handle ? glfwWindowShouldClose(m_handle) : false;
     }
 
     void pollEvents() const
@@ -63,16 +137,69 @@ struct Window {
         glfwPollEvents();
     }
 
-    void swapBuffers() const
+    // blocks until an event arrives or `timeout` seconds passed. nothing can arrive without a
+    // window, so headless this just sleeps.
+    void waitEvents(double timeout) const
     {
+        if (!m_handle) {
+            std::this_thread::sleep_for(std::chrono::duration<double>(timeout));
+            return;
+        }
+
+        glfwWaitEventsTimeout(timeout);
+    }
+
+    void setSwapInterval(int interval)
+    {
+        if (m_handle && !m_headless) {
+            glfwSwapInterval(interval);
+        }
+        m_swapInterval = interval;
+        m_nextVblank = std::chrono::steady_clock::now();
+    }
+
+    void swapBuffers()
+    {
+        if (m_headless) {
+            // stands in for the throttling a real swap does, frames must not queue up unbounded
+            glFinish();
+
+            // no display to sync to, wait for the next vblank of a 60 Hz one
+            if (m_swapInterval > 0) {
+                auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(m_swapInterval / 60.0));
+                auto now = std::chrono::steady_clock::now();
+                while (m_nextVblank <= now) {
+                    m_nextVblank += period;
+                }
+                std::this_thread::sleep_until(m_nextVblank);
+            }
+            return;
+        }
+
         glfwSwapBuffers(m_handle);
     }
 
     void shutdown()
     {
+        m_context.shutdown();
         glfwTerminate();
     }
 
+    // invisible 1x1 window whose context shares objects with the main one, for a loader
+    // thread. not available with the surfaceless headless context.
+    GLFWwindow* createSharedContext()
+    {
+        if (!m_handle) {
+            return nullptr;
+        }
+
+        setHints();
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        GLFWwindow* shared = glfwCreateWindow(1, 1, "", NULL, m_handle);
+        glfwDefaultWindowHints();
+        return shared;
+    }
+
     GLFWwindow* get()
     {
         return m_handle;
@@ -92,8 +219,31 @@ struct Window {
         auto self = (Window*)glfwGetWindowUserPointer(window);
         self->m_width = width;
         self->m_height = height;
+        self->m_events++;
         glViewport(0, 0, width, height);
     }
+
+    static void countEvent(GLFWwindow* window)
+    {
+        if (auto self = (Window*)glfwGetWindowUserPointer(window)) {
+            self->m_events++;
+        }
+    }
+
+    // count every event that can change what is drawn. installed before the gui, whose
+    // callbacks chain to these.
+    void installEventCallbacks()
+    {
+        glfwSetWindowUserPointer(m_handle, this);
+        glfwSetCursorPosCallback(m_handle, [](GLFWwindow* w, double, double) { countEvent(w); });
+        glfwSetMouseButtonCallback(m_handle, [](GLFWwindow* w, int, int, int) { countEvent(w); });
+        glfwSetScrollCallback(m_handle, [](GLFWwindow* w, double, double) { countEvent(w); });
+        glfwSetKeyCallback(m_handle, [](GLFWwindow* w, int, int, int, int) { countEvent(w); });
+        glfwSetCharCallback(m_handle, [](GLFWwindow* w, unsigned int) { countEvent(w); });
+        glfwSetWindowFocusCallback(m_handle, [](GLFWwindow* w, int) { countEvent(w); });
+        glfwSetCursorEnterCallback(m_handle, [](GLFWwindow* w, int) { countEvent(w); });
+        glfwSetWindowRefreshCallback(m_handle, [](GLFWwindow* w) { countEvent(w); });
+    }
 };
 
 #endif // WINDOW_H
@@ -0,0 +1,190 @@
+// offline asset cooker: converts OBJ/PLY meshes into upload-ready vertex and index blobs and
+// packs them together with text files (shader sources) into one archive for AssetPack.
+//
+//   pyramid_cook -o assets.pack shaders/vertex.glsl shaders/fragment.glsl bunny=bunny.ply
+
+#include "asset_pack.h"
+#include "mesh_loader.h"
+#include "vertex_layout.h"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+struct CookedEntry {
+    PackEntry entry {};
+    std::vector<uint8_t> blob;
+};
+
+static bool setName(PackEntry& entry, const std::string& name)
+{
+    if (name.size() >= sizeof(entry.name)) {
+        fprintf(stderr, "err: entry name too long: %s\n", name.c_str());
+        return false;
+    }
+    memcpy(entry.name, name.c_str(), name.size() + 1);
+    return true;
+}
+
+static bool cookMesh(const std::string& name, const std::string& path, CookedEntry& out)
+{
+    std::vector<Vertex> vertices;
+    std::vector<GLuint> indices;
+    if (!MeshLoader::load(path, vertices, indices)) {
+        return false;
+    }
+
+    std::vector<uint8_t> packedIndices;
+    GLenum indexType = packIndices(indices, vertices.size(), packedIndices);
+
+    Aabb bounds = Aabb::fromVertices(vertices);
+
+    PackMesh mesh {};
+    mesh.vertexCount = (uint32_t)vertices.size();
+    mesh.indexCount = (uint32_t)indices.size();
+    mesh.vertexStride = sizeof(Vertex);
+    mesh.indexType = indexType;
+    memcpy(mesh.boundsMin, &bounds.min, sizeof(mesh.boundsMin));
+    memcpy(mesh.boundsMax, &bounds.max, sizeof(mesh.boundsMax));
+    mesh.vertexOffset = packAlign(sizeof(PackMesh));
+    mesh.vertexBytes = vertices.size() * sizeof(Vertex);
+    mesh.indexOffset = packAlign(mesh.vertexOffset + mesh.vertexBytes);
+    mesh.indexBytes = packedIndices.size();
+
+    out.blob.assign(mesh.indexOffset + mesh.indexBytes, 0);
+    memcpy(out.blob.data(), &mesh, sizeof(mesh));
+    memcpy(out.blob.data() + mesh.vertexOffset, vertices.data(), mesh.vertexBytes);
+    memcpy(out.blob.data() + mesh.indexOffset, packedIndices.data(), mesh.indexBytes);
+
+    out.entry.type = PackEntryMesh;
+    printf("mesh %s: %u vertices, %u triangles, %d byte indices\n", name.c_str(), mesh.vertexCount, mesh.indexCount / 3, indexSize(indexType));
+    return setName(out.entry, name);
+}
+
+static bool cookText(const std::string& path, CookedEntry& out)
+{
+    auto text = File::readFile(path);
+    if (!text.has_value()) {
+        fprintf(stderr, "err: failed to read %s\n", path.c_str());
+        return false;
+    }
+
+    out.blob.assign(text->begin(), text->end());
+    out.entry.type = PackEntryText;
+    printf("text %s: %zu bytes\n", path.c_str(), out.blob.size());
+    return setName(out.entry, path);
+}
+
+static void usage(const char* program)
+{
+    fprintf(stderr,
+        "usage: %s -o PACK INPUT...\n"
+        "  NAME=PATH.obj|ply    cook a mesh stored as NAME\n"
+        "  PATH.obj|ply         cook a mesh named after the file, without extension\n"
+        "  PATH                 store a text file (e.g. a shader) under PATH\n",
+        program);
+}
+
+int main(int argc, char** argv)
+{
+    std::string output;
+    std::vector<CookedEntry> cooked;
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-o" && i + 1 < argc) {
+            output = argv[++i];
+            continue;
+        }
+        if (arg == "-h" || arg == "--help") {
+            usage(argv[0]);
+            return EXIT_SUCCESS;
+        }
+
+        std::string ext = arg.size() >= 4 ? arg.substr(arg.size() - 4) : "";
+        for (char& c : ext) {
+            c = (char)tolower((unsigned char)c);
+        }
+
+        CookedEntry entry;
+        if (ext == ".obj" || ext == ".ply") {
+            size_t eq = arg.find('=');
+            std::string path = eq == std::string::npos ? arg : arg.substr(eq + 1);
+            std::string name = eq != std::string::npos ? arg.substr(0, eq) : path;
+            if (eq == std::string::npos) {
+                size_t slash = name.find_last_of("/\\");
+                name = name.substr(slash == std::string::npos ? 0 : slash + 1);
+                name.resize(name.size() - 4);
+            }
+
+            if (!cookMesh(name, path, entry)) {
+                return EXIT_FAILURE;
+            }
+        } else if (!cookText(arg, entry)) {
+            return EXIT_FAILURE;
+        }
+        for (const auto& c : cooked) {
+            if (c.entry.type == entry.entry.type && !strcmp(c.entry.name, entry.entry.name)) {
+                fprintf(stderr, "err: duplicate entry %s\n", entry.entry.name);
+                return EXIT_FAILURE;
+            }
+        }
+        cooked.push_back(std::move(entry));
+    }
+
+    if (output.empty() || cooked.empty()) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // header, aligned blobs, then the entry table
+    PackHeader header {};
+    header.magic = packMagic;
+    header.version = packVersion;
+    header.entryCount = (uint32_t)cooked.size();
+
+    uint64_t offset = packAlign(sizeof(PackHeader));
+    for (auto& c : cooked) {
+        c.entry.offset = offset;
+        c.entry.size = c.blob.size();
+        offset = packAlign(offset + c.blob.size());
+    }
+    header.entriesOffset = offset;
+
+    FILE* file = fopen(output.c_str(), "wb");
+    if (!file) {
+        fprintf(stderr, "err: failed to open %s for writing\n", output.c_str());
+        return EXIT_FAILURE;
+    }
+
+    static const uint8_t zeros[packAlignment] = {};
+    auto padTo = [&](uint64_t target) {
+        long pos = ftell(file);
+        if (pos >= 0 && (uint64_t)pos < target) {
+            fwrite(zeros, 1, target - pos, file);
+        }
+    };
+
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    for (const auto& c : cooked) {
+        padTo(c.entry.offset);
+        ok &= c.blob.empty() || fwrite(c.blob.data(), c.blob.size(), 1, file) == 1;
+    }
+    padTo(header.entriesOffset);
+    for (const auto& c : cooked) {
+        ok &= fwrite(&c.entry, sizeof(PackEntry), 1, file) == 1;
+    }
+    ok &= fclose(file) == 0;
+
+    if (!ok) {
+        fprintf(stderr, "err: failed to write %s\n", output.c_str());
+        return EXIT_FAILURE;
+    }
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    printf("wrote %s: %zu entries, %.2f MB in %.1f ms\n", output.c_str(), cooked.size(), (header.entriesOffset + cooked.size() * sizeof(PackEntry)) / (1024.0 * 1024.0), ms);
+    return EXIT_SUCCESS;
+}
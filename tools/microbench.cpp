@@ -0,0 +1,604 @@
+// cpu microbenchmarks of the engine hot paths, timed in isolation without a gl context.
+// every case reports time and heap allocations per op, cases of one group are variants of
+// the same work (reused vs fresh storage, contiguous vs scattered data) listed side by side.
+//
+//   pyramid_bench [--filter TEXT] [--min-ms N] [--threads N] [--json PATH]
+
+#include "file.h"
+#include "job_system.h"
+#include "math_kernels.h"
+#include "mesh_gen.h"
+#include "scene_graph.h"
+#include "vertex_layout.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <glm/gtc/matrix_transform.hpp>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// every heap allocation of the process goes through here, the harness reads the counter
+// around the timed loop
+static std::atomic<uint64_t> allocations { 0 };
+
+static void* countedAlloc(size_t size, size_t alignment)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    size = size ? size : 1;
+    if (alignment <= __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+        return malloc(size);
+    }
+#if defined(_MSC_VER)
+    return _aligned_malloc(size, alignment);
+#else
+    return aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+#endif
+}
+
+static void alignedFree(void* p)
+{
+#if defined(_MSC_VER)
+    _aligned_free(p);
+#else
+    free(p);
+#endif
+}
+
+void* operator new(size_t size)
+{
+    if (void* p = countedAlloc(size, 0)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size, std::align_val_t alignment)
+{
+    if (void* p = countedAlloc(size, (size_t)alignment)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return countedAlloc(size, 0); }
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return countedAlloc(size, (size_t)alignment);
+}
+
+// gcc pairs the free below with the replaced operator new and warns, the pairing is ours to make
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { free(p); }
+void operator delete(void* p, std::align_val_t alignment) noexcept
+{
+    (size_t)alignment <= __STDCPP_DEFAULT_NEW_ALIGNMENT__ ? free(p) : alignedFree(p);
+}
+void operator delete(void* p, size_t, std::align_val_t alignment) noexcept { operator delete(p, alignment); }
+void operator delete(void* p, std::align_val_t alignment, const std::nothrow_t&) noexcept { operator delete(p, alignment); }
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+// keeps the compiler from dropping a result nobody reads
+template <typename T>
+static void keep(T& value)
+{
+#if defined(_MSC_VER)
+    volatile void* sink = &value;
+    (void)sink;
+#else
+    asm volatile("" : : "g"(&value) : "memory");
+#endif
+}
+
+struct BenchCase {
+    std::string name;
+    uint64_t ops = 0;
+    double nsPerOp = 0.0;
+    double allocsPerOp = 0.0;
+    double itemsPerOp = 0.0; // vertices, matrices, bytes... 0 when an op is a single item
+    double bytesPerOp = 0.0; // for throughput, 0 when not meaningful
+};
+
+struct Harness {
+    std::string filter;
+    double minMs = 200.0;
+    std::vector<BenchCase> results;
+
+    // doubles the batch until one takes at least minMs, the last batch is reported
+    template <typename F>
+    void run(const std::string& name, double items, double bytes, F&& op)
+    {
+        if (!filter.empty() && name.find(filter) == std::string::npos) {
+            return;
+        }
+
+        op(); // warm caches and lazily grown storage
+
+        uint64_t batch = 1;
+        while (true) {
+            uint64_t allocStart = allocations.load(std::memory_order_relaxed);
+            auto start = std::chrono::steady_clock::now();
+            for (uint64_t i = 0; i < batch; i++) {
+                op();
+            }
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            uint64_t allocs = allocations.load(std::memory_order_relaxed) - allocStart;
+
+            if (ms >= minMs || batch >= (1ull << 40)) {
+                BenchCase c;
+                c.name = name;
+                c.ops = batch;
+                c.nsPerOp = ms * 1e6 / batch;
+                c.allocsPerOp = (double)allocs / batch;
+                c.itemsPerOp = items;
+                c.bytesPerOp = bytes;
+                print(c);
+                results.push_back(c);
+                return;
+            }
+            batch = ms > 0.0 ? std::max(batch * 2, (uint64_t)(batch * minMs / ms * 1.2)) : batch * 16;
+        }
+    }
+
+    static void header(const char* group)
+    {
+        printf("\n%-40s %12s %12s %10s %10s\n", group, "ns/op", "ns/item", "allocs/op", "MB/s");
+    }
+
+    static void print(const BenchCase& c)
+    {
+        char perItem[32] = "-";
+        char throughput[32] = "-";
+        if (c.itemsPerOp > 0.0) {
+            snprintf(perItem, sizeof(perItem), "%.2f", c.nsPerOp / c.itemsPerOp);
+        }
+        if (c.bytesPerOp > 0.0) {
+            snprintf(throughput, sizeof(throughput), "%.1f", c.bytesPerOp / c.nsPerOp * 1e9 / (1024.0 * 1024.0));
+        }
+        printf("  %-38s %12.1f %12s %10.2f %10s\n", c.name.c_str(), c.nsPerOp, perItem, c.allocsPerOp, throughput);
+        fflush(stdout);
+    }
+
+    bool writeJson(const std::string& path) const
+    {
+        FILE* file = fopen(path.c_str(), "w");
+        if (!file) {
+            fprintf(stderr, "err: failed to open %s\n", path.c_str());
+            return false;
+        }
+
+        fprintf(file, "{\n");
+        fprintf(file, "  \"simd\": \"%s\",\n", simdLevelNames[MathKernels::level]);
+#ifdef NDEBUG
+        fprintf(file, "  \"optimized\": true,\n");
+#else
+        fprintf(file, "  \"optimized\": false,\n");
+#endif
+        fprintf(file, "  \"cases\": [\n");
+        for (size_t i = 0; i < results.size(); i++) {
+            const BenchCase& c = results[i];
+            fprintf(file, "    { \"name\": \"%s\", \"ops\": %llu, \"nsPerOp\": %.3f, \"allocsPerOp\": %.3f, \"itemsPerOp\": %.0f, \"bytesPerOp\": %.0f }%s\n",
+                c.name.c_str(), (unsigned long long)c.ops, c.nsPerOp, c.allocsPerOp, c.itemsPerOp, c.bytesPerOp,
+                i + 1 < results.size() ? "," : "");
+        }
+        fprintf(file, "  ]\n}\n");
+        fclose(file);
+        return true;
+    }
+};
+
+// transforms of `count` objects laid out like the scene graph keeps them
+struct TransformSet {
+    std::vector<glm::vec3> t, r, s;
+    std::vector<glm::mat4> local;
+    std::vector<uint32_t> shuffled; // visiting order with no locality
+
+    explicit TransformSet(size_t count)
+    {
+        std::mt19937 rng(1234);
+        std::uniform_real_distribution<float> pos(-1000.0f, 1000.0f), angle(-180.0f, 180.0f), scale(0.5f, 2.0f);
+        for (size_t i = 0; i < count; i++) {
+            t.push_back({ pos(rng), pos(rng), pos(rng) });
+            r.push_back({ angle(rng), angle(rng), angle(rng) });
+            s.push_back(glm::vec3(scale(rng)));
+            local.push_back(composeTrs(t[i], r[i], s[i]));
+            shuffled.push_back((uint32_t)i);
+        }
+        std::shuffle(shuffled.begin(), shuffled.end(), rng);
+    }
+};
+
+// a pointer-linked node per object, what the transforms cost without the flat arrays
+struct HeapNode {
+    glm::vec3 t, r, s;
+    glm::mat4 world;
+    char payload[128]; // name, parent links and the rest of a typical node
+};
+
+static void benchGrid(Harness& h)
+{
+    Harness::header("grid lines (generateGridLines)");
+    const glm::vec4 color(0.7f, 0.7f, 0.7f, 1.0f);
+    for (int size : { 10, 100, 1000, 10000 }) {
+        double vertices = (2.0 * size + 1) * 4;
+        double bytes = vertices * (sizeof(Vertex) + sizeof(GLuint));
+
+        std::vector<Vertex> v;
+        std::vector<GLuint> i;
+        h.run("grid/reused/" + std::to_string(size), vertices, bytes, [&] {
+            generateGridLines(v, i, size, 20.0f, color);
+            keep(v);
+        });
+        h.run("grid/fresh/" + std::to_string(size), vertices, bytes, [&] {
+            std::vector<Vertex> fv;
+            std::vector<GLuint> fi;
+            generateGridLines(fv, fi, size, 20.0f, color);
+            keep(fv);
+        });
+    }
+}
+
+static void benchCompose(Harness& h)
+{
+    Harness::header("model matrix composition (composeTrs)");
+    for (size_t count : { 1024u, 262144u }) {
+        TransformSet set(count);
+        std::vector<glm::mat4> out(count);
+        std::string n = std::to_string(count);
+
+        h.run("compose/batch-" + std::string(simdLevelNames[MathKernels::level]) + "/" + n, (double)count, 0.0, [&] {
+            MathKernels::composeTrs(set.t.data(), set.r.data(), set.s.data(), out.data(), count);
+            keep(out);
+        });
+        h.run("compose/loop/" + n, (double)count, 0.0, [&] {
+            for (size_t i = 0; i < count; i++) {
+                out[i] = composeTrs(set.t[i], set.r[i], set.s[i]);
+            }
+            keep(out);
+        });
+        h.run("compose/shuffled/" + n, (double)count, 0.0, [&] {
+            for (uint32_t i : set.shuffled) {
+                out[i] = composeTrs(set.t[i], set.r[i], set.s[i]);
+            }
+            keep(out);
+        });
+
+        std::vector<std::unique_ptr<HeapNode>> nodes;
+        for (size_t i = 0; i < count; i++) {
+            nodes.push_back(std::make_unique<HeapNode>());
+            nodes.back()->t = set.t[i];
+            nodes.back()->r = set.r[i];
+            nodes.back()->s = set.s[i];
+        }
+        std::vector<HeapNode*> order;
+        for (uint32_t i : set.shuffled) {
+            order.push_back(nodes[i].get());
+        }
+        h.run("compose/heap-nodes/" + n, (double)count, 0.0, [&] {
+            for (HeapNode* node : order) {
+                node->world = composeTrs(node->t, node->r, node->s);
+            }
+            keep(order);
+        });
+    }
+}
+
+static void benchMvp(Harness& h)
+{
+    Harness::header("mvp multiplication (view projection * model)");
+    glm::mat4 vp = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 5000.0f)
+        * glm::lookAt(glm::vec3(1000.0f, 500.0f, 500.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+    for (size_t count : { 1024u, 262144u }) {
+        TransformSet set(count);
+        std::vector<glm::mat4> out(count);
+        std::string n = std::to_string(count);
+        double bytes = count * 2.0 * sizeof(glm::mat4);
+
+        h.run("mvp/batch-" + std::string(simdLevelNames[MathKernels::level]) + "/" + n, (double)count, bytes, [&] {
+            MathKernels::mulMat4(vp, set.local.data(), out.data(), count);
+            keep(out);
+        });
+        h.run("mvp/glm-loop/" + n, (double)count, bytes, [&] {
+            for (size_t i = 0; i < count; i++) {
+                out[i] = vp * set.local[i];
+            }
+            keep(out);
+        });
+        h.run("mvp/shuffled/" + n, (double)count, bytes, [&] {
+            for (uint32_t i : set.shuffled) {
+                out[i] = vp * set.local[i];
+            }
+            keep(out);
+        });
+    }
+}
+
+static void benchAabb(Harness& h)
+{
+    Harness::header("bounds transform (Aabb::transformed)");
+    Aabb box { glm::vec3(-50.0f, 0.0f, -50.0f), glm::vec3(50.0f, 100.0f, 50.0f) };
+
+    for (size_t count : { 1024u, 262144u }) {
+        TransformSet set(count);
+        std::vector<Aabb> out(count);
+        std::string n = std::to_string(count);
+
+        h.run("aabb/batch-" + std::string(simdLevelNames[MathKernels::level]) + "/" + n, (double)count, 0.0, [&] {
+            MathKernels::transformAabb(box, set.local.data(), out.data(), count);
+            keep(out);
+        });
+        h.run("aabb/loop/" + n, (double)count, 0.0, [&] {
+            for (size_t i = 0; i < count; i++) {
+                out[i] = box.transformed(set.local[i]);
+            }
+            keep(out);
+        });
+    }
+}
+
+static void benchPacking(Harness& h)
+{
+    Harness::header("vertex packing (256x256 sphere)");
+    std::vector<Vertex> vertices;
+    std::vector<GLuint> indices;
+    generateSphere(vertices, indices, 100.0f, 256, 256);
+    double count = (double)vertices.size();
+    double bytes = count * sizeof(Vertex);
+
+    h.run("pack/quantization-bounds", count, bytes, [&] {
+        PositionQuantization q = PositionQuantization::fromBounds(vertices);
+        keep(q);
+    });
+
+    PositionQuantization q = PositionQuantization::fromBounds(vertices);
+    std::vector<VertexSnorm16> snorm;
+    std::vector<VertexHalf> half;
+    h.run("pack/snorm16/reused", count, bytes, [&] {
+        packVertices(vertices, q, snorm);
+        keep(snorm);
+    });
+    h.run("pack/snorm16/fresh", count, bytes, [&] {
+        std::vector<VertexSnorm16> out;
+        packVertices(vertices, q, out);
+        keep(out);
+    });
+    h.run("pack/half/reused", count, bytes, [&] {
+        packVertices(vertices, q, half);
+        keep(half);
+    });
+    h.run("pack/half/fresh", count, bytes, [&] {
+        std::vector<VertexHalf> out;
+        packVertices(vertices, q, out);
+        keep(out);
+    });
+
+    std::vector<uint8_t> packed;
+    h.run("pack/indices", (double)indices.size(), indices.size() * sizeof(GLuint), [&] {
+        GLenum type = packIndices(indices, vertices.size(), packed);
+        keep(type);
+    });
+}
+
+static void benchReadFile(Harness& h)
+{
+    Harness::header("file reads (File::readFile)");
+    for (size_t size : { 64u << 10, 16u << 20 }) {
+        std::string path = "pyramid_bench_" + std::to_string(size) + ".tmp";
+        {
+            std::vector<char> data(size);
+            for (size_t i = 0; i < size; i++) {
+                data[i] = (char)('a' + i % 26);
+            }
+            FILE* file = fopen(path.c_str(), "wb");
+            if (!file || fwrite(data.data(), 1, size, file) != size) {
+                fprintf(stderr, "err: failed to write %s\n", path.c_str());
+                if (file) {
+                    fclose(file);
+                }
+                return;
+            }
+            fclose(file);
+        }
+
+        std::string n = std::to_string(size >> 10) + "k";
+        h.run("read/readFile/" + n, 0.0, (double)size, [&] {
+            auto text = File::readFile(path);
+            keep(text);
+        });
+        h.run("read/ifstream-iterator/" + n, 0.0, (double)size, [&] {
+            std::ifstream in(path, std::ios::binary);
+            std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            keep(text);
+        });
+
+        remove(path.c_str());
+    }
+}
+
+// the job system users at 1 to `maxThreads` threads, the caller counts as one. the speedup is
+// against the serial loop, past the core count the threads only time-slice.
+static void benchJobs(Harness& h, int maxThreads)
+{
+    Harness::header("job system scaling (parallelFor)");
+    const size_t count = 262144;
+    TransformSet set(count);
+    std::vector<glm::mat4> out(count);
+
+    // one parent with an instance child per object, every node dirty, what a full lattice
+    // rebuild costs the update stage
+    SceneGraph graph;
+    SceneNode root = graph.create("root");
+    graph.reserve(count + 1);
+    for (size_t i = 0; i < count; i++) {
+        graph.create("", root, set.t[i], set.r[i], set.s[i]);
+    }
+
+    struct Workload {
+        const char* name;
+        double items;
+        std::function<void(JobSystem*)> op;
+    };
+    std::vector<Vertex> vertices;
+    std::vector<GLuint> indices;
+    const Workload workloads[] = {
+        { "compose", (double)count, [&](JobSystem* jobs) {
+             parallelFor(jobs, 0, count, 2048, [&](size_t first, size_t last) {
+                 MathKernels::composeTrs(&set.t[first], &set.r[first], &set.s[first], &out[first], last - first);
+             });
+             keep(out);
+         } },
+        { "scene-update", (double)count, [&](JobSystem* jobs) {
+             graph.markDirty(root);
+             for (SceneNode node = root + 1; node < graph.size(); node++) {
+                 graph.markDirty(node);
+             }
+             size_t updated = graph.update(jobs);
+             keep(updated);
+         } },
+        { "sphere-256", 257.0 * 257.0, [&](JobSystem* jobs) {
+             generateSphere(vertices, indices, 100.0f, 256, 256, jobs);
+             keep(vertices);
+         } },
+    };
+
+    for (const Workload& w : workloads) {
+        std::string name = std::string("jobs/") + w.name + "/";
+        size_t serial = h.results.size();
+        h.run(name + "serial", w.items, 0.0, [&] { w.op(nullptr); });
+        {
+            JobSystem jobs;
+            jobs.init(0, true);
+            h.run(name + "inline", w.items, 0.0, [&] { w.op(&jobs); });
+        }
+        for (int threads = 1; threads <= maxThreads; threads++) {
+            JobSystem jobs;
+            jobs.init(threads - 1);
+            h.run(name + std::to_string(threads) + "t", w.items, 0.0, [&] { w.op(&jobs); });
+        }
+
+        if (h.results.size() > serial + 2) {
+            printf("  %-38s", "speedup over serial (1t, 2t, ...)");
+            for (size_t i = serial + 2; i < h.results.size(); i++) {
+                printf(" %.2fx", h.results[serial].nsPerOp / h.results[i].nsPerOp);
+            }
+            printf("\n");
+        }
+    }
+
+    // scheduling cost of a job that does nothing, spawned from outside the pool
+    for (int threads : { 1, maxThreads }) {
+        JobSystem jobs;
+        jobs.init(threads - 1);
+        h.run("jobs/spawn-wait-1000/" + std::to_string(threads) + "t", 1000.0, 0.0, [&] {
+            JobCounter counter;
+            for (int i = 0; i < 1000; i++) {
+                jobs.spawn([] {}, counter);
+            }
+            jobs.wait(counter);
+        });
+        if (maxThreads == 1) {
+            break;
+        }
+    }
+}
+
+static void usage(const char* program)
+{
+    fprintf(stderr,
+        "usage: %s [options]\n"
+        "  --filter TEXT        only run cases whose name contains TEXT\n"
+        "  --min-ms N           time each case for at least N ms (200)\n"
+        "  --simd L             cap the math kernels at scalar, sse or avx2 (best available)\n"
+        "  --threads N          job system scaling up to N threads (hardware threads, at least 4)\n"
+        "  --json PATH          also write the results as json\n",
+        program);
+}
+
+int main(int argc, char** argv)
+{
+    Harness h;
+    std::string json;
+    int maxThreads = std::max(4, (int)std::thread::hardware_concurrency());
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (arg == "--filter" && value) {
+            h.filter = value;
+            i++;
+        } else if (arg == "--min-ms" && value) {
+            h.minMs = atof(value);
+            i++;
+        } else if (arg == "--threads" && value) {
+            maxThreads = std::max(1, atoi(value));
+            i++;
+        } else if (arg == "--json" && value) {
+            json = value;
+            i++;
+        } else if (arg == "--simd" && value) {
+            std::string level = value;
+            if (level == "scalar") {
+                MathKernels::setLevel(SimdScalar);
+            } else if (level == "sse") {
+                MathKernels::setLevel(SimdSse);
+            } else if (level == "avx2") {
+                MathKernels::setLevel(SimdAvx2);
+            } else {
+                fprintf(stderr, "err: unknown simd level %s\n", value);
+                return EXIT_FAILURE;
+            }
+            i++;
+        } else if (arg == "-h" || arg == "--help") {
+            usage(argv[0]);
+            return EXIT_SUCCESS;
+        } else {
+            fprintf(stderr, "err: unknown option %s\n", arg.c_str());
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (h.minMs <= 0.0) {
+        fprintf(stderr, "err: --min-ms must be positive\n");
+        return EXIT_FAILURE;
+    }
+
+#ifndef NDEBUG
+    printf("warn: unoptimized build, configure with -DCMAKE_BUILD_TYPE=Release for representative numbers\n");
+#endif
+    printf("math kernels: %s, hardware threads: %u\n", simdLevelNames[MathKernels::level], std::thread::hardware_concurrency());
+
+    benchGrid(h);
+    benchCompose(h);
+    benchMvp(h);
+    benchAabb(h);
+    benchPacking(h);
+    benchReadFile(h);
+    benchJobs(h, maxThreads);
+
+    if (!json.empty()) {
+        if (!h.writeJson(json)) {
+            return EXIT_FAILURE;
+        }
+        printf("\nwrote %s\n", json.c_str());
+    }
+    return EXIT_SUCCESS;
+}